@@ -6,9 +6,15 @@
 #define AST_H_
 
 #include <memory>
+#include <optional>
 #include <vector>
+#include <utility>
+#include <type_traits>
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/IR/Value.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/ErrorHandling.h"
 
 #include "type.h"
 #include "lexer.h"
@@ -22,6 +28,11 @@ class BlockStmt;
 class ForStmt;
 class BreakStmt;
 class ContinueStmt;
+class SwitchStmt;
+class CaseStmt;
+class LabelStmt;
+class GotoStmt;
+class IndirectGotoStmt;
 
 class UnaryExpr;
 class BinaryExpr;
@@ -31,6 +42,7 @@ class NumberExpr;
 class VariableAccessExpr;
 class VariableDecl;
 class SizeofExpr;
+class AddrLabelExpr;
 
 class PostIncExpr;
 class PostDecExpr;
@@ -44,41 +56,6 @@ class FuncDecl;
 class PostFuncCallExpr;
 class ReturnStmt;
 
-class Visitor {
- public:
-    virtual ~Visitor() {}
-
-    virtual llvm::Value* VisitProgram(Program*) = 0;
-
-    virtual llvm::Value* VisitDeclStmt(DeclStmt*) = 0;
-    virtual llvm::Value* VisitBlockStmt(BlockStmt*) = 0;
-    virtual llvm::Value* VisitIfStmt(IfStmt*) = 0;
-    virtual llvm::Value* VisitForStmt(ForStmt*) = 0;
-    virtual llvm::Value* VisitBreakStmt(BreakStmt*) = 0;
-    virtual llvm::Value* VisitContinueStmt(ContinueStmt*) = 0;
-
-    virtual llvm::Value* VisitUnaryExpr(UnaryExpr*) = 0;
-    virtual llvm::Value* VisitBinaryExpr(BinaryExpr*) = 0;
-    virtual llvm::Value* VisitTernaryExpr(TernaryExpr*) = 0;
-
-    virtual llvm::Value* VisitNumberExpr(NumberExpr*) = 0;
-    virtual llvm::Value* VisitVariableAccessExpr(VariableAccessExpr*) = 0;
-    virtual llvm::Value* VisitVariableDecl(VariableDecl*) = 0;
-    virtual llvm::Value* VisitSizeofExpr(SizeofExpr*) = 0;
-
-    virtual llvm::Value* VisitPostIncExpr(PostIncExpr*) = 0;
-    virtual llvm::Value* VisitPostDecExpr(PostDecExpr*) = 0;
-
-    virtual llvm::Value* VisitPostSubscript(PostSubscriptExpr*) = 0;
-    
-    virtual llvm::Value* VisitPostMemberDotExpr(PostMemberDotExpr*) = 0;
-    virtual llvm::Value* VisitPostMemberArrowExpr(PostMemberArrowExpr*) = 0;
-
-    virtual llvm::Value* VisitFuncDecl(FuncDecl*) = 0;
-    virtual llvm::Value* VisitPostFuncCallExpr(PostFuncCallExpr*) = 0;
-    virtual llvm::Value* VisitReturnStmt(ReturnStmt*) = 0;
-};
-
 class AstNode {
  public:
     enum class AstNodeKind {
@@ -88,6 +65,11 @@ class AstNode {
         kForStmt,
         kBreakStmt,
         kContinueStmt,
+        kSwitchStmt,
+        kCaseStmt,
+        kLabelStmt,
+        kGotoStmt,
+        kIndirectGotoStmt,
 
         kUnaryExpr,
         kBinaryExpr,
@@ -97,6 +79,7 @@ class AstNode {
         kNumberExpr,
         kVariableAccessExpr,
         kSizeof,
+        kAddrLabelExpr,
 
         kPostIncExpr,
         kPostDecExpr,
@@ -121,6 +104,10 @@ class AstNode {
     // An rvalue can only be evaluated.
     bool is_lvalue_ { false };
 
+    // The value of an integer constant expression, which is folded by sema,
+    // so that the nodes using it don't need to evaluate it again.
+    std::optional<int> constant_value_;
+
  public:
     explicit AstNode(AstNodeKind node_kind) : node_kind_(node_kind) {}
 
@@ -154,28 +141,72 @@ class AstNode {
         is_lvalue_ = flag;
     }
 
-    virtual llvm::Value* Accept(Visitor* vis) = 0;
+    std::optional<int> GetConstantValue() const {
+        return constant_value_;
+    }
+
+    void SetConstantValue(std::optional<int> value) {
+        constant_value_ = value;
+    }
 };
 
 class Program {
+ private:
+    // All the AST nodes of a program, as well as their child lists,
+    // are allocated in this arena and released together with the program.
+    llvm::BumpPtrAllocator allocator_;
+
+    // The arena never runs destructors by itself, so we remember the objects
+    // owning resources (e.g. the `std::shared_ptr<CType>` in each node),
+    // and destroy them manually when the program is released.
+    std::vector<std::pair<void*, void (*)(void*)>> destructors_;
+
  public:
     llvm::StringRef file_name_;
 
     // A program consists of serveral external declaration,
     // including functions, global variables...
-    std::vector<std::shared_ptr<AstNode>> nodes_;
+    std::vector<AstNode*> nodes_;
+
+    Program() = default;
+    Program(const Program&) = delete;
+    Program& operator=(const Program&) = delete;
+
+    ~Program() {
+        for (auto iter = destructors_.rbegin(); iter != destructors_.rend(); ++iter) {
+            iter->second(iter->first);
+        }
+    }
+
+    template <typename T, typename... Args>
+    T* Create(Args&&... args) {
+        void* mem = allocator_.Allocate(sizeof(T), alignof(T));
+        T* object = new (mem) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            destructors_.emplace_back(object, [](void* p) { static_cast<T*>(p)->~T(); });
+        }
+        return object;
+    }
+
+    // Copy a temporary list (e.g. the children collected by parser) into the arena.
+    template <typename T>
+    llvm::ArrayRef<T> CopyArray(llvm::ArrayRef<T> array) {
+        static_assert(std::is_trivially_destructible_v<T>);
+        if (array.empty()) {
+            return {};
+        }
+        T* mem = allocator_.Allocate<T>(array.size());
+        std::uninitialized_copy(array.begin(), array.end(), mem);
+        return llvm::ArrayRef<T>(mem, array.size());
+    }
 };
 
 class DeclStmt : public AstNode {
  public:
-    std::vector<std::shared_ptr<AstNode>> nodes_;
+    llvm::ArrayRef<AstNode*> nodes_;
 
     DeclStmt() : AstNode(AstNodeKind::kDeclStmt) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitDeclStmt(this);
-    }
-
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kDeclStmt;
     }
@@ -183,14 +214,10 @@ class DeclStmt : public AstNode {
 
 class BlockStmt : public AstNode {
  public:
-    std::vector<std::shared_ptr<AstNode>> nodes_;
+    llvm::ArrayRef<AstNode*> nodes_;
 
     BlockStmt() : AstNode(AstNodeKind::kBlockStmt) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitBlockStmt(this);
-    }
-
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kBlockStmt;
     }
@@ -198,16 +225,12 @@ class BlockStmt : public AstNode {
 
 class IfStmt : public AstNode {
  public:
-    std::shared_ptr<AstNode> cond_node_;
-    std::shared_ptr<AstNode> then_node_;
-    std::shared_ptr<AstNode> else_node_;
+    AstNode* cond_node_ { nullptr };
+    AstNode* then_node_ { nullptr };
+    AstNode* else_node_ { nullptr };
 
     IfStmt() : AstNode(AstNodeKind::kIfStmt) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitIfStmt(this);
-    }
-
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kIfStmt;
     }
@@ -215,17 +238,13 @@ class IfStmt : public AstNode {
 
 class ForStmt : public AstNode {
  public:
-    std::shared_ptr<AstNode> init_node_;
-    std::shared_ptr<AstNode> cond_node_;
-    std::shared_ptr<AstNode> inc_node_;
-    std::shared_ptr<AstNode> body_node_;
+    AstNode* init_node_ { nullptr };
+    AstNode* cond_node_ { nullptr };
+    AstNode* inc_node_ { nullptr };
+    AstNode* body_node_ { nullptr };
 
     ForStmt() : AstNode(AstNodeKind::kForStmt) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitForStmt(this);
-    }
-
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kForStmt;
     }
@@ -233,14 +252,10 @@ class ForStmt : public AstNode {
 
 class BreakStmt : public AstNode {
  public:
-    std::shared_ptr<AstNode> target_ { nullptr };
+    AstNode* target_ { nullptr };
 
     BreakStmt() : AstNode(AstNodeKind::kBreakStmt) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitBreakStmt(this);
-    }
-
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kBreakStmt;
     }
@@ -248,24 +263,103 @@ class BreakStmt : public AstNode {
 
 class ContinueStmt : public AstNode {
  public:
-    std::shared_ptr<AstNode> target_ { nullptr };
+    AstNode* target_ { nullptr };
 
     ContinueStmt() : AstNode(AstNodeKind::kContinueStmt) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitContinueStmt(this);
+    static bool classof(const AstNode* node) {
+        return node->GetNodeKind() == AstNodeKind::kContinueStmt;
     }
+};
+
+class SwitchStmt : public AstNode {
+ public:
+    AstNode* cond_node_ { nullptr };
+    AstNode* body_node_ { nullptr };
+
+    // All the `case` and `default` labels belonging to this switch,
+    // in the order they appear in the body.
+    llvm::ArrayRef<AstNode*> case_nodes_;
+
+    SwitchStmt() : AstNode(AstNodeKind::kSwitchStmt) {}
 
     static bool classof(const AstNode* node) {
-        return node->GetNodeKind() == AstNodeKind::kContinueStmt;
+        return node->GetNodeKind() == AstNodeKind::kSwitchStmt;
+    }
+};
+
+// A `case` or `default` label, together with the statement following it.
+class CaseStmt : public AstNode {
+ public:
+    // `nullptr` for the `default` label.
+    AstNode* value_node_ { nullptr };
+    AstNode* sub_stmt_ { nullptr };
+    AstNode* target_ { nullptr };
+
+    CaseStmt() : AstNode(AstNodeKind::kCaseStmt) {}
+
+    static bool classof(const AstNode* node) {
+        return node->GetNodeKind() == AstNodeKind::kCaseStmt;
+    }
+};
+
+// A label of `goto`, together with the statement following it.
+// The label can be used in the whole function, even before it's defined.
+class LabelStmt : public AstNode {
+ public:
+    AstNode* sub_stmt_ { nullptr };
+
+    // Is `&&` applied to the label? If so, it can be the target of
+    // any `goto *expr` in the function.
+    bool is_address_taken_ { false };
+
+    LabelStmt() : AstNode(AstNodeKind::kLabelStmt) {}
+
+    llvm::StringRef GetLabelName() const {
+        return GetBoundToken().GetContent();
+    }
+
+    static bool classof(const AstNode* node) {
+        return node->GetNodeKind() == AstNodeKind::kLabelStmt;
+    }
+};
+
+class GotoStmt : public AstNode {
+ public:
+    AstNode* target_ { nullptr };
+
+    GotoStmt() : AstNode(AstNodeKind::kGotoStmt) {}
+
+    static bool classof(const AstNode* node) {
+        return node->GetNodeKind() == AstNodeKind::kGotoStmt;
     }
 };
 
+// `goto *expr`, which jumps to the label whose address is `expr`.
+class IndirectGotoStmt : public AstNode {
+ public:
+    AstNode* target_node_ { nullptr };
+
+    IndirectGotoStmt() : AstNode(AstNodeKind::kIndirectGotoStmt) {}
+
+    static bool classof(const AstNode* node) {
+        return node->GetNodeKind() == AstNodeKind::kIndirectGotoStmt;
+    }
+};
+
+// The storage class given by the specifiers of a declaration.
+enum class StorageClass {
+    kNone,
+    // `static`, the symbol can't be seen from the other modules. And a local
+    // variable declared so lives through the whole program.
+    kStatic,
+};
+
 class VariableDecl : public AstNode {
  public:
     struct InitValue {
         std::shared_ptr<CType> decl_type;
-        std::shared_ptr<AstNode> init_node;
+        AstNode* init_node { nullptr };
         // For example, 
         // `int ar[][][] = {
         //     {
@@ -284,12 +378,19 @@ class VariableDecl : public AstNode {
         //
         // Please read the comment in `Parser::ParseDirectDeclarator` method
         // to learn about the reason.
-        std::vector<int> index_list;
+        llvm::ArrayRef<int> index_list;
     };
 
-    std::vector<std::shared_ptr<InitValue>> init_values_;
+    llvm::ArrayRef<InitValue*> init_values_;
 
     bool is_global_ { false };
+    StorageClass storage_class_ { StorageClass::kNone };
+    // For a parameter like `int a[static 3]`, the least number of elements
+    // which it points to, otherwise -1.
+    int static_array_size_ { -1 };
+    // Is `&` applied to the variable? If not, its value can't be accessed
+    // through any pointer, so codegen can keep it in SSA values.
+    bool is_address_taken_ { false };
 
     VariableDecl() : AstNode(AstNodeKind::kVariableDecl) {}
 
@@ -297,10 +398,6 @@ class VariableDecl : public AstNode {
         return GetBoundToken().GetContent();
     }
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitVariableDecl(this);
-    }
-
     // Provide support for LLVM RTTI
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kVariableDecl;
@@ -329,14 +426,10 @@ enum class UnaryOpCode {
 class UnaryExpr : public AstNode {
  public:
     UnaryOpCode op_;
-    std::shared_ptr<AstNode> sub_node_;
+    AstNode* sub_node_ { nullptr };
 
     UnaryExpr() : AstNode(AstNodeKind::kUnaryExpr) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitUnaryExpr(this);
-    }
-
     // Provide support for LLVM RTTI
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kBinaryExpr;
@@ -345,18 +438,27 @@ class UnaryExpr : public AstNode {
 
 class SizeofExpr : public AstNode {
  public:
-    std::shared_ptr<AstNode> sub_node_ { nullptr };
+    AstNode* sub_node_ { nullptr };
     std::shared_ptr<CType> sub_ctype_ { nullptr };
 
     SizeofExpr() : AstNode(AstNodeKind::kSizeof) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitSizeofExpr(this);
+    // Provide support for LLVM RTTI
+    static bool classof(const AstNode* node) {
+        return node->GetNodeKind() == AstNodeKind::kSizeof;
     }
+};
+
+// `&&label`, the address of a label as a `void *` value.
+class AddrLabelExpr : public AstNode {
+ public:
+    AstNode* target_ { nullptr };
+
+    AddrLabelExpr() : AstNode(AstNodeKind::kAddrLabelExpr) {}
 
     // Provide support for LLVM RTTI
     static bool classof(const AstNode* node) {
-        return node->GetNodeKind() == AstNodeKind::kSizeof;
+        return node->GetNodeKind() == AstNodeKind::kAddrLabelExpr;
     }
 };
 
@@ -403,15 +505,11 @@ enum class BinaryOpCode {
 class BinaryExpr : public AstNode {
  public:
     BinaryOpCode op_;
-    std::shared_ptr<AstNode> left_;
-    std::shared_ptr<AstNode> right_;
+    AstNode* left_ { nullptr };
+    AstNode* right_ { nullptr };
 
     BinaryExpr() : AstNode(AstNodeKind::kBinaryExpr) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitBinaryExpr(this);
-    }
-
     // Provide support for LLVM RTTI
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kBinaryExpr;
@@ -420,16 +518,12 @@ class BinaryExpr : public AstNode {
 
 class TernaryExpr : public AstNode {
  public:
-    std::shared_ptr<AstNode> cond_;
-    std::shared_ptr<AstNode> then_;
-    std::shared_ptr<AstNode> els_;
+    AstNode* cond_ { nullptr };
+    AstNode* then_ { nullptr };
+    AstNode* els_ { nullptr };
 
     TernaryExpr() : AstNode(AstNodeKind::kTernaryExpr) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitTernaryExpr(this);
-    }
-
     // Provide support for LLVM RTTI
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kTernaryExpr;
@@ -444,10 +538,6 @@ class NumberExpr : public AstNode {
         return GetBoundToken().GetValue();
     }
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitNumberExpr(this);
-    }
-
     // Provide support for LLVM RTTI
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kNumberExpr;
@@ -456,16 +546,17 @@ class NumberExpr : public AstNode {
 
 class VariableAccessExpr : public AstNode {
  public:
+    // The declaration which the name refers to, resolved by sema.
+    // It is a `VariableDecl` for variables and parameters,
+    // or the node declaring a function.
+    AstNode* decl_ { nullptr };
+
     VariableAccessExpr() : AstNode(AstNodeKind::kVariableAccessExpr) {}
 
     llvm::StringRef GetVariableName() const {
         return GetBoundToken().GetContent();
     }
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitVariableAccessExpr(this);
-    }
-
     // Provide support for LLVM RTTI
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kVariableAccessExpr;
@@ -474,14 +565,10 @@ class VariableAccessExpr : public AstNode {
 
 class PostIncExpr : public AstNode {
  public:
-    std::shared_ptr<AstNode> sub_node_;
+    AstNode* sub_node_ { nullptr };
 
     PostIncExpr() : AstNode(AstNodeKind::kPostIncExpr) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitPostIncExpr(this);
-    }
-
     // Provide support for LLVM RTTI
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kPostIncExpr;
@@ -490,14 +577,10 @@ class PostIncExpr : public AstNode {
 
 class PostDecExpr : public AstNode {
  public:
-    std::shared_ptr<AstNode> sub_node_;
+    AstNode* sub_node_ { nullptr };
 
     PostDecExpr() : AstNode(AstNodeKind::kPostDecExpr) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitPostDecExpr(this);
-    }
-
     // Provide support for LLVM RTTI
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kPostDecExpr;
@@ -506,15 +589,11 @@ class PostDecExpr : public AstNode {
 
 class PostSubscriptExpr : public AstNode {
  public:
-    std::shared_ptr<AstNode> sub_node_;
-    std::shared_ptr<AstNode> index_node_;
+    AstNode* sub_node_ { nullptr };
+    AstNode* index_node_ { nullptr };
 
     PostSubscriptExpr() : AstNode(AstNodeKind::kPostSubscriptExpr) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitPostSubscript(this);
-    }
-
     // Provide support for LLVM RTTI
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kPostSubscriptExpr;
@@ -523,15 +602,11 @@ class PostSubscriptExpr : public AstNode {
 
 class PostMemberDotExpr : public AstNode {
  public:
-    std::shared_ptr<AstNode> struct_node_;
+    AstNode* struct_node_ { nullptr };
     CRecordType::Member target_member_;
     
     PostMemberDotExpr() : AstNode(AstNodeKind::kPostMemberDotExpr) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitPostMemberDotExpr(this);
-    }
-
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kPostMemberDotExpr;
     }
@@ -539,15 +614,11 @@ class PostMemberDotExpr : public AstNode {
 
 class PostMemberArrowExpr : public AstNode {
  public:
-    std::shared_ptr<AstNode> struct_pointer_node_;
+    AstNode* struct_pointer_node_ { nullptr };
     CRecordType::Member target_member_;
     
     PostMemberArrowExpr() : AstNode(AstNodeKind::kPostMemberArrowExpr) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitPostMemberArrowExpr(this);
-    }
-
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kPostMemberArrowExpr;
     }
@@ -555,13 +626,17 @@ class PostMemberArrowExpr : public AstNode {
 
 class FuncDecl : public AstNode {
  public:
-    std::shared_ptr<AstNode> block_stmt_ { nullptr };
+    AstNode* block_stmt_ { nullptr };
+    // The declarations of the parameters, in the same order as
+    // `CFuncType::GetParams()`.
+    llvm::ArrayRef<AstNode*> params_;
 
-    FuncDecl() : AstNode(AstNodeKind::kFuncDecl) {}
+    // Both of them are merged from the previous declarations
+    // of the same function.
+    StorageClass storage_class_ { StorageClass::kNone };
+    bool is_inline_ { false };
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitFuncDecl(this);
-    }
+    FuncDecl() : AstNode(AstNodeKind::kFuncDecl) {}
 
     static bool classof(const AstNode* node)  {
         return node->GetNodeKind() == AstNodeKind::kFuncDecl;
@@ -570,15 +645,11 @@ class FuncDecl : public AstNode {
 
 class PostFuncCallExpr : public AstNode {
  public:
-    std::shared_ptr<AstNode> func_node_;
-    std::vector<std::shared_ptr<AstNode>> arg_nodes_;
+    AstNode* func_node_ { nullptr };
+    llvm::ArrayRef<AstNode*> arg_nodes_;
 
     PostFuncCallExpr() : AstNode(AstNodeKind::kPostFuncCallExpr) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitPostFuncCallExpr(this);
-    }
-
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kPostFuncCallExpr;
     }
@@ -586,17 +657,93 @@ class PostFuncCallExpr : public AstNode {
 
 class ReturnStmt : public AstNode {
  public:
-    std::shared_ptr<AstNode> value_node_ { nullptr };
+    AstNode* value_node_ { nullptr };
 
     ReturnStmt() : AstNode(AstNodeKind::kReturnStmt) {}
 
-    llvm::Value* Accept(Visitor* vis) override {
-        return vis->VisitReturnStmt(this);
-    }
-
     static bool classof(const AstNode* node) {
         return node->GetNodeKind() == AstNodeKind::kReturnStmt;
     }
 };
 
+// A visitor which dispatches on `AstNode::AstNodeKind` with a switch,
+// instead of calling the virtual functions of each node.
+//
+// The derived class provides a `VisitXxx` method for each kind of node,
+// and they are called directly, so that they can be inlined by the compiler.
+template <typename Derived, typename RetTy = llvm::Value*>
+class StaticVisitor {
+ public:
+    RetTy Visit(AstNode* node) {
+        switch (node->GetNodeKind()) {
+            case AstNode::AstNodeKind::kDeclStmt:
+                return GetDerived()->VisitDeclStmt(static_cast<DeclStmt*>(node));
+            case AstNode::AstNodeKind::kBlockStmt:
+                return GetDerived()->VisitBlockStmt(static_cast<BlockStmt*>(node));
+            case AstNode::AstNodeKind::kIfStmt:
+                return GetDerived()->VisitIfStmt(static_cast<IfStmt*>(node));
+            case AstNode::AstNodeKind::kForStmt:
+                return GetDerived()->VisitForStmt(static_cast<ForStmt*>(node));
+            case AstNode::AstNodeKind::kBreakStmt:
+                return GetDerived()->VisitBreakStmt(static_cast<BreakStmt*>(node));
+            case AstNode::AstNodeKind::kContinueStmt:
+                return GetDerived()->VisitContinueStmt(static_cast<ContinueStmt*>(node));
+            case AstNode::AstNodeKind::kSwitchStmt:
+                return GetDerived()->VisitSwitchStmt(static_cast<SwitchStmt*>(node));
+            case AstNode::AstNodeKind::kCaseStmt:
+                return GetDerived()->VisitCaseStmt(static_cast<CaseStmt*>(node));
+            case AstNode::AstNodeKind::kLabelStmt:
+                return GetDerived()->VisitLabelStmt(static_cast<LabelStmt*>(node));
+            case AstNode::AstNodeKind::kGotoStmt:
+                return GetDerived()->VisitGotoStmt(static_cast<GotoStmt*>(node));
+            case AstNode::AstNodeKind::kIndirectGotoStmt:
+                return GetDerived()->VisitIndirectGotoStmt(static_cast<IndirectGotoStmt*>(node));
+
+            case AstNode::AstNodeKind::kUnaryExpr:
+                return GetDerived()->VisitUnaryExpr(static_cast<UnaryExpr*>(node));
+            case AstNode::AstNodeKind::kBinaryExpr:
+                return GetDerived()->VisitBinaryExpr(static_cast<BinaryExpr*>(node));
+            case AstNode::AstNodeKind::kTernaryExpr:
+                return GetDerived()->VisitTernaryExpr(static_cast<TernaryExpr*>(node));
+
+            case AstNode::AstNodeKind::kVariableDecl:
+                return GetDerived()->VisitVariableDecl(static_cast<VariableDecl*>(node));
+            case AstNode::AstNodeKind::kNumberExpr:
+                return GetDerived()->VisitNumberExpr(static_cast<NumberExpr*>(node));
+            case AstNode::AstNodeKind::kVariableAccessExpr:
+                return GetDerived()->VisitVariableAccessExpr(static_cast<VariableAccessExpr*>(node));
+            case AstNode::AstNodeKind::kSizeof:
+                return GetDerived()->VisitSizeofExpr(static_cast<SizeofExpr*>(node));
+            case AstNode::AstNodeKind::kAddrLabelExpr:
+                return GetDerived()->VisitAddrLabelExpr(static_cast<AddrLabelExpr*>(node));
+
+            case AstNode::AstNodeKind::kPostIncExpr:
+                return GetDerived()->VisitPostIncExpr(static_cast<PostIncExpr*>(node));
+            case AstNode::AstNodeKind::kPostDecExpr:
+                return GetDerived()->VisitPostDecExpr(static_cast<PostDecExpr*>(node));
+
+            case AstNode::AstNodeKind::kPostSubscriptExpr:
+                return GetDerived()->VisitPostSubscript(static_cast<PostSubscriptExpr*>(node));
+
+            case AstNode::AstNodeKind::kPostMemberDotExpr:
+                return GetDerived()->VisitPostMemberDotExpr(static_cast<PostMemberDotExpr*>(node));
+            case AstNode::AstNodeKind::kPostMemberArrowExpr:
+                return GetDerived()->VisitPostMemberArrowExpr(static_cast<PostMemberArrowExpr*>(node));
+
+            case AstNode::AstNodeKind::kFuncDecl:
+                return GetDerived()->VisitFuncDecl(static_cast<FuncDecl*>(node));
+            case AstNode::AstNodeKind::kPostFuncCallExpr:
+                return GetDerived()->VisitPostFuncCallExpr(static_cast<PostFuncCallExpr*>(node));
+            case AstNode::AstNodeKind::kReturnStmt:
+                return GetDerived()->VisitReturnStmt(static_cast<ReturnStmt*>(node));
+        }
+        llvm_unreachable("unknown kind of ast node");
+    }
+
+ private:
+    Derived* GetDerived() {
+        return static_cast<Derived*>(this);
+    }
+};
+
 #endif  // AST_H_
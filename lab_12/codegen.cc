@@ -4,73 +4,184 @@
 
 #include "codegen.h"
 
+#include <algorithm>
 #include <memory>
+#include <string>
 #include <cassert>
 
+#include "llvm/Analysis/ConstantFolding.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Verifier.h"
 
-void CodeGen::AddLocalVariable(llvm::StringRef name, llvm::Value *addr, llvm::Type *llvm_type) {
-    assert(local_variable_map_.size() > 0);
-    local_variable_map_.back().insert({ name, { addr, llvm_type } });
+void CodeGen::AddVariable(AstNode* decl, llvm::Value *addr, llvm::Type *llvm_type) {
+    variable_map_.insert({ decl, { addr, llvm_type } });
 }
 
-void CodeGen::AddGlobalVariable(llvm::StringRef name, llvm::Value *addr, llvm::Type *llvm_type) {
-    global_variable_map_.insert({ name, { addr, llvm_type } });
+CodeGen::CodeGen(std::shared_ptr<Program> prog, bool build_ssa) : build_ssa_(build_ssa) {
+    module_ = std::make_unique<llvm::Module>(prog->file_name_, context_);
+    VisitProgram(prog.get());
 }
 
-std::pair<llvm::Value *, llvm::Type *> CodeGen::GetVariableByName(llvm::StringRef name) {
-    for (auto iter = local_variable_map_.rbegin(); iter != local_variable_map_.rend(); ++iter) {
-        const auto& map = *iter;
-        if (map.contains(name)) {
-            return map.at(name);
-        }
+llvm::Value* CodeGen::VisitProgram(Program *prog) {
+    for (const auto& node : prog->nodes_) {
+        Visit(node);
+    }
+    return nullptr;
+}
+
+llvm::Value *CodeGen::VisitDeclStmt(DeclStmt* decl_stmt) {
+    for (const auto& node : decl_stmt->nodes_) {
+        Visit(node);
     }
+    return nullptr;
+}
 
-    assert(global_variable_map_.contains(name));
-    return global_variable_map_.at(name);
+llvm::Value *CodeGen::VisitBlockStmt(BlockStmt* block_stmt) {
+    EnterLocalScope(ContainsLabel(block_stmt));
+    for (const auto& node : block_stmt->nodes_) {
+        EmitStmt(node);
+    }
+    ExitLocalScope();
+    return nullptr;
 }
 
-void CodeGen::PushScope() {
-    local_variable_map_.emplace_back();
+void CodeGen::EmitStmt(AstNode* node) {
+    // The statements after `return`, `break` or `continue` can't be
+    // reached, so don't generate any code for them, unless they can be
+    // entered by a label, or declare the variables used after a label.
+    if (!HaveInsertPoint()) {
+        bool is_label_decl = llvm::isa<DeclStmt>(node) && local_scopes_.back().has_label;
+        if (!ContainsLabel(node) && !is_label_decl) {
+            return;
+        }
+        // A block or a label is able to start without an insert point.
+        if (!llvm::isa<BlockStmt>(node) && !llvm::isa<CaseStmt>(node) && !llvm::isa<LabelStmt>(node)) {
+            EmitBlock(llvm::BasicBlock::Create(context_, "unreachable"));
+        }
+    }
+    Visit(node);
 }
 
-void CodeGen::PopScope() {
-    local_variable_map_.pop_back();
+bool CodeGen::CollectLabelStmts(AstNode* node) {
+    if (!node) {
+        return false;
+    }
+
+    bool has_label = false;
+    switch (node->GetNodeKind()) {
+        case AstNode::AstNodeKind::kBlockStmt: {
+            for (auto child : llvm::cast<BlockStmt>(node)->nodes_) {
+                // NOTE: Don't stop at the first label, the later ones are needed too.
+                has_label |= CollectLabelStmts(child);
+            }
+            break;
+        }
+        case AstNode::AstNodeKind::kIfStmt: {
+            auto if_stmt = llvm::cast<IfStmt>(node);
+            has_label |= CollectLabelStmts(if_stmt->then_node_);
+            has_label |= CollectLabelStmts(if_stmt->else_node_);
+            break;
+        }
+        case AstNode::AstNodeKind::kForStmt: {
+            has_label = CollectLabelStmts(llvm::cast<ForStmt>(node)->body_node_);
+            break;
+        }
+        case AstNode::AstNodeKind::kSwitchStmt: {
+            // The `case` and `default` labels in the body of a switch can only
+            // be reached from the switch itself, unlike the labels of `goto`.
+            size_t goto_label_count = goto_label_count_;
+            CollectLabelStmts(llvm::cast<SwitchStmt>(node)->body_node_);
+            has_label = goto_label_count_ != goto_label_count;
+            break;
+        }
+        case AstNode::AstNodeKind::kCaseStmt: {
+            CollectLabelStmts(llvm::cast<CaseStmt>(node)->sub_stmt_);
+            has_label = true;
+            break;
+        }
+        case AstNode::AstNodeKind::kLabelStmt: {
+            CollectLabelStmts(llvm::cast<LabelStmt>(node)->sub_stmt_);
+            ++goto_label_count_;
+            has_label = true;
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+
+    if (has_label) {
+        label_stmts_.insert(node);
+    }
+    return has_label;
 }
 
-void CodeGen::ClearVariableScope() {
-    local_variable_map_.clear();
+void CodeGen::EnterLocalScope(bool has_label) {
+    local_scopes_.push_back({ {}, has_label });
 }
 
-CodeGen::CodeGen(std::shared_ptr<Program> prog) {
-    module_ = std::make_unique<llvm::Module>(prog->file_name_, context_);
-    VisitProgram(prog.get());
+void CodeGen::ExitLocalScope() {
+    // If there is no insert point, the scope is left by a jump or `return`,
+    // which has ended the lifetimes by itself.
+    if (HaveInsertPoint()) {
+        EmitLifetimeEnds(local_scopes_.size() - 1);
+    }
+    local_scopes_.pop_back();
 }
 
-llvm::Value* CodeGen::VisitProgram(Program *prog) {
-    for (const auto& node : prog->nodes_) {
-        node->Accept(this);
+void CodeGen::EmitLifetimeEnds(size_t depth) {
+    for (size_t i = local_scopes_.size(); i > depth; --i) {
+        const auto& variables = local_scopes_[i - 1].variables;
+        for (auto iter = variables.rbegin(); iter != variables.rend(); ++iter) {
+            auto addr = *iter;
+            auto size = module_->getDataLayout().getTypeAllocSize(addr->getAllocatedType());
+            ir_builder_.CreateLifetimeEnd(addr, ir_builder_.getInt64(size));
+        }
     }
-    return nullptr;
 }
 
-llvm::Value *CodeGen::VisitDeclStmt(DeclStmt* decl_stmt) {
-    for (const auto& node : decl_stmt->nodes_) {
-        node->Accept(this);
+void CodeGen::EmitBranch(llvm::BasicBlock* target_block) {
+    if (HaveInsertPoint()) {
+        ir_builder_.CreateBr(target_block);
     }
-    return nullptr;
+    ir_builder_.ClearInsertionPoint();
 }
 
-llvm::Value *CodeGen::VisitBlockStmt(BlockStmt* block_stmt) {
-    llvm::Value* ret = nullptr;
-    for (const auto& node : block_stmt->nodes_) {
-        ret = node->Accept(this);
+void CodeGen::EmitBlock(llvm::BasicBlock* block, bool is_finished) {
+    // Fall through from the current block.
+    EmitBranch(block);
+
+    // Nobody jumps to a finished block, so the code after it is unreachable.
+    if (is_finished && block->use_empty()) {
+        delete block;
+        return;
     }
-    return ret;
+
+    block->insertInto(GetCurrentFunc());
+    ir_builder_.SetInsertPoint(block);
+
+    // NOTE:
+    // All the jumps to a block are generated before the block itself,
+    // except the back edges of loops, see `VisitForStmt`.
+    SealBlock(block);
 }
 
 llvm::Value *CodeGen::VisitIfStmt(IfStmt* if_stmt) {
-    auto cond_block = llvm::BasicBlock::Create(context_, "cond");
+    // If the condition has been folded by sema,
+    // only generate the branch which will be executed,
+    // unless the other one can be entered by a label.
+    if (auto cond = if_stmt->cond_node_->GetConstantValue()) {
+        auto live_node = *cond ? if_stmt->then_node_ : if_stmt->else_node_;
+        auto dead_node = *cond ? if_stmt->else_node_ : if_stmt->then_node_;
+        if (!ContainsLabel(dead_node)) {
+            if (live_node) {
+                Visit(live_node);
+            }
+            return nullptr;
+        }
+    }
+
     auto then_block = llvm::BasicBlock::Create(context_, "then");
     llvm::BasicBlock* else_block = nullptr;
     if (if_stmt->else_node_) {
@@ -78,133 +189,258 @@ llvm::Value *CodeGen::VisitIfStmt(IfStmt* if_stmt) {
     }
     auto final_block = llvm::BasicBlock::Create(context_, "final");
 
-    // Don't forget to let our program jump into cond block at first!
-    ir_builder_.CreateBr(cond_block);
-
-    // Let's deal with cond block at first.
-    cond_block->insertInto(GetCurrentFunc());
-    ir_builder_.SetInsertPoint(cond_block);
-    // Generate the instructions of condition expression itself.
-    llvm::Value* cond_expr_val = if_stmt->cond_node_->Accept(this);
-    CastValue(&cond_expr_val, ir_builder_.getInt32Ty());
-    // Generate a compare instruction, 
-    // to check whether the return value of condition expression is true.
-    llvm::Value* is_cond_expr_val_true = ir_builder_.CreateICmpNE(cond_expr_val, ir_builder_.getInt32(0));
-    // Generate the conditional jumping instruction.
-    ir_builder_.CreateCondBr(is_cond_expr_val_true, then_block, if_stmt->else_node_ ? else_block : final_block);
+    // Generate the instructions of condition expression,
+    // which jump to then block or else block directly.
+    EmitBranchOnBool(if_stmt->cond_node_, then_block, if_stmt->else_node_ ? else_block : final_block);
 
     // Generate the instructions of then block.
-    then_block->insertInto(GetCurrentFunc());
-    ir_builder_.SetInsertPoint(then_block);
-    if_stmt->then_node_->Accept(this);
-
-    auto current_block = ir_builder_.GetInsertBlock();
-    if (current_block->empty() || !current_block->back().isTerminator()) {
-        ir_builder_.CreateBr(final_block);
-    }
+    EmitBlock(then_block);
+    Visit(if_stmt->then_node_);
+    EmitBranch(final_block);
 
     // Generate the instructions of else block.
     if (if_stmt->else_node_) {
-        else_block->insertInto(GetCurrentFunc());
-        ir_builder_.SetInsertPoint(else_block);
-        if_stmt->else_node_->Accept(this);
-
-        auto current_block = ir_builder_.GetInsertBlock();
-        if (current_block->empty() || !current_block->back().isTerminator()) {
-            ir_builder_.CreateBr(final_block);
-        }
+        EmitBlock(else_block);
+        Visit(if_stmt->else_node_);
+        EmitBranch(final_block);
     }
 
-    // Let our code generator to generate later code after if statement in final block...
-    final_block->insertInto(GetCurrentFunc());
-    ir_builder_.SetInsertPoint(final_block);
+    // Let our code generator to generate later code after if statement in final block,
+    // unless both of the branches never come back.
+    EmitBlock(final_block, true);
 
     return nullptr;
 }
 
 llvm::Value *CodeGen::VisitForStmt(ForStmt* for_stmt) {
-    auto init_block = llvm::BasicBlock::Create(context_, "for.init", GetCurrentFunc());
-    auto cond_block = llvm::BasicBlock::Create(context_, "for.cond");
-    auto inc_block = llvm::BasicBlock::Create(context_, "for.inc");
     auto body_block = llvm::BasicBlock::Create(context_, "for.body");
+    auto inc_block = llvm::BasicBlock::Create(context_, "for.inc");
     auto final_block = llvm::BasicBlock::Create(context_, "for.final");
 
+    // For statement has its own scope, which holds the variables declared
+    // in its init part.
+    EnterLocalScope(ContainsLabel(for_stmt));
+
     // Don't forget to bind the statement node with its final block, and inc block.
     break_block_map_.insert({ for_stmt, final_block });
     continue_block_map_.insert({ for_stmt, inc_block });
-
-    // Build init block.
-    ir_builder_.CreateBr(init_block);
-    ir_builder_.SetInsertPoint(init_block);
+    jump_scope_depth_map_.insert({ for_stmt, local_scopes_.size() });
+
+    // NOTE:
+    // The loop is generated in the rotated form, i.e.
+    //
+    //       init
+    //       if (!cond) goto final
+    //   body:
+    //       ...
+    //   inc:
+    //       inc
+    //       if (cond) goto body
+    //   final:
+    //
+    // so that each iteration only executes one conditional jump,
+    // and the loop has the shape expected by LLVM's loop passes.
+
+    // 1. Generate the init part, and the guard of the loop.
     if (for_stmt->init_node_) {
-        for_stmt->init_node_->Accept(this);
+        Visit(for_stmt->init_node_);
     }
-    ir_builder_.CreateBr(cond_block);
-
-    // Build cond block.
-    cond_block->insertInto(GetCurrentFunc());
-    ir_builder_.SetInsertPoint(cond_block);
     if (for_stmt->cond_node_) {
-        llvm::Value* cond_result = for_stmt->cond_node_->Accept(this);
-        CastValue(&cond_result, ir_builder_.getInt32Ty());
-        llvm::Value* is_cond_result_true = ir_builder_.CreateICmpNE(cond_result, ir_builder_.getInt32(0));
-        ir_builder_.CreateCondBr(is_cond_result_true, body_block, final_block);
+        EmitBranchOnBool(for_stmt->cond_node_, body_block, final_block);
     } else {
-        ir_builder_.CreateBr(body_block);
+        EmitBranch(body_block);
     }
 
-    // Build body block.
+    // 2. Build body block.
+    //    It's the header of the loop, which isn't sealed until the back edge
+    //    is generated.
+    EmitBranch(body_block);
     body_block->insertInto(GetCurrentFunc());
     ir_builder_.SetInsertPoint(body_block);
     if (for_stmt->body_node_) {
-        for_stmt->body_node_->Accept(this);
-    }
-
-    auto current_block = ir_builder_.GetInsertBlock();
-    if (current_block->empty() || !current_block->back().isTerminator()) {
-        ir_builder_.CreateBr(inc_block);
+        Visit(for_stmt->body_node_);
     }
 
-    // Build inc block.
-    inc_block->insertInto(GetCurrentFunc());
-    ir_builder_.SetInsertPoint(inc_block);
-    if (for_stmt->inc_node_) {
-        for_stmt->inc_node_->Accept(this);
+    // 3. Build inc block, which tests the condition again at the bottom,
+    //    unless the end of the body can't be reached.
+    EmitBlock(inc_block, true);
+    if (HaveInsertPoint()) {
+        if (for_stmt->inc_node_) {
+            Visit(for_stmt->inc_node_);
+        }
+        if (for_stmt->cond_node_) {
+            EmitBranchOnBool(for_stmt->cond_node_, body_block, final_block);
+        } else {
+            EmitBranch(body_block);
+        }
     }
-    ir_builder_.CreateBr(cond_block);
+    SealBlock(body_block);
 
-    // Let our code generator to generate later code after for statement in final block...
-    final_block->insertInto(GetCurrentFunc());
-    ir_builder_.SetInsertPoint(final_block);
+    // Let our code generator to generate later code after for statement in final block,
+    // unless the loop never exits.
+    EmitBlock(final_block, true);
 
     // Don't forget to unbind the statement node with its final block, and inc block.
     break_block_map_.erase(for_stmt);
     continue_block_map_.erase(for_stmt);
+    jump_scope_depth_map_.erase(for_stmt);
+
+    ExitLocalScope();
 
     return nullptr;
 }
 
 llvm::Value *CodeGen::VisitBreakStmt(BreakStmt* stmt) {
-    llvm::BasicBlock* target_block = break_block_map_.at(stmt->target_.get());
-    ir_builder_.CreateBr(target_block);
+    llvm::BasicBlock* target_block = break_block_map_.at(stmt->target_);
+    EmitLifetimeEnds(jump_scope_depth_map_.at(stmt->target_));
+    EmitBranch(target_block);
+    return nullptr;
+}
+
+llvm::Value *CodeGen::VisitContinueStmt(ContinueStmt* stmt) {
+    llvm::BasicBlock* target_block = continue_block_map_.at(stmt->target_);
+    EmitLifetimeEnds(jump_scope_depth_map_.at(stmt->target_));
+    EmitBranch(target_block);
+    return nullptr;
+}
+
+llvm::Value *CodeGen::VisitSwitchStmt(SwitchStmt* switch_stmt) {
+    auto cond = Visit(switch_stmt->cond_node_);
+    auto final_block = llvm::BasicBlock::Create(context_, "switch.final");
+
+    // NOTE:
+    // The switch jumps to the final block by default, and each label in the
+    // body adds its own case when it's generated. LLVM lowers the switch into
+    // a jump table or a binary search according to the case values.
+    auto switch_inst = ir_builder_.CreateSwitch(cond, final_block, switch_stmt->case_nodes_.size());
+    ir_builder_.ClearInsertionPoint();
+
+    // Don't forget to bind the statement node with its switch and final block.
+    switch_inst_map_.insert({ switch_stmt, switch_inst });
+    break_block_map_.insert({ switch_stmt, final_block });
+    jump_scope_depth_map_.insert({ switch_stmt, local_scopes_.size() });
+
+    // The code before the first label can't be reached.
+    if (switch_stmt->body_node_) {
+        EmitStmt(switch_stmt->body_node_);
+    }
 
-    llvm::BasicBlock* death_block = llvm::BasicBlock::Create(context_, "for.break.death", GetCurrentFunc());
-    ir_builder_.SetInsertPoint(death_block);
+    // Let our code generator to generate later code after switch statement in final block,
+    // unless it can't be reached.
+    EmitBlock(final_block, true);
+
+    switch_inst_map_.erase(switch_stmt);
+    break_block_map_.erase(switch_stmt);
+    jump_scope_depth_map_.erase(switch_stmt);
 
     return nullptr;
 }
 
-llvm::Value *CodeGen::VisitContinueStmt(ContinueStmt* stmt) {
-    llvm::BasicBlock* target_block = continue_block_map_.at(stmt->target_.get());
-    ir_builder_.CreateBr(target_block);
+llvm::Value *CodeGen::VisitCaseStmt(CaseStmt* case_stmt) {
+    auto switch_inst = switch_inst_map_.at(case_stmt->target_);
+
+    // Add the case before starting the block,
+    // so that all the predecessors of the block are known when it's sealed.
+    llvm::BasicBlock* case_block = nullptr;
+    if (case_stmt->value_node_) {
+        case_block = llvm::BasicBlock::Create(context_, "switch.case");
+        auto value = *case_stmt->value_node_->GetConstantValue();
+        switch_inst->addCase(ir_builder_.getInt32(value), case_block);
+    } else {
+        case_block = llvm::BasicBlock::Create(context_, "switch.default");
+        switch_inst->setDefaultDest(case_block);
+    }
+
+    // The previous case falls through into this one.
+    EmitBlock(case_block);
+
+    if (case_stmt->sub_stmt_) {
+        Visit(case_stmt->sub_stmt_);
+    }
+
+    return nullptr;
+}
+
+llvm::BasicBlock *CodeGen::GetLabelBlock(AstNode* label) {
+    auto& block = label_block_map_[label];
+    if (!block) {
+        block = llvm::BasicBlock::Create(context_, llvm::cast<LabelStmt>(label)->GetLabelName());
+    }
+    return block;
+}
+
+llvm::BasicBlock *CodeGen::GetIndirectGotoBlock() {
+    if (indirect_goto_block_) {
+        return indirect_goto_block_;
+    }
+
+    // NOTE:
+    // The addresses to jump to are merged by a PHI node, so that there is
+    // only one `indirectbr`, whose destinations are added at the end of
+    // the function, when all the labels whose address is taken are known.
+    indirect_goto_block_ = llvm::BasicBlock::Create(context_, "indirectgoto");
+    auto addr = llvm::PHINode::Create(llvm::PointerType::getUnqual(ir_builder_.getInt8Ty()), 0,
+                                      "indirect.goto.dest", indirect_goto_block_);
+    llvm::IndirectBrInst::Create(addr, 0, indirect_goto_block_);
+    return indirect_goto_block_;
+}
+
+void CodeGen::FinishLabels() {
+    if (indirect_goto_block_) {
+        auto indirect_br = llvm::cast<llvm::IndirectBrInst>(indirect_goto_block_->getTerminator());
+        for (auto [label, block] : label_block_map_) {
+            if (llvm::cast<LabelStmt>(label)->is_address_taken_) {
+                indirect_br->addDestination(block);
+            }
+        }
+        indirect_goto_block_->insertInto(GetCurrentFunc());
+        SealBlock(indirect_goto_block_);
+    }
+
+    for (auto [label, block] : label_block_map_) {
+        SealBlock(block);
+    }
+
+    label_block_map_.clear();
+    indirect_goto_block_ = nullptr;
+}
+
+llvm::Value *CodeGen::VisitLabelStmt(LabelStmt* label_stmt) {
+    // The label block is sealed by `FinishLabels`.
+    auto label_block = GetLabelBlock(label_stmt);
+    EmitBranch(label_block);
+    label_block->insertInto(GetCurrentFunc());
+    ir_builder_.SetInsertPoint(label_block);
+
+    if (label_stmt->sub_stmt_) {
+        Visit(label_stmt->sub_stmt_);
+    }
+
+    return nullptr;
+}
 
-    llvm::BasicBlock* death_block = llvm::BasicBlock::Create(context_, "for.continue.death", GetCurrentFunc());
-    ir_builder_.SetInsertPoint(death_block);
+llvm::Value *CodeGen::VisitGotoStmt(GotoStmt* stmt) {
+    EmitBranch(GetLabelBlock(stmt->target_));
+    return nullptr;
+}
 
+llvm::Value *CodeGen::VisitIndirectGotoStmt(IndirectGotoStmt* stmt) {
+    auto addr = Visit(stmt->target_node_);
+    auto indirect_goto_block = GetIndirectGotoBlock();
+    auto dest_phi = llvm::cast<llvm::PHINode>(&indirect_goto_block->front());
+    dest_phi->addIncoming(addr, ir_builder_.GetInsertBlock());
+    EmitBranch(indirect_goto_block);
     return nullptr;
 }
 
+llvm::Value *CodeGen::VisitAddrLabelExpr(AddrLabelExpr* expr) {
+    return llvm::BlockAddress::get(GetCurrentFunc(), GetLabelBlock(expr->target_));
+}
+
 llvm::Value *CodeGen::VisitSizeofExpr(SizeofExpr* expr) {
+    if (auto value = expr->GetConstantValue()) {
+        return ir_builder_.getInt32(*value);
+    }
     if (expr->sub_ctype_) {
         return ir_builder_.getInt32(expr->sub_ctype_->GetSize());
     }
@@ -216,55 +452,55 @@ llvm::Value *CodeGen::VisitSizeofExpr(SizeofExpr* expr) {
 }
 
 llvm::Value *CodeGen::VisitUnaryExpr(UnaryExpr* expr) {
-    auto value = expr->sub_node_->Accept(this);
+    if (auto value = expr->GetConstantValue()) {
+        return ir_builder_.getInt32(*value);
+    }
+
     auto ctype = expr->sub_node_->GetCType();
 
     switch (expr->op_) {
         case UnaryOpCode::kPositive: {
-            return value;
+            return Visit(expr->sub_node_);
         }
         case UnaryOpCode::kNegative: {
-            return ir_builder_.CreateNeg(value);
+            return ir_builder_.CreateNeg(Visit(expr->sub_node_));
         }
-        case UnaryOpCode::kSelfIncreasing: {    
-            llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(value);
-            assert(target);
+        case UnaryOpCode::kSelfIncreasing: {
+            auto addr = EmitLValue(expr->sub_node_);
+            auto value = EmitLoadOfScalar(expr->sub_node_, addr);
             llvm::Value* new_value;
             if (ctype->GetKind() == CType::TypeKind::kPointer) {
-                new_value = ir_builder_.CreateInBoundsGEP(ctype->Accept(this), value, { ir_builder_.getInt32(1) });
+                new_value = ir_builder_.CreateInBoundsGEP(VisitType(ctype), value, { ir_builder_.getInt32(1) });
             } else {
                 new_value = ir_builder_.CreateNSWAdd(value, ir_builder_.getInt32(1));
             }
-            ir_builder_.CreateStore(new_value, target->getPointerOperand());
+            EmitStoreOfScalar(new_value, expr->sub_node_, addr);
             return new_value;
         }
-        case UnaryOpCode::kSelfDecreasing: {    
-            llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(value);
-            assert(target);
+        case UnaryOpCode::kSelfDecreasing: {
+            auto addr = EmitLValue(expr->sub_node_);
+            auto value = EmitLoadOfScalar(expr->sub_node_, addr);
             llvm::Value* new_value;
             if (ctype->GetKind() == CType::TypeKind::kPointer) {
-                new_value = ir_builder_.CreateInBoundsGEP(ctype->Accept(this), value, { ir_builder_.getInt32(-1) });
+                new_value = ir_builder_.CreateInBoundsGEP(VisitType(ctype), value, { ir_builder_.getInt32(-1) });
             } else {
                 new_value = ir_builder_.CreateNSWSub(value, ir_builder_.getInt32(1));
             }
-            ir_builder_.CreateStore(new_value, target->getPointerOperand());
+            EmitStoreOfScalar(new_value, expr->sub_node_, addr);
             return new_value;
         }
         case UnaryOpCode::kDereference: {
-            auto pointer_ctype = llvm::dyn_cast<CPointerType>(ctype.get());
-            assert(pointer_ctype);
-            ctype = pointer_ctype->GetBaseType();
-            return ir_builder_.CreateLoad(ctype->Accept(this), value);
+            return EmitRValue(expr, EmitLValue(expr));
         }
         case UnaryOpCode::kAddress: {
-            return llvm::dyn_cast<llvm::LoadInst>(value)->getPointerOperand();
+            return EmitLValue(expr->sub_node_);
         }
         case UnaryOpCode::kLogicalNot: {
-            auto value_is_true = ir_builder_.CreateICmpNE(value, ir_builder_.getInt32(0));
-            return ir_builder_.CreateZExt(ir_builder_.CreateNot(value_is_true), ir_builder_.getInt32Ty());
+            auto value = Visit(expr->sub_node_);
+            return ir_builder_.CreateZExt(ir_builder_.CreateIsNull(value), ir_builder_.getInt32Ty());
         }
         case UnaryOpCode::kBitwiseNot: {
-            return ir_builder_.CreateNot(value);
+            return ir_builder_.CreateNot(Visit(expr->sub_node_));
         }
     }
 
@@ -272,112 +508,81 @@ llvm::Value *CodeGen::VisitUnaryExpr(UnaryExpr* expr) {
 }
 
 llvm::Value *CodeGen::VisitBinaryExpr(BinaryExpr* binary_expr) {
+    // NOTE:
+    // Sema has folded the constant expressions already,
+    // so don't emit any instruction for them.
+    if (auto value = binary_expr->GetConstantValue()) {
+        return ir_builder_.getInt32(*value);
+    }
+
     auto op_code = binary_expr->op_;
     switch (op_code) {
         // left && right
-        case BinaryOpCode::kLogicalAnd: {
-            auto left = binary_expr->left_->Accept(this);
-            CastValue(&left, ir_builder_.getInt32Ty());
-            auto is_left_true = ir_builder_.CreateICmpNE(left, ir_builder_.getInt32(0));
-
-            auto next_block = llvm::BasicBlock::Create(context_, "next_block");
-            auto false_block = llvm::BasicBlock::Create(context_, "false_block");
-            auto merge_block = llvm::BasicBlock::Create(context_, "merge_block");
-
-            ir_builder_.CreateCondBr(is_left_true, next_block, false_block);
-
-            // Build next_block
-            next_block->insertInto(GetCurrentFunc());
-            ir_builder_.SetInsertPoint(next_block);
-            auto right = binary_expr->right_->Accept(this);
-            CastValue(&right, ir_builder_.getInt32Ty());
-            auto is_right_true = ir_builder_.CreateICmpNE(right, ir_builder_.getInt32(0));
-            is_right_true = ir_builder_.CreateZExt(is_right_true, ir_builder_.getInt32Ty());
-            ir_builder_.CreateBr(merge_block);
-            // Don't forget to update the next_block,
-            // since new block might be created after 
-            // `binary_expr->right_->Accept(this)` is called.
-            next_block = ir_builder_.GetInsertBlock();
-
-            // Build false_block
-            false_block->insertInto(GetCurrentFunc());
-            ir_builder_.SetInsertPoint(false_block);
-            ir_builder_.CreateBr(merge_block);
-
-            // Build merge_block
-            merge_block->insertInto(GetCurrentFunc());
-            ir_builder_.SetInsertPoint(merge_block);
-            auto phi = ir_builder_.CreatePHI(ir_builder_.getInt32Ty(), 2);
-            phi->addIncoming(ir_builder_.getInt32(0), false_block);
-            phi->addIncoming(is_right_true, next_block);
-
-            return phi;
-        }
         // left || right
+        case BinaryOpCode::kLogicalAnd:
         case BinaryOpCode::kLogicalOr: {
-            auto left = binary_expr->left_->Accept(this);
-            CastValue(&left, ir_builder_.getInt32Ty());
-            auto is_left_true = ir_builder_.CreateICmpNE(left, ir_builder_.getInt32(0));
-
-            auto next_block = llvm::BasicBlock::Create(context_, "next_block");
-            auto true_block = llvm::BasicBlock::Create(context_, "true_block");
-            auto merge_block = llvm::BasicBlock::Create(context_, "merge_block");
-
-            ir_builder_.CreateCondBr(is_left_true, true_block, next_block);
-
-            // Build next_block
-            next_block->insertInto(GetCurrentFunc());
-            ir_builder_.SetInsertPoint(next_block);
-            auto right = binary_expr->right_->Accept(this);
-            CastValue(&right, ir_builder_.getInt32Ty());
-            auto is_right_true = ir_builder_.CreateICmpNE(right, ir_builder_.getInt32(0));
-            is_right_true = ir_builder_.CreateZExt(is_right_true, ir_builder_.getInt32Ty());
-            ir_builder_.CreateBr(merge_block);
-            next_block = ir_builder_.GetInsertBlock();
-
-            // Build true_block
-            true_block->insertInto(GetCurrentFunc());
-            ir_builder_.SetInsertPoint(true_block);
-            ir_builder_.CreateBr(merge_block);
-
-            // Build merge_block
-            merge_block->insertInto(GetCurrentFunc());
-            ir_builder_.SetInsertPoint(merge_block);
+            auto true_block = llvm::BasicBlock::Create(context_, "logic.true");
+            auto false_block = llvm::BasicBlock::Create(context_, "logic.false");
+            auto merge_block = llvm::BasicBlock::Create(context_, "logic.merge");
+
+            // The operands are lowered into branches,
+            // so only the final result needs to be merged.
+            EmitBranchOnBool(binary_expr, true_block, false_block);
+
+            EmitBlock(true_block);
+            EmitBranch(merge_block);
+
+            EmitBlock(false_block);
+            EmitBranch(merge_block);
+
+            EmitBlock(merge_block);
             auto phi = ir_builder_.CreatePHI(ir_builder_.getInt32Ty(), 2);
             phi->addIncoming(ir_builder_.getInt32(1), true_block);
-            phi->addIncoming(is_right_true, next_block);
+            phi->addIncoming(ir_builder_.getInt32(0), false_block);
 
-            return phi;            
+            return phi;
         }
+        default:
+            break;
     }
 
-    auto left = binary_expr->left_->Accept(this);
-    auto right = binary_expr->right_->Accept(this);
+    // NOTE:
+    // The left side of an assignment is evaluated as an address,
+    // and only the compound assignments need to load its old value.
+    llvm::Value* left_addr = nullptr;
+    llvm::Value* left = nullptr;
+    switch (op_code) {
+        case BinaryOpCode::kAssign:
+            left_addr = EmitLValue(binary_expr->left_);
+            break;
+        case BinaryOpCode::kAddAssign:
+        case BinaryOpCode::kSubAssign:
+        case BinaryOpCode::kMulAssign:
+        case BinaryOpCode::kDivAssign:
+        case BinaryOpCode::kModAssign:
+        case BinaryOpCode::kLeftShiftAssign:
+        case BinaryOpCode::kRightShiftAssign:
+        case BinaryOpCode::kBitwiseAndAssign:
+        case BinaryOpCode::kBitwiseOrAssign:
+        case BinaryOpCode::kBitwiseXorAssign:
+            left_addr = EmitLValue(binary_expr->left_);
+            left = EmitLoadOfScalar(binary_expr->left_, left_addr);
+            break;
+        default:
+            left = Visit(binary_expr->left_);
+            break;
+    }
+    auto right = Visit(binary_expr->right_);
 
     switch (op_code) {
-        case BinaryOpCode::kEqualEqual: {
-            auto val = ir_builder_.CreateICmpEQ(left, right);
-            return ir_builder_.CreateIntCast(val, ir_builder_.getInt32Ty(), true);
-        }
-        case BinaryOpCode::kNotEqual: {
-            auto val = ir_builder_.CreateICmpNE(left, right);
-            return ir_builder_.CreateIntCast(val, ir_builder_.getInt32Ty(), true);
-        }
-        case BinaryOpCode::kLess: {
-            auto val = ir_builder_.CreateICmpSLT(left, right);
-            return ir_builder_.CreateIntCast(val, ir_builder_.getInt32Ty(), true);
-        }
-        case BinaryOpCode::kLessEqual: {
-            auto val = ir_builder_.CreateICmpSLE(left, right);
-            return ir_builder_.CreateIntCast(val, ir_builder_.getInt32Ty(), true);
-        }
-        case BinaryOpCode::kGreater: {
-            auto val = ir_builder_.CreateICmpSGT(left, right);
-            return ir_builder_.CreateIntCast(val, ir_builder_.getInt32Ty(), true);
-        }
+        case BinaryOpCode::kEqualEqual:
+        case BinaryOpCode::kNotEqual:
+        case BinaryOpCode::kLess:
+        case BinaryOpCode::kLessEqual:
+        case BinaryOpCode::kGreater:
         case BinaryOpCode::kGreaterEqual: {
-            auto val = ir_builder_.CreateICmpSGE(left, right);
-            return ir_builder_.CreateIntCast(val, ir_builder_.getInt32Ty(), true);
+            auto val = EmitCompare(op_code, left, right);
+            return ir_builder_.CreateZExt(val, ir_builder_.getInt32Ty());
         }
         case BinaryOpCode::kAdd: {
             auto _ctype = left->getType();
@@ -410,15 +615,15 @@ llvm::Value *CodeGen::VisitBinaryExpr(BinaryExpr* binary_expr) {
         case BinaryOpCode::kRightShift:
             return ir_builder_.CreateAShr(left, right);
         case BinaryOpCode::kAssign: {
-            llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(left);
-            assert(target);
-            ir_builder_.CreateStore(right, target->getPointerOperand());
+            auto left_ctype = binary_expr->left_->GetCType().get();
+            if (left_ctype->GetKind() == CType::TypeKind::kRecord) {
+                EmitAggregateCopy(left_addr, right, left_ctype);
+                return left_addr;
+            }
+            EmitStoreOfScalar(right, binary_expr->left_, left_addr);
             return right;
         }
         case BinaryOpCode::kAddAssign: {
-            llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(left);
-            assert(target);
-
             llvm::Value* new_value = nullptr;
             auto _ctype = left->getType();
             if (_ctype->isPointerTy()) {
@@ -427,13 +632,10 @@ llvm::Value *CodeGen::VisitBinaryExpr(BinaryExpr* binary_expr) {
                 new_value = ir_builder_.CreateNSWAdd(left, right);
             }
 
-            ir_builder_.CreateStore(new_value, target->getPointerOperand());
+            EmitStoreOfScalar(new_value, binary_expr->left_, left_addr);
             return new_value;
         }
         case BinaryOpCode::kSubAssign: {
-            llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(left);
-            assert(target);
-
             llvm::Value* new_value = nullptr;
             auto _ctype = left->getType();
             if (_ctype->isPointerTy()) {
@@ -442,63 +644,47 @@ llvm::Value *CodeGen::VisitBinaryExpr(BinaryExpr* binary_expr) {
                 new_value = ir_builder_.CreateNSWSub(left, right);
             }
 
-            ir_builder_.CreateStore(new_value, target->getPointerOperand());
+            EmitStoreOfScalar(new_value, binary_expr->left_, left_addr);
             return new_value;
         }
         case BinaryOpCode::kMulAssign: {
-            llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(left);
-            assert(target);
             auto new_value = ir_builder_.CreateNSWMul(left, right);
-            ir_builder_.CreateStore(new_value, target->getPointerOperand());
+            EmitStoreOfScalar(new_value, binary_expr->left_, left_addr);
             return new_value;
         }
         case BinaryOpCode::kDivAssign: {
-            llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(left);
-            assert(target);
             auto new_value = ir_builder_.CreateSDiv(left, right);
-            ir_builder_.CreateStore(new_value, target->getPointerOperand());
+            EmitStoreOfScalar(new_value, binary_expr->left_, left_addr);
             return new_value;
         }
         case BinaryOpCode::kModAssign: {
-            llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(left);
-            assert(target);
             auto new_value = ir_builder_.CreateSRem(left, right);
-            ir_builder_.CreateStore(new_value, target->getPointerOperand());
+            EmitStoreOfScalar(new_value, binary_expr->left_, left_addr);
             return new_value;
         }
         case BinaryOpCode::kLeftShiftAssign: {
-            llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(left);
-            assert(target);
             auto new_value = ir_builder_.CreateShl(left, right);
-            ir_builder_.CreateStore(new_value, target->getPointerOperand());
+            EmitStoreOfScalar(new_value, binary_expr->left_, left_addr);
             return new_value;
         }
         case BinaryOpCode::kRightShiftAssign: {
-            llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(left);
-            assert(target);
             auto new_value = ir_builder_.CreateAShr(left, right);
-            ir_builder_.CreateStore(new_value, target->getPointerOperand());
+            EmitStoreOfScalar(new_value, binary_expr->left_, left_addr);
             return new_value;
         }
         case BinaryOpCode::kBitwiseAndAssign: {
-            llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(left);
-            assert(target);
             auto new_value = ir_builder_.CreateAnd(left, right);
-            ir_builder_.CreateStore(new_value, target->getPointerOperand());
+            EmitStoreOfScalar(new_value, binary_expr->left_, left_addr);
             return new_value;
         }
         case BinaryOpCode::kBitwiseOrAssign: {
-            llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(left);
-            assert(target);
             auto new_value = ir_builder_.CreateOr(left, right);
-            ir_builder_.CreateStore(new_value, target->getPointerOperand());
+            EmitStoreOfScalar(new_value, binary_expr->left_, left_addr);
             return new_value;
         }
         case BinaryOpCode::kBitwiseXorAssign: {
-            llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(left);
-            assert(target);
             auto new_value = ir_builder_.CreateXor(left, right);
-            ir_builder_.CreateStore(new_value, target->getPointerOperand());
+            EmitStoreOfScalar(new_value, binary_expr->left_, left_addr);
             return new_value;
         }
         case BinaryOpCode::kComma: {
@@ -513,33 +699,127 @@ llvm::Value *CodeGen::VisitBinaryExpr(BinaryExpr* binary_expr) {
     return nullptr;
 }
 
+llvm::Value *CodeGen::EmitCompare(BinaryOpCode op_code, llvm::Value* left, llvm::Value* right) {
+    // e.g. `p != 0`, the integer is compared as a pointer.
+    if (left->getType()->isPointerTy()) {
+        CastValue(&right, left->getType());
+    } else if (right->getType()->isPointerTy()) {
+        CastValue(&left, right->getType());
+    }
+
+    switch (op_code) {
+        case BinaryOpCode::kEqualEqual:
+            return ir_builder_.CreateICmpEQ(left, right);
+        case BinaryOpCode::kNotEqual:
+            return ir_builder_.CreateICmpNE(left, right);
+        case BinaryOpCode::kLess:
+            return ir_builder_.CreateICmpSLT(left, right);
+        case BinaryOpCode::kLessEqual:
+            return ir_builder_.CreateICmpSLE(left, right);
+        case BinaryOpCode::kGreater:
+            return ir_builder_.CreateICmpSGT(left, right);
+        case BinaryOpCode::kGreaterEqual:
+            return ir_builder_.CreateICmpSGE(left, right);
+        default:
+            assert(0);
+            return nullptr;
+    }
+}
+
+void CodeGen::EmitBranchOnBool(AstNode* cond_node,
+                               llvm::BasicBlock* true_block,
+                               llvm::BasicBlock* false_block)
+{
+    // The condition is folded by sema, only one of the targets is reachable.
+    if (auto value = cond_node->GetConstantValue()) {
+        EmitBranch(*value ? true_block : false_block);
+        return;
+    }
+
+    switch (cond_node->GetNodeKind()) {
+        case AstNode::AstNodeKind::kBinaryExpr: {
+            auto expr = llvm::dyn_cast<BinaryExpr>(cond_node);
+            switch (expr->op_) {
+                // The right operand is only evaluated
+                // when the left one can't decide the result.
+                case BinaryOpCode::kLogicalAnd: {
+                    auto rhs_block = llvm::BasicBlock::Create(context_, "land.rhs");
+                    EmitBranchOnBool(expr->left_, rhs_block, false_block);
+                    EmitBlock(rhs_block);
+                    EmitBranchOnBool(expr->right_, true_block, false_block);
+                    return;
+                }
+                case BinaryOpCode::kLogicalOr: {
+                    auto rhs_block = llvm::BasicBlock::Create(context_, "lor.rhs");
+                    EmitBranchOnBool(expr->left_, true_block, rhs_block);
+                    EmitBlock(rhs_block);
+                    EmitBranchOnBool(expr->right_, true_block, false_block);
+                    return;
+                }
+                case BinaryOpCode::kEqualEqual:
+                case BinaryOpCode::kNotEqual:
+                case BinaryOpCode::kLess:
+                case BinaryOpCode::kLessEqual:
+                case BinaryOpCode::kGreater:
+                case BinaryOpCode::kGreaterEqual: {
+                    auto left = Visit(expr->left_);
+                    auto right = Visit(expr->right_);
+                    auto is_true = EmitCompare(expr->op_, left, right);
+                    ir_builder_.CreateCondBr(is_true, true_block, false_block);
+                    ir_builder_.ClearInsertionPoint();
+                    return;
+                }
+                default:
+                    break;
+            }
+            break;
+        }
+        case AstNode::AstNodeKind::kUnaryExpr: {
+            auto expr = static_cast<UnaryExpr*>(cond_node);
+            if (expr->op_ == UnaryOpCode::kLogicalNot) {
+                EmitBranchOnBool(expr->sub_node_, false_block, true_block);
+                return;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    // Otherwise, compare the value of the condition with zero.
+    auto value = Visit(cond_node);
+    ir_builder_.CreateCondBr(ir_builder_.CreateIsNotNull(value), true_block, false_block);
+    ir_builder_.ClearInsertionPoint();
+}
+
 llvm::Value *CodeGen::VisitTernaryExpr(TernaryExpr* expr) {
+    if (auto value = expr->GetConstantValue()) {
+        return ir_builder_.getInt32(*value);
+    }
+    // Only the selected branch is evaluated, if the condition is a constant.
+    if (auto cond = expr->cond_->GetConstantValue()) {
+        return Visit(*cond ? expr->then_ : expr->els_);
+    }
+
     auto then_block = llvm::BasicBlock::Create(context_, "ternary.then");
     auto els_block = llvm::BasicBlock::Create(context_, "ternary.else");
     auto merge_block = llvm::BasicBlock::Create(context_, "ternary.merge");
 
-    auto cond_val = expr->cond_->Accept(this);
-    CastValue(&cond_val, ir_builder_.getInt32Ty());
-    auto is_cond_true = ir_builder_.CreateICmpNE(cond_val, ir_builder_.getInt32(0));
-    ir_builder_.CreateCondBr(is_cond_true, then_block, els_block);
-
-    then_block->insertInto(GetCurrentFunc());
-    ir_builder_.SetInsertPoint(then_block);
+    EmitBranchOnBool(expr->cond_, then_block, els_block);
 
-    auto then_value = expr->then_->Accept(this);
+    EmitBlock(then_block);
+    auto then_value = Visit(expr->then_);
     then_block = ir_builder_.GetInsertBlock();
-    ir_builder_.CreateBr(merge_block);
+    EmitBranch(merge_block);
 
-    els_block->insertInto(GetCurrentFunc());
-    ir_builder_.SetInsertPoint(els_block);
-
-    auto els_value = expr->els_->Accept(this);
+    EmitBlock(els_block);
+    auto els_value = Visit(expr->els_);
     els_block = ir_builder_.GetInsertBlock();
-    ir_builder_.CreateBr(merge_block);
+    EmitBranch(merge_block);
 
-    merge_block->insertInto(GetCurrentFunc());
-    ir_builder_.SetInsertPoint(merge_block);
-    auto phi = ir_builder_.CreatePHI(expr->GetCType()->Accept(this), 2);
+    EmitBlock(merge_block);
+    // NOTE: The branches may be aggregates, which are merged as addresses.
+    auto phi = ir_builder_.CreatePHI(then_value->getType(), 2);
     phi->addIncoming(then_value, then_block);
     phi->addIncoming(els_value, els_block);
 
@@ -547,53 +827,74 @@ llvm::Value *CodeGen::VisitTernaryExpr(TernaryExpr* expr) {
 }
 
 llvm::Value* CodeGen::VisitVariableAccessExpr(VariableAccessExpr* access_node) {
-    auto variable_name = access_node->GetVariableName();
-    auto [variable_addr, variable_llvm_type] = GetVariableByName(variable_name);
-
-    if (variable_llvm_type->isFunctionTy()) {
-        return variable_addr;
-    } else {
-        return ir_builder_.CreateLoad(variable_llvm_type, variable_addr, variable_name);
+    if (IsSSAVariable(access_node->decl_)) {
+        return ReadVariable(access_node->decl_, ir_builder_.GetInsertBlock());
     }
+    return EmitRValue(access_node, EmitLValue(access_node), access_node->GetVariableName());
+}
 
-    return nullptr;
+// Skip the initial values before the object of `target_index_list`.
+// They are never looked up, e.g. a scalar given to a sub-array without braces.
+static void SkipInitValuesBefore(
+    const VariableDecl* decl_node,
+    const std::vector<int> &target_index_list,
+    size_t& next)
+{
+    const auto& init_values = decl_node->init_values_;
+    while (next < init_values.size()) {
+        const auto& cur_index_list = init_values[next]->index_list;
+        if (!std::lexicographical_compare(cur_index_list.begin(), cur_index_list.end(),
+                                          target_index_list.begin(), target_index_list.end()))
+        {
+            break;
+        }
+        ++next;
+    }
 }
 
-std::shared_ptr<VariableDecl::InitValue> CodeGen::GetInitValueStructByIndexList(
+VariableDecl::InitValue* CodeGen::GetInitValueStructByIndexList(
     const VariableDecl* decl_node, 
-    const std::vector<int> &target_index_list) 
+    const std::vector<int> &target_index_list,
+    size_t& next) 
 {
     const auto& init_values = decl_node->init_values_;
-    for (const auto& init_value_struct : init_values) {
-        const auto& cur_index_list = init_value_struct->index_list;
-        if (cur_index_list.size() != target_index_list.size()) {
-            continue;
-        } 
-        bool find = true;
-        for (int i = 0; i < target_index_list.size(); ++i) {
-            if (cur_index_list[i] != target_index_list[i]) {
-                find = false;
-                break;
-            } 
-        }
-        if (find) {
-            return init_value_struct;
-        }
+    SkipInitValuesBefore(decl_node, target_index_list, next);
+    if (next < init_values.size() &&
+        llvm::ArrayRef<int>(init_values[next]->index_list) == llvm::ArrayRef<int>(target_index_list))
+    {
+        return init_values[next++];
     }
 
     return nullptr;
 }
 
-llvm::Constant *CodeGen::GetInitialValueForGlobalVariable(
+bool CodeGen::HasInitValueIn(
+    const VariableDecl* decl_node,
+    const std::vector<int>& target_index_list,
+    size_t& next)
+{
+    const auto& init_values = decl_node->init_values_;
+    SkipInitValuesBefore(decl_node, target_index_list, next);
+    return next < init_values.size() &&
+           llvm::ArrayRef<int>(init_values[next]->index_list).take_front(target_index_list.size()) == 
+           llvm::ArrayRef<int>(target_index_list);
+}
+
+llvm::Constant *CodeGen::GetConstantInitializer(
     const VariableDecl* decl_node, 
     llvm::Type *type, 
-    std::vector<int>& index_list) 
+    std::vector<int>& index_list,
+    size_t& next) 
 {
     if (type->isIntegerTy()) {
-        auto init_value_struct = GetInitValueStructByIndexList(decl_node, index_list);
+        auto init_value_struct = GetInitValueStructByIndexList(decl_node, index_list, next);
         if (init_value_struct) {
-            auto init_value = init_value_struct->init_node->Accept(this);
-            auto init_type = init_value_struct->decl_type->Accept(this);
+            // Build the initializer from the folded value directly.
+            if (auto value = init_value_struct->init_node->GetConstantValue()) {
+                return ir_builder_.getInt32(*value);
+            }
+            auto init_value = Visit(init_value_struct->init_node);
+            auto init_type = VisitType(init_value_struct->decl_type);
             assert(type == init_type);
             CastValue(&init_value, init_type);
             return llvm::dyn_cast<llvm::Constant>(init_value);
@@ -601,10 +902,15 @@ llvm::Constant *CodeGen::GetInitialValueForGlobalVariable(
         return ir_builder_.getInt32(0);
     }
     else if (type->isPointerTy()) {
-        auto init_value_struct = GetInitValueStructByIndexList(decl_node, index_list);
+        auto init_value_struct = GetInitValueStructByIndexList(decl_node, index_list, next);
         if (init_value_struct) {
-            auto init_value = init_value_struct->init_node->Accept(this);
-            auto init_type = init_value_struct->decl_type->Accept(this);
+            // e.g. `int *p = 0;`
+            auto value = init_value_struct->init_node->GetConstantValue();
+            if (value && *value == 0) {
+                return llvm::ConstantPointerNull::get(llvm::cast<llvm::PointerType>(type));
+            }
+            auto init_value = Visit(init_value_struct->init_node);
+            auto init_type = VisitType(init_value_struct->decl_type);
             assert(type == init_type);
             CastValue(&init_value, init_type);
             return llvm::dyn_cast<llvm::Constant>(init_value);
@@ -613,6 +919,13 @@ llvm::Constant *CodeGen::GetInitialValueForGlobalVariable(
             return llvm::ConstantPointerNull::get(pointer_type);            
         }
     }
+    // NOTE:
+    // An aggregate without any initial value inside is all zeros,
+    // which is represented by a single `ConstantAggregateZero`,
+    // and the global variable is placed in bss at last.
+    else if (!HasInitValueIn(decl_node, index_list, next)) {
+        return llvm::Constant::getNullValue(type);
+    }
     else if (type->isStructTy()) {
         auto struct_type = llvm::dyn_cast<llvm::StructType>(type);
         auto element_count = struct_type->getStructNumElements();
@@ -620,7 +933,7 @@ llvm::Constant *CodeGen::GetInitialValueForGlobalVariable(
         for (auto i = 0; i < element_count; ++i) {
             auto element_type = struct_type->getStructElementType(i);
             index_list.push_back(i);
-            auto element_value = GetInitialValueForGlobalVariable(decl_node, element_type, index_list);
+            auto element_value = GetConstantInitializer(decl_node, element_type, index_list, next);
             index_list.pop_back();
             element_value_vec.push_back(element_value);
         }
@@ -630,10 +943,36 @@ llvm::Constant *CodeGen::GetInitialValueForGlobalVariable(
         auto array_type = llvm::dyn_cast<llvm::ArrayType>(type);
         auto element_type = array_type->getArrayElementType();
         auto element_count = array_type->getArrayNumElements();
+
+        // An array of int is built from the folded values directly,
+        // without creating a `ConstantInt` for each element.
+        if (element_type->isIntegerTy()) {
+            llvm::SmallVector<uint32_t> element_values;
+            element_values.reserve(element_count);
+            size_t first = next;
+            for (uint64_t i = 0; i < element_count; ++i) {
+                index_list.push_back(i);
+                auto init_value_struct = GetInitValueStructByIndexList(decl_node, index_list, next);
+                index_list.pop_back();
+                if (!init_value_struct) {
+                    element_values.push_back(0);
+                } else if (auto value = init_value_struct->init_node->GetConstantValue()) {
+                    element_values.push_back(*value);
+                } else {
+                    break;
+                }
+            }
+            if (element_values.size() == element_count) {
+                return llvm::ConstantDataArray::get(context_, element_values);
+            }
+            // Some element isn't a constant, so build them one by one.
+            next = first;
+        }
+
         llvm::SmallVector<llvm::Constant*> element_value_vec;
         for (auto i = 0; i < element_count; ++i) {
             index_list.push_back(i);
-            auto element_value = GetInitialValueForGlobalVariable(decl_node, element_type, index_list);
+            auto element_value = GetConstantInitializer(decl_node, element_type, index_list, next);
             index_list.pop_back();
             element_value_vec.push_back(element_value);
         }
@@ -648,193 +987,260 @@ llvm::Constant *CodeGen::GetInitialValueForGlobalVariable(
 
 llvm::Value* CodeGen::VisitGlobalVariableDecl(VariableDecl* decl_node) {
     auto variable_type = decl_node->GetCType();
-    auto variable_llvm_type = variable_type->Accept(this);
-    auto variable_name = decl_node->GetVariableName();
+    auto variable_llvm_type = VisitType(variable_type);
+    auto linkage = decl_node->storage_class_ == StorageClass::kStatic ?
+                        llvm::GlobalValue::InternalLinkage :
+                        llvm::GlobalValue::ExternalLinkage;
+    // NOTE:
+    // A static local variable is a global one as well, which is named after
+    // its function, e.g. `main.count`. LLVM renames it if the name is taken.
+    std::string variable_name = decl_node->GetVariableName().str();
+    if (!decl_node->is_global_) {
+        variable_name = (GetCurrentFunc()->getName() + "." + variable_name).str();
+    }
+    // A const object, or an array of them, is never written after being
+    // initialized, so it's put into the read-only data.
+    auto object_type = variable_type.get();
+    while (auto array_type = llvm::dyn_cast<CArrayType>(object_type)) {
+        object_type = array_type->GetElementType().get();
+    }
     auto variable_addr = new llvm::GlobalVariable(
                                             *module_,
                                             variable_llvm_type,
-                                            false, 
-                                            llvm::GlobalValue::ExternalLinkage,
+                                            object_type->IsConst(), 
+                                            linkage,
                                             nullptr,
                                             variable_name);
 
     variable_addr->setAlignment(llvm::Align(variable_type->GetAlign()));
 
     std::vector<int> index_list = { 0 };
-    variable_addr->setInitializer(GetInitialValueForGlobalVariable(decl_node, variable_llvm_type, index_list));
+    size_t next = 0;
+    variable_addr->setInitializer(GetConstantInitializer(decl_node, variable_llvm_type, index_list, next));
 
-    AddGlobalVariable(variable_name, variable_addr, variable_llvm_type);
+    AddVariable(decl_node, variable_addr, variable_llvm_type);
 
     return variable_addr;
 }
 
 llvm::Value *CodeGen::VisitLocalVariableDecl(VariableDecl* decl_node) {
+    // A scalar whose address is never taken isn't allocated in memory,
+    // its initial value is the first definition of it.
+    if (build_ssa_ && CanBeSSAVariable(decl_node)) {
+        ssa_variables_.insert(decl_node);
+        if (!decl_node->init_values_.empty()) {
+            auto init_value = Visit(decl_node->init_values_[0]->init_node);
+            CastValue(&init_value, VisitType(decl_node->GetCType()));
+            WriteVariable(decl_node, ir_builder_.GetInsertBlock(), init_value);
+        }
+        return nullptr;
+    }
+
     auto variable_type = decl_node->GetCType();
-    auto variable_llvm_type = decl_node->GetCType()->Accept(this);
+    auto variable_llvm_type = VisitType(decl_node->GetCType());
     auto variable_name = decl_node->GetVariableName();    
-    
-    llvm::IRBuilder tmp_ir_builder(
-                            &GetCurrentFunc()->getEntryBlock(), 
-                            GetCurrentFunc()->getEntryBlock().begin());
-    // NOTE: 
-    // We generate `alloca` instruction for local variable in entry basic block, 
-    // which is the start of a function.
-    // This is to help LLVM to generate more optimized machine code.
-    auto variable_addr = tmp_ir_builder.CreateAlloca(variable_llvm_type, nullptr, variable_name);
-    variable_addr->setAlignment(llvm::Align(variable_type->GetAlign()));
 
-    AddLocalVariable(variable_name, variable_addr, variable_llvm_type);
+    auto variable_addr = CreateEntryBlockAlloca(variable_type.get(), variable_name);
+
+    AddVariable(decl_node, variable_addr, variable_llvm_type);
+
+    // NOTE:
+    // The slot is allocated in the entry block, but the variable only lives
+    // from here to the end of its scope. Telling LLVM so lets the variables
+    // in disjoint scopes share their stack slots. It's not the case when
+    // a label in the scope lets a jump skip the declaration.
+    if (!local_scopes_.back().has_label) {
+        auto variable_size = module_->getDataLayout().getTypeAllocSize(variable_llvm_type);
+        ir_builder_.CreateLifetimeStart(variable_addr, ir_builder_.getInt64(variable_size));
+        local_scopes_.back().variables.push_back(variable_addr);
+    }
+
+    if (decl_node->init_values_.empty()) {
+        return variable_addr;
+    }
 
-    int nr_init_values = decl_node->init_values_.size();
-    if (nr_init_values > 0) {
-        if (nr_init_values == 1) {
-            auto init_value_struct = decl_node->init_values_[0];
-            auto init_value_type = decl_node->init_values_[0]->decl_type->Accept(this);
-            auto init_value = init_value_struct->init_node->Accept(this);
+    auto init_value_struct = decl_node->init_values_[0];
+    if (init_value_struct->index_list.size() == 1) {
+        // e.g. `int a = 1;` or `struct A b = a;`
+        auto init_value_type = VisitType(init_value_struct->decl_type);
+        auto init_value = Visit(init_value_struct->init_node);
+        if (init_value_struct->decl_type->GetKind() == CType::TypeKind::kRecord) {
+            EmitAggregateCopy(variable_addr, init_value, init_value_struct->decl_type.get());
+        } else {
             CastValue(&init_value, init_value_type);
-            ir_builder_.CreateStore(init_value, variable_addr);
-        }
-        else if (llvm::ArrayType* arr_llvm_type = llvm::dyn_cast<llvm::ArrayType>(variable_llvm_type)) {
-            for (const auto& init_value_struct : decl_node->init_values_) {
-                // Create llvm-style index list, by splicing `init_values_`list of `decl_node`.
-                llvm::SmallVector<llvm::Value*> llvm_index_list;
-                for (auto index : init_value_struct->index_list) {
-                    llvm_index_list.push_back(ir_builder_.getInt32(index));
-                }
-                // Create code to compute the address and value of this element.
-                auto element_addr = ir_builder_.CreateInBoundsGEP(
-                                                            arr_llvm_type,
-                                                            variable_addr,
-                                                            llvm_index_list);
-                auto element_value = init_value_struct->init_node->Accept(this);
-                // Force cast the type of element value.
-                auto element_type = init_value_struct->decl_type->Accept(this);
-                CastValue(&element_value, element_type);
-                // Create store code.
-                ir_builder_.CreateStore(element_value, element_addr);
-            }
-        }
-        else if (llvm::StructType* struct_llvm_type = llvm::dyn_cast<llvm::StructType>(variable_llvm_type)) {
-            auto record_type = llvm::dyn_cast<CRecordType>(variable_type.get());
-            auto record_tag_kind = record_type->GetTagKind();
-            switch (record_tag_kind) {
-                case CType::TagKind::kStruct: {
-                    for (const auto& init_value_struct : decl_node->init_values_) {
-                        llvm::SmallVector<llvm::Value*> llvm_index_list;
-                        for (auto index : init_value_struct->index_list) {
-                            llvm_index_list.push_back(ir_builder_.getInt32(index));
-                        }
-                        auto member_addr = ir_builder_.CreateInBoundsGEP(
-                                                                struct_llvm_type,
-                                                                variable_addr,
-                                                                llvm_index_list);
-                        auto member_value = init_value_struct->init_node->Accept(this);
-                        auto member_type = init_value_struct->decl_type->Accept(this);
-                        CastValue(&member_value, member_type);
-                        ir_builder_.CreateStore(member_value, member_addr);
-                    }
-                    break;
-                }
-                case CType::TagKind::kUnion: {
-                    auto init_value_struct = decl_node->init_values_[0];
-                    assert(decl_node->init_values_.size() == 1);
-                    
-                    llvm::SmallVector<llvm::Value*> llvm_index_list;
-
-                    assert(init_value_struct->index_list.size() == 2);
-                    for (auto index : init_value_struct->index_list) {
-                        llvm_index_list.push_back(ir_builder_.getInt32(index));
-                    }
-
-                    auto member_type = init_value_struct->decl_type->Accept(this);
-                    auto member_value = init_value_struct->init_node->Accept(this);
-                    auto member_pointer = ir_builder_.CreateInBoundsGEP(
-                                                            struct_llvm_type, 
-                                                            variable_addr, 
-                                                            llvm_index_list);
-                    auto vaild_pointer_llvm_type = llvm::PointerType::getUnqual(member_type);
-                    auto cast_pointer = ir_builder_.CreateBitCast(member_pointer, vaild_pointer_llvm_type);
-                    
-                    ir_builder_.CreateStore(member_value, cast_pointer);
-                    break;
-                }
-                default:
-                    assert(0);
-            }
-        }
-        else {
-            assert(0);
+            auto store = ir_builder_.CreateStore(init_value, variable_addr);
+            store->setMetadata(llvm::LLVMContext::MD_tbaa, GetTBAAScalarTag(init_value_struct->decl_type.get()));
         }
+    } else {
+        // e.g. `int a[3] = { 1, 2 };`
+        EmitLocalAggregateInit(decl_node, variable_addr);
     }
 
     return variable_addr;
 }
 
-llvm::Value* CodeGen::VisitVariableDecl(VariableDecl* decl_node) {
-    return decl_node->is_global_ ? 
-                VisitGlobalVariableDecl(decl_node) : 
-                VisitLocalVariableDecl(decl_node);
+// Return the byte offset of the object initialized by `index_list`,
+// relative to the variable of `ctype`.
+static size_t GetInitValueOffset(CType* ctype, llvm::ArrayRef<int> index_list) {
+    size_t offset = 0;
+    // The first index is always 0, which refers to the variable itself.
+    for (auto index : index_list.drop_front()) {
+        if (auto array_type = llvm::dyn_cast<CArrayType>(ctype)) {
+            ctype = array_type->GetElementType().get();
+            offset += index * ctype->GetSize();
+        } else {
+            const auto& member = llvm::cast<CRecordType>(ctype)->GetMembers()[index];
+            ctype = member.type.get();
+            offset += member.offset;
+        }
+    }
+    return offset;
 }
 
-llvm::Value *CodeGen::VisitPostIncExpr(PostIncExpr* expr) {
-    llvm::Value* value = expr->sub_node_->Accept(this);
-    llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(value);
-    assert(target);
+static bool ContainsUnion(CType* ctype) {
+    if (auto array_type = llvm::dyn_cast<CArrayType>(ctype)) {
+        return ContainsUnion(array_type->GetElementType().get());
+    }
+    if (auto record_type = llvm::dyn_cast<CRecordType>(ctype)) {
+        if (record_type->GetTagKind() == CType::TagKind::kUnion) {
+            return true;
+        }
+        for (const auto& member : record_type->GetMembers()) {
+            if (ContainsUnion(member.type.get())) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
 
-    llvm::Value* new_value;
+void CodeGen::EmitLocalAggregateInit(VariableDecl* decl_node, llvm::Value* variable_addr) {
+    // An initializer having more non-zero values than this is copied from
+    // a constant, instead of being stored value by value.
+    constexpr int kMaxInitStores = 16;
+
+    auto variable_type = decl_node->GetCType().get();
+    auto variable_llvm_type = VisitType(variable_type);
+    auto variable_size = variable_type->GetSize();
+    llvm::Align variable_align(variable_type->GetAlign());
+
+    // 1. Count the bytes and the non-zero values given by the initializer.
+    //    The LLVM type of a union is its largest member, which might not be
+    //    the initialized one, so a union is never built as a constant.
+    //    A record value, e.g. `a` in `{ a, 5 }`, covers all its bytes, and is
+    //    always copied, so it's neither a constant nor a zero.
+    size_t init_size = 0;
+    int nonzero_count = 0;
+    bool is_constant = !ContainsUnion(variable_type);
+    for (const auto& init_value_struct : decl_node->init_values_) {
+        auto init_kind = init_value_struct->decl_type->GetKind();
+        auto value = init_value_struct->init_node->GetConstantValue();
+        init_size += init_value_struct->decl_type->GetSize();
+        if (init_kind == CType::TypeKind::kRecord) {
+            is_constant = false;
+            ++nonzero_count;
+            continue;
+        }
+        if (!value || 
+            (init_kind != CType::TypeKind::kInt && init_kind != CType::TypeKind::kPointer))
+        {
+            is_constant = false;
+        }
+        if (!value || *value != 0) {
+            ++nonzero_count;
+        }
+    }
+
+    // 2. A dense constant initializer is copied from a private global,
+    //    which is much smaller than the code storing the values one by one.
+    if (is_constant && nonzero_count > kMaxInitStores) {
+        std::vector<int> index_list = { 0 };
+        size_t next = 0;
+        auto init_constant = GetConstantInitializer(decl_node, variable_llvm_type, index_list, next);
+        auto init_addr = new llvm::GlobalVariable(
+                                            *module_,
+                                            variable_llvm_type,
+                                            true,
+                                            llvm::GlobalValue::PrivateLinkage,
+                                            init_constant,
+                                            "__const." + GetCurrentFunc()->getName() + 
+                                            "." + decl_node->GetVariableName());
+        init_addr->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+        init_addr->setAlignment(variable_align);
+        ir_builder_.CreateMemCpy(variable_addr, variable_align, init_addr, variable_align, variable_size);
+        return;
+    }
+
+    // 3. Otherwise, zero the object unless the initializer covers it,
+    //    and then store the non-zero values one by one.
+    bool is_zeroed = init_size < variable_size;
+    if (is_zeroed) {
+        ir_builder_.CreateMemSet(variable_addr, ir_builder_.getInt8(0), variable_size, variable_align);
+    }
+    for (const auto& init_value_struct : decl_node->init_values_) {
+        auto value = init_value_struct->init_node->GetConstantValue();
+        if (is_zeroed && value && *value == 0) {
+            continue;
+        }
+
+        llvm::Value* element_addr = variable_addr;
+        if (auto offset = GetInitValueOffset(variable_type, init_value_struct->index_list)) {
+            element_addr = ir_builder_.CreateConstInBoundsGEP1_64(ir_builder_.getInt8Ty(), variable_addr, offset);
+        }
+        auto element_value = Visit(init_value_struct->init_node);
+        // e.g. `struct A ar[2] = { a, a };`, the element is copied from the address of `a`.
+        if (init_value_struct->decl_type->GetKind() == CType::TypeKind::kRecord) {
+            EmitAggregateCopy(element_addr, element_value, init_value_struct->decl_type.get());
+            continue;
+        }
+        // Force cast the type of element value.
+        CastValue(&element_value, VisitType(init_value_struct->decl_type));
+        auto store = ir_builder_.CreateStore(element_value, element_addr);
+        store->setMetadata(llvm::LLVMContext::MD_tbaa, GetTBAAScalarTag(init_value_struct->decl_type.get()));
+    }
+}
+
+llvm::Value* CodeGen::VisitVariableDecl(VariableDecl* decl_node) {
+    bool is_static = decl_node->storage_class_ == StorageClass::kStatic;
+    return decl_node->is_global_ || is_static ? 
+                VisitGlobalVariableDecl(decl_node) : 
+                VisitLocalVariableDecl(decl_node);
+}
+
+llvm::Value *CodeGen::VisitPostIncExpr(PostIncExpr* expr) {
     auto ctype = expr->sub_node_->GetCType();
+    auto addr = EmitLValue(expr->sub_node_);
+    llvm::Value* value = EmitLoadOfScalar(expr->sub_node_, addr);
+
+    llvm::Value* new_value;
     if (ctype->GetKind() == CType::TypeKind::kPointer) {
-        new_value = ir_builder_.CreateInBoundsGEP(ctype->Accept(this), value, { ir_builder_.getInt32(1) });
+        new_value = ir_builder_.CreateInBoundsGEP(VisitType(ctype), value, { ir_builder_.getInt32(1) });
     } else {
         new_value = ir_builder_.CreateNSWAdd(value, ir_builder_.getInt32(1));
     }
-    ir_builder_.CreateStore(new_value, target->getPointerOperand());
+    EmitStoreOfScalar(new_value, expr->sub_node_, addr);
 
     return value;
 }
 
 llvm::Value *CodeGen::VisitPostDecExpr(PostDecExpr* expr) {
-    llvm::Value* value = expr->sub_node_->Accept(this);
-    llvm::LoadInst* target = llvm::dyn_cast<llvm::LoadInst>(value);
-    assert(target);
+    auto ctype = expr->sub_node_->GetCType();
+    auto addr = EmitLValue(expr->sub_node_);
+    llvm::Value* value = EmitLoadOfScalar(expr->sub_node_, addr);
 
     llvm::Value* new_value;
-    auto ctype = expr->sub_node_->GetCType();
     if (ctype->GetKind() == CType::TypeKind::kPointer) {
-        new_value = ir_builder_.CreateInBoundsGEP(ctype->Accept(this), value, { ir_builder_.getInt32(-1) });
+        new_value = ir_builder_.CreateInBoundsGEP(VisitType(ctype), value, { ir_builder_.getInt32(-1) });
     } else {
         new_value = ir_builder_.CreateNSWSub(value, ir_builder_.getInt32(1));
     }
-    ir_builder_.CreateStore(new_value, target->getPointerOperand());
+    EmitStoreOfScalar(new_value, expr->sub_node_, addr);
 
     return value;
 }
 
 llvm::Value *CodeGen::VisitPostSubscript(PostSubscriptExpr* expr) {
-    llvm::Type* element_type = expr->GetCType()->Accept(this);
-    llvm::Value* target = expr->sub_node_->Accept(this);
-    llvm::Value* index = expr->index_node_->Accept(this);
-
-    llvm::Type* target_type = target->getType();
-    llvm::Value* element_addr = nullptr;
-    if (target_type->isArrayTy()) {
-        // Q: Why we should call `getPointerOperand()` method of `array` here?
-        // A: Get the first address of our target.
-        // For example, since `array` is an array pointer, for accessing `array[index]`, 
-        // we should get the array's starting address at first,
-        // instead of the value of the first element in this array, i.e. `*array`.
-        llvm::Value* array_addr = llvm::dyn_cast<llvm::LoadInst>(target)->getPointerOperand();
-        // Compute the address of `array[index]`.
-        element_addr = ir_builder_.CreateInBoundsGEP(element_type, array_addr, { index });
-    } 
-    else if (target_type->isPointerTy()) {
-        element_addr = ir_builder_.CreateInBoundsGEP(element_type, target, { index });
-    }
-    else {
-        assert(0);
-    }
-
-    return ir_builder_.CreateLoad(element_type, element_addr);
+    return EmitRValue(expr, EmitLValue(expr));
 }
 
 llvm::Value* CodeGen::VisitNumberExpr(NumberExpr *factor_expr) {
@@ -842,69 +1248,623 @@ llvm::Value* CodeGen::VisitNumberExpr(NumberExpr *factor_expr) {
 }
 
 llvm::Value *CodeGen::VisitPostMemberDotExpr(PostMemberDotExpr* expr) {
-    auto struct_object = expr->struct_node_->Accept(this);
-    auto struct_pointer = llvm::dyn_cast<llvm::LoadInst>(struct_object)->getPointerOperand();
-    
-    auto struct_type = llvm::dyn_cast<CRecordType>(expr->struct_node_->GetCType().get());
-    auto struct_llvm_type = struct_type->Accept(this);
-    
-    auto struct_tag = struct_type->GetTagKind();
+    return EmitRValue(expr, EmitLValue(expr));
+}
 
-    auto& struct_member = expr->target_member_;
-    auto struct_member_llvm_type = struct_member.type->Accept(this);
+llvm::Value *CodeGen::VisitPostMemberArrowExpr(PostMemberArrowExpr* expr) {
+    return EmitRValue(expr, EmitLValue(expr));
+}
 
-    auto zero = ir_builder_.getInt32(0);
-    switch (struct_tag) {
-        case CType::TagKind::kStruct: {
-            auto next = ir_builder_.getInt32(struct_member.rank);
-            auto member_addr = ir_builder_.CreateInBoundsGEP(
-                                                struct_llvm_type,
-                                                struct_pointer, 
-                                                { zero, next });
-            return ir_builder_.CreateLoad(struct_member_llvm_type, member_addr);
+llvm::Value *CodeGen::GetMemberAddress(
+    llvm::Value* record_addr,
+    CRecordType* record_type,
+    const CRecordType::Member& member)
+{
+    // NOTE:
+    // The GEP index has been computed together with the layout of the record,
+    // so there is no need to look the member up again.
+    auto member_addr = ir_builder_.CreateStructGEP(VisitType(record_type),
+                                                   record_addr,
+                                                   member.gep_index);
+    if (record_type->GetTagKind() == CType::TagKind::kUnion) {
+        // All the members of a union start at the same address,
+        // but it's typed as the largest member.
+        auto member_pointer_llvm_type = llvm::PointerType::getUnqual(VisitType(member.type));
+        member_addr = ir_builder_.CreateBitCast(member_addr, member_pointer_llvm_type);
+    }
+    return member_addr;
+}
+
+llvm::Value *CodeGen::EmitLValue(AstNode* node) {
+    switch (node->GetNodeKind()) {
+        case AstNode::AstNodeKind::kVariableAccessExpr: {
+            auto access_node = llvm::cast<VariableAccessExpr>(node);
+            // NOTE:
+            // A function may be declared more than once, or referred to
+            // in its own body before its `FuncDecl` is created,
+            // so we find it by the name in the module.
+            if (auto func_type = llvm::dyn_cast<CFuncType>(access_node->GetCType().get())) {
+                auto func = module_->getFunction(func_type->GetFuncName());
+                assert(func);
+                return func;
+            }
+            // An SSA variable has no address, see `EmitLoadOfScalar`.
+            if (IsSSAVariable(access_node->decl_)) {
+                return nullptr;
+            }
+            auto iter = variable_map_.find(access_node->decl_);
+            assert(iter != variable_map_.end());
+            return iter->second.first;
         }
-        case CType::TagKind::kUnion: {
-            auto member_pointer = ir_builder_.CreateInBoundsGEP(
-                                                    struct_llvm_type, 
-                                                    struct_pointer, 
-                                                    { zero, zero });
-            auto vaild_pointer_llvm_type = llvm::PointerType::getUnqual(struct_member_llvm_type);
-            auto cast_pointer = ir_builder_.CreateBitCast(member_pointer, vaild_pointer_llvm_type);
-            return ir_builder_.CreateLoad(struct_member_llvm_type, cast_pointer);   
+        case AstNode::AstNodeKind::kPostSubscriptExpr:
+        case AstNode::AstNodeKind::kPostMemberDotExpr:
+        case AstNode::AstNodeKind::kPostMemberArrowExpr:
+            return EmitAccessChain(node);
+        case AstNode::AstNodeKind::kUnaryExpr: {
+            auto expr = static_cast<UnaryExpr*>(node);
+            if (expr->op_ == UnaryOpCode::kDereference) {
+                return Visit(expr->sub_node_);
+            }
+            break;
         }
+        default:
+            break;
     }
 
-    return nullptr;
+    // The other aggregates, e.g. the result of `a = b` or `c ? a : b`,
+    // have been represented by their addresses already.
+    auto kind = node->GetCType()->GetKind();
+    assert(kind == CType::TypeKind::kRecord || kind == CType::TypeKind::kArray);
+    return Visit(node);
 }
 
-llvm::Value *CodeGen::VisitPostMemberArrowExpr(PostMemberArrowExpr* expr) {
-    auto struct_pointer = expr->struct_pointer_node_->Accept(this);
+// Return the object accessed by `node`, if the access can be folded into
+// the GEP of the object, i.e. `a[i]` of an array or `s.x` of a struct.
+static AstNode* GetFoldableObject(AstNode* node) {
+    switch (node->GetNodeKind()) {
+        case AstNode::AstNodeKind::kPostSubscriptExpr: {
+            auto object = llvm::cast<PostSubscriptExpr>(node)->sub_node_;
+            return object->GetCType()->GetKind() == CType::TypeKind::kArray ? object : nullptr;
+        }
+        case AstNode::AstNodeKind::kPostMemberDotExpr: {
+            auto object = llvm::cast<PostMemberDotExpr>(node)->struct_node_;
+            auto record_type = llvm::cast<CRecordType>(object->GetCType().get());
+            return record_type->GetTagKind() == CType::TagKind::kStruct ? object : nullptr;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+llvm::Value *CodeGen::EmitAccessChain(AstNode* node) {
+    // NOTE:
+    // The indices are sign-extended to the width of pointer, so that
+    // LLVM doesn't have to do it again for each address computation.
+    auto widen_index = [this](llvm::Value* index) {
+        return ir_builder_.CreateSExt(index, ir_builder_.getInt64Ty());
+    };
+
+    // 1. Collect the accesses from outside to inside, until we reach
+    //    the root one, which can't be folded into its object.
+    llvm::SmallVector<AstNode*, 8> chain = { node };
+    while (auto object = GetFoldableObject(chain.back())) {
+        chain.push_back(object);
+    }
+    auto root = chain.pop_back_val();
+
+    // 2. Compute the address where the GEP starts from.
+    llvm::Value* base_addr = nullptr;
+    llvm::Type* base_llvm_type = nullptr;
+    llvm::SmallVector<llvm::Value*, 8> indices;
+    switch (root->GetNodeKind()) {
+        // e.g. `p[i]` of a pointer `p`.
+        case AstNode::AstNodeKind::kPostSubscriptExpr: {
+            auto expr = llvm::cast<PostSubscriptExpr>(root);
+            base_addr = Visit(expr->sub_node_);
+            base_llvm_type = VisitType(expr->GetCType());
+            indices.push_back(widen_index(Visit(expr->index_node_)));
+            break;
+        }
+        // e.g. `u.x` of a union `u`.
+        case AstNode::AstNodeKind::kPostMemberDotExpr: {
+            auto expr = llvm::cast<PostMemberDotExpr>(root);
+            auto record_type = llvm::cast<CRecordType>(expr->struct_node_->GetCType().get());
+            base_addr = GetMemberAddress(EmitLValue(expr->struct_node_), record_type, expr->target_member_);
+            base_llvm_type = VisitType(expr->GetCType());
+            indices.push_back(ir_builder_.getInt64(0));
+            break;
+        }
+        // e.g. `p->x` of a pointer `p`.
+        case AstNode::AstNodeKind::kPostMemberArrowExpr: {
+            auto expr = llvm::cast<PostMemberArrowExpr>(root);
+            auto pointer_type = llvm::cast<CPointerType>(expr->struct_pointer_node_->GetCType().get());
+            auto record_type = llvm::cast<CRecordType>(pointer_type->GetBaseType().get());
+            base_addr = Visit(expr->struct_pointer_node_);
+            if (record_type->GetTagKind() == CType::TagKind::kStruct) {
+                base_llvm_type = VisitType(record_type);
+                indices.push_back(ir_builder_.getInt64(0));
+                indices.push_back(ir_builder_.getInt32(expr->target_member_.gep_index));
+            } else {
+                base_addr = GetMemberAddress(base_addr, record_type, expr->target_member_);
+                base_llvm_type = VisitType(expr->GetCType());
+                indices.push_back(ir_builder_.getInt64(0));
+            }
+            break;
+        }
+        // e.g. `a` of `a[i]`.
+        default: {
+            base_addr = EmitLValue(root);
+            base_llvm_type = VisitType(root->GetCType());
+            indices.push_back(ir_builder_.getInt64(0));
+            break;
+        }
+    }
 
-    auto struct_pointer_type = llvm::dyn_cast<CPointerType>(expr->struct_pointer_node_->GetCType().get());
-    auto struct_type = llvm::dyn_cast<CRecordType>(struct_pointer_type->GetBaseType().get());
+    // 3. Append the index of each folded access, from inside to outside,
+    //    which is also the order to evaluate them.
+    for (auto iter = chain.rbegin(); iter != chain.rend(); ++iter) {
+        if (auto expr = llvm::dyn_cast<PostSubscriptExpr>(*iter)) {
+            indices.push_back(widen_index(Visit(expr->index_node_)));
+        } else {
+            auto member_expr = llvm::cast<PostMemberDotExpr>(*iter);
+            indices.push_back(ir_builder_.getInt32(member_expr->target_member_.gep_index));
+        }
+    }
 
-    auto struct_llvm_type = struct_type->Accept(this);
-    auto struct_tag = struct_type->GetTagKind();
+    if (indices.size() == 1) {
+        if (auto constant = llvm::dyn_cast<llvm::ConstantInt>(indices[0]); constant && constant->isZero()) {
+            return base_addr;
+        }
+    }
+    return ir_builder_.CreateInBoundsGEP(base_llvm_type, base_addr, indices);
+}
+
+llvm::Value *CodeGen::EmitRValue(AstNode* node, llvm::Value* addr, const llvm::Twine& name) {
+    auto ctype = node->GetCType().get();
+    switch (ctype->GetKind()) {
+        case CType::TypeKind::kArray:
+        case CType::TypeKind::kRecord:
+        case CType::TypeKind::kFunc:
+            return addr;
+        default:
+            break;
+    }
 
-    auto& struct_member = expr->target_member_;
-    auto struct_member_llvm_type = struct_member.type->Accept(this);
+    // A load from a const global at a constant address, e.g. `table[2]`,
+    // is replaced with the value in its initializer.
+    auto llvm_type = VisitType(ctype);
+    if (auto const_addr = llvm::dyn_cast<llvm::Constant>(addr)) {
+        if (auto value = llvm::ConstantFoldLoadFromConstPtr(const_addr, llvm_type, module_->getDataLayout())) {
+            return value;
+        }
+    }
+    auto load = ir_builder_.CreateLoad(llvm_type, addr, name);
+    SetAccessMetadata(load, node);
+    return load;
+}
 
-    auto zero = ir_builder_.getInt32(0);
-    switch (struct_tag) {
-        case CType::TagKind::kStruct: {
-            auto next = ir_builder_.getInt32(struct_member.rank);
-            auto member_addr = ir_builder_.CreateInBoundsGEP(struct_llvm_type, struct_pointer, { zero, next });
-            return ir_builder_.CreateLoad(struct_member_llvm_type, member_addr);
+llvm::Value *CodeGen::EmitLoadOfScalar(AstNode* node, llvm::Value* addr) {
+    if (auto access_node = llvm::dyn_cast<VariableAccessExpr>(node)) {
+        if (IsSSAVariable(access_node->decl_)) {
+            return ReadVariable(access_node->decl_, ir_builder_.GetInsertBlock());
         }
-        case CType::TagKind::kUnion: {
-            auto member_pointer = ir_builder_.CreateInBoundsGEP(struct_llvm_type, struct_pointer, { zero, zero });
-            auto vaild_pointer_llvm_type = llvm::PointerType::getUnqual(struct_member_llvm_type);
-            auto cast_pointer = ir_builder_.CreateBitCast(member_pointer, vaild_pointer_llvm_type);
-            return ir_builder_.CreateLoad(struct_member_llvm_type, cast_pointer);
+    }
+    auto load = ir_builder_.CreateLoad(VisitType(node->GetCType()), addr);
+    SetAccessMetadata(load, node);
+    return load;
+}
+
+void CodeGen::EmitStoreOfScalar(llvm::Value* value, AstNode* node, llvm::Value* addr) {
+    if (auto access_node = llvm::dyn_cast<VariableAccessExpr>(node)) {
+        if (IsSSAVariable(access_node->decl_)) {
+            CastValue(&value, VisitType(node->GetCType()));
+            WriteVariable(access_node->decl_, ir_builder_.GetInsertBlock(), value);
+            return;
         }
     }
+    auto store = ir_builder_.CreateStore(value, addr);
+    SetAccessMetadata(store, node);
+}
 
-    return nullptr;
+// Name the scalar types like `int`, `int*` and `struct A*` for TBAA,
+// the qualifiers of which don't matter.
+static std::string GetTBAATypeName(CType* ctype) {
+    switch (ctype->GetKind()) {
+        case CType::TypeKind::kInt:
+            return "int";
+        case CType::TypeKind::kVoid:
+            return "void";
+        case CType::TypeKind::kPointer:
+            return GetTBAATypeName(llvm::cast<CPointerType>(ctype)->GetBaseType().get()) + "*";
+        case CType::TypeKind::kArray:
+            return GetTBAATypeName(llvm::cast<CArrayType>(ctype)->GetElementType().get()) + "[]";
+        case CType::TypeKind::kRecord: {
+            auto record_type = llvm::cast<CRecordType>(ctype);
+            bool is_struct = record_type->GetTagKind() == CType::TagKind::kStruct;
+            return (is_struct ? "struct " : "union ") + record_type->GetName().str();
+        }
+        case CType::TypeKind::kFunc:
+            return "func";
+    }
+    return "";
+}
+
+llvm::MDNode* CodeGen::GetTBAATypeNode(CType* ctype) {
+    llvm::MDBuilder md_builder(context_);
+    if (!tbaa_root_) {
+        tbaa_root_ = md_builder.createTBAARoot("NaiveC TBAA");
+        tbaa_char_ = md_builder.createTBAAScalarTypeNode("omnipotent char", tbaa_root_);
+        tbaa_any_pointer_ = md_builder.createTBAAScalarTypeNode("any pointer", tbaa_char_);
+    }
+
+    switch (ctype->GetKind()) {
+        case CType::TypeKind::kInt: {
+            auto& node = tbaa_scalar_types_["int"];
+            if (!node) {
+                node = md_builder.createTBAAScalarTypeNode("int", tbaa_char_);
+            }
+            return node;
+        }
+        case CType::TypeKind::kPointer: {
+            // NOTE: `void*` may point to anything, like `char*`.
+            auto base_kind = llvm::cast<CPointerType>(ctype)->GetBaseType()->GetKind();
+            if (base_kind == CType::TypeKind::kVoid || base_kind == CType::TypeKind::kFunc) {
+                return tbaa_any_pointer_;
+            }
+            auto name = GetTBAATypeName(ctype);
+            auto& node = tbaa_scalar_types_[name];
+            if (!node) {
+                node = md_builder.createTBAAScalarTypeNode(name, tbaa_any_pointer_);
+            }
+            return node;
+        }
+        // The members of an array in a struct are described by their element type.
+        case CType::TypeKind::kArray:
+            return GetTBAATypeNode(llvm::cast<CArrayType>(ctype)->GetElementType().get());
+        case CType::TypeKind::kRecord: {
+            auto record_type = llvm::cast<CRecordType>(ctype);
+            if (record_type->GetTagKind() == CType::TagKind::kStruct) {
+                return GetTBAAStructTypeNode(record_type);
+            }
+            // The members of a union overlap, so any of them may be accessed
+            // through the others.
+            return tbaa_char_;
+        }
+        default:
+            return tbaa_char_;
+    }
+}
+
+llvm::MDNode* CodeGen::GetTBAAStructTypeNode(CRecordType* record_type) {
+    auto iter = tbaa_struct_types_.find(record_type);
+    if (iter != tbaa_struct_types_.end()) {
+        return iter->second;
+    }
+
+    // NOTE:
+    // A struct can only refer to itself through a pointer member, which
+    // is a scalar type node, so the recursion always ends.
+    llvm::SmallVector<std::pair<llvm::MDNode*, uint64_t>> fields;
+    for (const auto& member : record_type->GetMembers()) {
+        fields.push_back({ GetTBAATypeNode(member.type.get()), member.offset });
+    }
+    llvm::MDBuilder md_builder(context_);
+    auto node = md_builder.createTBAAStructTypeNode("struct " + record_type->GetName().str(), fields);
+    tbaa_struct_types_.insert({ record_type, node });
+    return node;
+}
+
+llvm::MDNode* CodeGen::GetTBAAScalarTag(CType* ctype) {
+    auto type_node = GetTBAATypeNode(ctype);
+    return llvm::MDBuilder(context_).createTBAAStructTagNode(type_node, type_node, 0);
+}
+
+llvm::MDNode* CodeGen::GetTBAAAccessTag(AstNode* node) {
+    // Walk through the members from outside to inside, e.g. `c`, `b` and then
+    // `p->a` of `p->a.b.c`, adding up their offsets in the outermost struct.
+    CRecordType* base_type = nullptr;
+    uint64_t offset = 0;
+    for (auto iter = node; iter;) {
+        const CRecordType::Member* member = nullptr;
+        AstNode* next = nullptr;
+        if (auto expr = llvm::dyn_cast<PostMemberDotExpr>(iter)) {
+            base_type = llvm::cast<CRecordType>(expr->struct_node_->GetCType().get());
+            member = &expr->target_member_;
+            next = expr->struct_node_;
+        } else if (auto expr = llvm::dyn_cast<PostMemberArrowExpr>(iter)) {
+            auto pointer_type = llvm::cast<CPointerType>(expr->struct_pointer_node_->GetCType().get());
+            base_type = llvm::cast<CRecordType>(pointer_type->GetBaseType().get());
+            member = &expr->target_member_;
+        } else {
+            break;
+        }
+        if (base_type->GetTagKind() == CType::TagKind::kUnion) {
+            return GetTBAAScalarTag(base_type);
+        }
+        offset += member->offset;
+        iter = next;
+    }
+
+    if (!base_type) {
+        return GetTBAAScalarTag(node->GetCType().get());
+    }
+    return llvm::MDBuilder(context_).createTBAAStructTagNode(
+                                            GetTBAAStructTypeNode(base_type),
+                                            GetTBAATypeNode(node->GetCType().get()),
+                                            offset);
+}
+
+// Find the variable from which the pointer `node` is computed, e.g. `p` of
+// `p + 1`. If `node` is an array, it's the variable through which the array
+// is accessed, e.g. `p` of `p->ar`.
+static AstNode* GetAccessBaseDecl(AstNode* node);
+
+static AstNode* GetPointerBaseDecl(AstNode* node) {
+    if (node->GetCType()->GetKind() == CType::TypeKind::kArray) {
+        return GetAccessBaseDecl(node);
+    }
+    switch (node->GetNodeKind()) {
+        case AstNode::AstNodeKind::kVariableAccessExpr:
+            return static_cast<VariableAccessExpr*>(node)->decl_;
+        case AstNode::AstNodeKind::kBinaryExpr: {
+            auto expr = static_cast<BinaryExpr*>(node);
+            if (expr->op_ != BinaryOpCode::kAdd && expr->op_ != BinaryOpCode::kSub) {
+                return nullptr;
+            }
+            auto left_kind = expr->left_->GetCType()->GetKind();
+            if (left_kind == CType::TypeKind::kPointer || left_kind == CType::TypeKind::kArray) {
+                return GetPointerBaseDecl(expr->left_);
+            }
+            // e.g. `1 + p`
+            return GetPointerBaseDecl(expr->right_);
+        }
+        default:
+            return nullptr;
+    }
+}
+
+// Find the variable through which the lvalue `node` is accessed,
+// e.g. `p` of `*p`, `p[i]`, `p->a.b` and `p->ar[i]`.
+static AstNode* GetAccessBaseDecl(AstNode* node) {
+    switch (node->GetNodeKind()) {
+        case AstNode::AstNodeKind::kUnaryExpr: {
+            auto expr = static_cast<UnaryExpr*>(node);
+            if (expr->op_ == UnaryOpCode::kDereference) {
+                return GetPointerBaseDecl(expr->sub_node_);
+            }
+            return nullptr;
+        }
+        case AstNode::AstNodeKind::kPostSubscriptExpr:
+            return GetPointerBaseDecl(static_cast<PostSubscriptExpr*>(node)->sub_node_);
+        case AstNode::AstNodeKind::kPostMemberDotExpr:
+            return GetAccessBaseDecl(static_cast<PostMemberDotExpr*>(node)->struct_node_);
+        case AstNode::AstNodeKind::kPostMemberArrowExpr:
+            return GetPointerBaseDecl(static_cast<PostMemberArrowExpr*>(node)->struct_pointer_node_);
+        default:
+            return nullptr;
+    }
+}
+
+void CodeGen::CreateRestrictScopes(FuncDecl* func_decl) {
+    restrict_scopes_.clear();
+
+    llvm::SmallVector<AstNode*> restrict_decls;
+    auto add_if_restrict = [&](AstNode* node) {
+        auto decl = llvm::dyn_cast<VariableDecl>(node);
+        if (!decl || !decl->GetCType()->IsRestrict() || decl->storage_class_ == StorageClass::kStatic) {
+            return;
+        }
+        // NOTE:
+        // Copying a restrict pointer to another one in the same block, like
+        // `int* restrict q = p;`, is undefined behavior, but it's common.
+        // Leave `q` alone then, so that it may still alias `p`.
+        if (!decl->init_values_.empty() && 
+            llvm::is_contained(restrict_decls, GetPointerBaseDecl(decl->init_values_[0]->init_node)))
+        {
+            return;
+        }
+        restrict_decls.push_back(decl);
+    };
+    for (auto param : func_decl->params_) {
+        add_if_restrict(param);
+    }
+    for (auto node : llvm::cast<BlockStmt>(func_decl->block_stmt_)->nodes_) {
+        if (auto decl_stmt = llvm::dyn_cast<DeclStmt>(node)) {
+            llvm::for_each(decl_stmt->nodes_, add_if_restrict);
+        } else {
+            add_if_restrict(node);
+        }
+    }
+    // NOTE: A single scope can't tell anything.
+    if (restrict_decls.size() < 2) {
+        return;
+    }
+
+    llvm::MDBuilder md_builder(context_);
+    auto domain = md_builder.createAnonymousAliasScopeDomain(func_decl->GetBoundToken().GetContent());
+    llvm::SmallVector<llvm::Metadata*> scopes;
+    for (auto decl : restrict_decls) {
+        scopes.push_back(md_builder.createAnonymousAliasScope(domain, decl->GetBoundToken().GetContent()));
+    }
+    for (size_t i = 0; i < restrict_decls.size(); ++i) {
+        llvm::SmallVector<llvm::Metadata*> other_scopes(scopes.begin(), scopes.end());
+        other_scopes.erase(other_scopes.begin() + i);
+        restrict_scopes_.insert({ restrict_decls[i], 
+                                  { llvm::MDNode::get(context_, scopes[i]),
+                                    llvm::MDNode::get(context_, other_scopes) } });
+    }
+}
+
+void CodeGen::SetAccessMetadata(llvm::Instruction* inst, AstNode* node) {
+    inst->setMetadata(llvm::LLVMContext::MD_tbaa, GetTBAAAccessTag(node));
+
+    if (restrict_scopes_.empty()) {
+        return;
+    }
+    auto base_decl = GetAccessBaseDecl(node);
+    auto iter = restrict_scopes_.find(base_decl);
+    if (iter != restrict_scopes_.end()) {
+        inst->setMetadata(llvm::LLVMContext::MD_alias_scope, iter->second.scope_list);
+        inst->setMetadata(llvm::LLVMContext::MD_noalias, iter->second.noalias_list);
+    }
+}
+
+bool CodeGen::CanBeSSAVariable(const VariableDecl* decl_node) {
+    if (decl_node->is_global_ || 
+        decl_node->storage_class_ == StorageClass::kStatic || 
+        decl_node->is_address_taken_) 
+    {
+        return false;
+    }
+    auto kind = decl_node->GetCType()->GetKind();
+    return kind == CType::TypeKind::kInt || kind == CType::TypeKind::kPointer;
+}
+
+bool CodeGen::IsSSAVariable(AstNode* decl) const {
+    return ssa_variables_.count(decl);
+}
+
+void CodeGen::WriteVariable(AstNode* decl, llvm::BasicBlock* block, llvm::Value* value) {
+    current_defs_[block][decl] = value;
+}
+
+llvm::Value *CodeGen::ReadVariable(AstNode* decl, llvm::BasicBlock* block) {
+    auto block_iter = current_defs_.find(block);
+    if (block_iter != current_defs_.end()) {
+        auto iter = block_iter->second.find(decl);
+        if (iter != block_iter->second.end()) {
+            return iter->second;
+        }
+    }
+    return ReadVariableRecursive(decl, block);
+}
+
+// Create an empty PHI node for `decl` at the beginning of `block`.
+static llvm::PHINode* CreateVariablePhi(llvm::Type* llvm_type, AstNode* decl, llvm::BasicBlock* block) {
+    auto name = llvm::cast<VariableDecl>(decl)->GetVariableName();
+    if (auto first_inst = block->getFirstNonPHI()) {
+        return llvm::PHINode::Create(llvm_type, 0, name, first_inst);
+    }
+    return llvm::PHINode::Create(llvm_type, 0, name, block);
+}
+
+llvm::Value *CodeGen::ReadVariableRecursive(AstNode* decl, llvm::BasicBlock* block) {
+    auto llvm_type = VisitType(decl->GetCType());
+    llvm::Value* value = nullptr;
+    if (!sealed_blocks_.count(block)) {
+        // The predecessors aren't all known yet,
+        // so leave the operands to be added when the block is sealed.
+        auto phi = CreateVariablePhi(llvm_type, decl, block);
+        incomplete_phis_[block].push_back({ decl, phi });
+        value = phi;
+    } else if (auto pred = block->getSinglePredecessor()) {
+        // No PHI node is needed.
+        value = ReadVariable(decl, pred);
+    } else if (llvm::pred_empty(block)) {
+        // The variable is read before it's initialized,
+        // or the block is unreachable.
+        value = llvm::UndefValue::get(llvm_type);
+    } else {
+        // Break the cycles of the lookup by defining the variable
+        // with the PHI node before reading it from the predecessors.
+        auto phi = CreateVariablePhi(llvm_type, decl, block);
+        WriteVariable(decl, block, phi);
+        value = AddPhiOperands(decl, phi);
+    }
+    WriteVariable(decl, block, value);
+    return value;
+}
+
+llvm::Value *CodeGen::AddPhiOperands(AstNode* decl, llvm::PHINode* phi) {
+    for (auto pred : llvm::predecessors(phi->getParent())) {
+        phi->addIncoming(ReadVariable(decl, pred), pred);
+    }
+    return TryRemoveTrivialPhi(phi);
+}
+
+llvm::Value *CodeGen::TryRemoveTrivialPhi(llvm::PHINode* phi) {
+    llvm::Value* same = nullptr;
+    for (auto& op : phi->incoming_values()) {
+        if (op == same || op == phi) {
+            continue;
+        }
+        if (same) {
+            // The PHI node merges at least two values, so it isn't trivial.
+            return phi;
+        }
+        same = op;
+    }
+    if (!same) {
+        // The PHI node is unreachable or in the entry block.
+        same = llvm::UndefValue::get(phi->getType());
+    }
+
+    // Replace all the uses of the PHI node, including the definitions
+    // recorded in `current_defs_`, since they are tracking handles.
+    llvm::SmallVector<llvm::WeakVH> phi_users;
+    for (auto user : phi->users()) {
+        if (user != phi && llvm::isa<llvm::PHINode>(user)) {
+            phi_users.push_back(user);
+        }
+    }
+    llvm::WeakTrackingVH result = same;
+    phi->replaceAllUsesWith(same);
+    phi->eraseFromParent();
+
+    // The PHI nodes using the removed one might become trivial now.
+    for (auto& user : phi_users) {
+        if (auto user_phi = llvm::dyn_cast_or_null<llvm::PHINode>(user)) {
+            TryRemoveTrivialPhi(user_phi);
+        }
+    }
+    return result;
+}
+
+void CodeGen::SealBlock(llvm::BasicBlock* block) {
+    if (!build_ssa_) {
+        return;
+    }
+    // NOTE:
+    // The block is sealed before completing its PHI nodes, so the variables
+    // read from it meanwhile get their PHI nodes completed at once.
+    sealed_blocks_.insert(block);
+    auto iter = incomplete_phis_.find(block);
+    if (iter != incomplete_phis_.end()) {
+        auto phis = std::move(iter->second);
+        incomplete_phis_.erase(iter);
+        for (auto [decl, phi] : phis) {
+            AddPhiOperands(decl, phi);
+        }
+    }
+}
+
+void CodeGen::EmitAggregateCopy(llvm::Value* dest_addr, llvm::Value* src_addr, CType* ctype) {
+    llvm::Align align(ctype->GetAlign());
+    ir_builder_.CreateMemCpy(dest_addr, align, src_addr, align, ctype->GetSize());
+}
+
+llvm::AllocaInst *CodeGen::CreateEntryBlockAlloca(CType* ctype, const llvm::Twine& name) {
+    llvm::IRBuilder tmp_ir_builder(
+                            &GetCurrentFunc()->getEntryBlock(), 
+                            GetCurrentFunc()->getEntryBlock().begin());
+    // NOTE: 
+    // We generate `alloca` instruction for local variable in entry basic block, 
+    // which is the start of a function.
+    // This is to help LLVM to generate more optimized machine code.
+    auto addr = tmp_ir_builder.CreateAlloca(VisitType(ctype), nullptr, name);
+    addr->setAlignment(llvm::Align(ctype->GetAlign()));
+    return addr;
+}
+
+llvm::Type *CodeGen::VisitType(CType* ctype) {
+    auto iter = llvm_type_map_.find(ctype);
+    if (iter != llvm_type_map_.end()) {
+        return iter->second;
+    }
+
+    auto llvm_type = StaticTypeVisitor::VisitType(ctype);
+    llvm_type_map_[ctype] = llvm_type;
+    return llvm_type;
 }
 
 llvm::Type *CodeGen::VisitPrimaryType(CPrimaryType* ctype) {
@@ -920,30 +1880,29 @@ llvm::Type *CodeGen::VisitPrimaryType(CPrimaryType* ctype) {
 }
 
 llvm::Type* CodeGen::VisitPointerType(CPointerType* ctype) {
-    llvm::Type* base_type = ctype->GetBaseType()->Accept(this);
+    llvm::Type* base_type = VisitType(ctype->GetBaseType());
     return llvm::PointerType::getUnqual(base_type);
 }
 
 llvm::Type* CodeGen::VisitArrayType(CArrayType* ctype) {
-    llvm::Type* element_type = ctype->GetElementType()->Accept(this);
+    llvm::Type* element_type = VisitType(ctype->GetElementType());
     return llvm::ArrayType::get(element_type, ctype->GetElementCount());
 }
 
 llvm::Type* CodeGen::VisitRecordType(CRecordType* ctype) {
-    auto struct_type_name = ctype->GetName();
-    auto struct_type = llvm::StructType::getTypeByName(context_, struct_type_name);
-    if (struct_type) {
-        return struct_type;
-    }
-
-    struct_type = llvm::StructType::create(context_, struct_type_name);
+    auto struct_type = llvm::StructType::create(context_, ctype->GetName());
+    // NOTE:
+    // Save the struct type before lowering its members,
+    // since a member might point to the struct itself,
+    // e.g. `struct Node { struct Node *next; };`
+    llvm_type_map_[ctype] = struct_type;
 
     auto tag_kind = ctype->GetTagKind();
     switch (tag_kind) {
         case CType::TagKind::kStruct: {
             llvm::SmallVector<llvm::Type*> member_type_vec;
             for (const auto& member : ctype->GetMembers()) {
-                member_type_vec.push_back(member.type->Accept(this));
+                member_type_vec.push_back(VisitType(member.type));
             }
             struct_type->setBody(member_type_vec);
             break;
@@ -951,7 +1910,7 @@ llvm::Type* CodeGen::VisitRecordType(CRecordType* ctype) {
         case CType::TagKind::kUnion: {
             auto& members = ctype->GetMembers();
             auto rank = ctype->GetMaxSizeMemberRank();
-            auto llvm_type = members[rank].type->Accept(this);
+            auto llvm_type = VisitType(members[rank].type);
             struct_type->setBody(llvm_type);
             break;
         }
@@ -964,11 +1923,8 @@ llvm::Type* CodeGen::VisitRecordType(CRecordType* ctype) {
 }
 
 llvm::Value *CodeGen::VisitFuncDecl(FuncDecl* func_decl) {
-    // We assume that you cannot nest a new function within a function.
-    ClearVariableScope();
-
     auto func_type = llvm::dyn_cast<CFuncType>(func_decl->GetCType().get());
-    auto func_llvm_type = llvm::dyn_cast<llvm::FunctionType>(func_type->Accept(this));
+    auto func_llvm_type = llvm::dyn_cast<llvm::FunctionType>(VisitType(func_type));
     auto func_name = func_type->GetFuncName();
 
     auto func = module_->getFunction(func_name);
@@ -981,73 +1937,121 @@ llvm::Value *CodeGen::VisitFuncDecl(FuncDecl* func_decl) {
                                       module_.get());
     }
 
-    // 2. Save function instance to global variable map.
-    AddGlobalVariable(func_name, func, func_llvm_type);
-
-    // 3. Process function's parameters.
+    // 2. Process function's parameters.
     const auto& params = func_type->GetParams();
     int i = 0;
     for (auto& arg : func->args()) {
         arg.setName(params[i++].name);
     }
 
-    // 4.1 Does the function have valid body?
+    // 2.1 Lower the GNU attributes, e.g. `__attribute__((noreturn))`.
+    AddFuncAttrs(func, func_type);
+
+    // 3.1 Does the function have valid body?
     //     If not, return the object directly.
     if (func_decl->block_stmt_ == nullptr) {
         return func;
     }
 
-    // 4.2 If yes, create the entry block for the function.
+    // 3.2 If yes, the definition decides the linkage of the function.
+    //     Note that a declaration without body must be external.
+    func->setLinkage(GetFuncLinkage(func_decl));
+    if (func_decl->is_inline_) {
+        func->addFnAttr(llvm::Attribute::InlineHint);
+    }
+
+    // 3.3 Tell LLVM what the parameter declarations promise, e.g. `int* restrict p`
+    //     doesn't alias the other pointers, and `int a[static 3]` points to 3 ints.
+    //     NOTE: Only the definition counts, since the qualifiers of a parameter
+    //     in a prototype don't apply to the function, e.g. `int f(int* restrict);`.
+    assert(func_decl->params_.size() == func->arg_size());
+    for (auto& arg : func->args()) {
+        auto param_decl = llvm::cast<VariableDecl>(func_decl->params_[arg.getArgNo()]);
+        auto param_ctype = param_decl->GetCType();
+        if (param_ctype->IsRestrict()) {
+            arg.addAttr(llvm::Attribute::NoAlias);
+        }
+        if (param_decl->static_array_size_ > 0) {
+            auto element_size = llvm::cast<CPointerType>(param_ctype.get())->GetBaseType()->GetSize();
+            arg.addAttr(llvm::Attribute::NonNull);
+            arg.addAttr(llvm::Attribute::getWithDereferenceableBytes(
+                                            context_, param_decl->static_array_size_ * element_size));
+        }
+    }
+
+    // 3.4 Create the entry block for the function.
     //     and going to generate its inner code.
     auto entry_block = llvm::BasicBlock::Create(context_, "entry", func);
     ir_builder_.SetInsertPoint(entry_block);
     SetCurrentFunc(func);
 
-    PushScope();
-    {
-        // 5. Alloc space for the arguments of the function.
-        for (auto& arg : func->args()) {
-            auto arg_addr = ir_builder_.CreateAlloca(arg.getType(), nullptr, arg.getName());
-            arg_addr->setAlignment(arg.getParamAlign().valueOrOne());
-            ir_builder_.CreateStore(&arg, arg_addr);
+    current_defs_.clear();
+    sealed_blocks_.clear();
+    ssa_variables_.clear();
+    SealBlock(entry_block);
+
+    label_stmts_.clear();
+    goto_label_count_ = 0;
+    CollectLabelStmts(func_decl->block_stmt_);
+    CreateRestrictScopes(func_decl);
+    is_flatten_ = func_type->HasAttr(FuncAttr::kFlatten);
 
-            AddLocalVariable(arg.getName(), arg_addr, arg.getType());
+    // 4. Alloc space for the arguments of the function.
+    //    The ones which can be SSA variables are defined by the arguments.
+    for (auto& arg : func->args()) {
+        auto param_decl = llvm::cast<VariableDecl>(func_decl->params_[arg.getArgNo()]);
+        if (build_ssa_ && CanBeSSAVariable(param_decl)) {
+            ssa_variables_.insert(param_decl);
+            WriteVariable(param_decl, entry_block, &arg);
+            continue;
         }
 
-        // 6.Generate inner code for function's block statement.
-        func_decl->block_stmt_->Accept(this);     
-        assert(GetCurrentFunc() == func);
+        auto arg_addr = ir_builder_.CreateAlloca(arg.getType(), nullptr, arg.getName());
+        arg_addr->setAlignment(arg.getParamAlign().valueOrOne());
+        auto store = ir_builder_.CreateStore(&arg, arg_addr);
+        // NOTE: A record is copied as a whole, which isn't described by TBAA.
+        auto param_ctype = param_decl->GetCType().get();
+        if (param_ctype->GetKind() != CType::TypeKind::kRecord) {
+            store->setMetadata(llvm::LLVMContext::MD_tbaa, GetTBAAScalarTag(param_ctype));
+        }
 
-        // 7. Generate default `return` instruction for function's block statement.
-        const auto& back_block = func->back();
-        if (back_block.empty() || 
-            !llvm::isa<llvm::ReturnInst>(back_block.back())) 
-        {
-            switch (func_type->GetRetType()->GetKind()) {
-                case CType::TypeKind::kVoid: {
-                    ir_builder_.CreateRetVoid();
-                    break;                    
-                }
-                case CType::TypeKind::kInt: {
-                    ir_builder_.CreateRet(ir_builder_.getInt32(0));
-                    break;                    
-                }
-                case CType::TypeKind::kPointer: {
-                    auto ret_type = func_llvm_type->getReturnType();
-                    auto pointer_type = llvm::dyn_cast<llvm::PointerType>(ret_type);
-                    auto null_ret_val = llvm::ConstantPointerNull::get(pointer_type);
-                    ir_builder_.CreateRet(null_ret_val);
-                    break;                    
-                }
-                default: {
-                    assert(0);
-                }
+        AddVariable(param_decl, arg_addr, arg.getType());
+    }
+
+    // 5.Generate inner code for function's block statement.
+    Visit(func_decl->block_stmt_);     
+    assert(GetCurrentFunc() == func);
+
+    // 6. Generate default `return` instruction for function's block statement,
+    //    if its end can be reached.
+    if (HaveInsertPoint()) {
+        switch (func_type->GetRetType()->GetKind()) {
+            case CType::TypeKind::kVoid: {
+                ir_builder_.CreateRetVoid();
+                break;                    
+            }
+            case CType::TypeKind::kInt: {
+                ir_builder_.CreateRet(ir_builder_.getInt32(0));
+                break;                    
+            }
+            case CType::TypeKind::kPointer: {
+                auto ret_type = func_llvm_type->getReturnType();
+                auto pointer_type = llvm::dyn_cast<llvm::PointerType>(ret_type);
+                auto null_ret_val = llvm::ConstantPointerNull::get(pointer_type);
+                ir_builder_.CreateRet(null_ret_val);
+                break;                    
+            }
+            default: {
+                assert(0);
             }
         }
     }
-    PopScope();
+
+    // 7. All the jumps to the labels have been generated.
+    FinishLabels();
 
     assert(GetCurrentFunc() == func);
+    assert(incomplete_phis_.empty());
 
     assert(!llvm::verifyFunction(*func, &llvm::outs()));
     assert(!llvm::verifyModule(*module_, &llvm::outs()));
@@ -1055,11 +2059,70 @@ llvm::Value *CodeGen::VisitFuncDecl(FuncDecl* func_decl) {
     return func;
 }
 
+llvm::GlobalValue::LinkageTypes CodeGen::GetFuncLinkage(const FuncDecl* func_decl) {
+    auto func_type = llvm::cast<CFuncType>(func_decl->GetCType().get());
+
+    // `main` is called by the one running the program, so it's always exported.
+    if (func_type->GetFuncName() == "main") {
+        return llvm::GlobalValue::ExternalLinkage;
+    }
+    // A static function is only called in this module, so LLVM is free to
+    // change it, inline it into all the callers, and drop it at last.
+    if (func_decl->storage_class_ == StorageClass::kStatic) {
+        return llvm::GlobalValue::InternalLinkage;
+    }
+    // An inline function can be defined by several modules, and any one
+    // of them may be chosen, so it can be dropped if it isn't used anymore.
+    if (func_decl->is_inline_) {
+        return llvm::GlobalValue::LinkOnceODRLinkage;
+    }
+    return llvm::GlobalValue::ExternalLinkage;
+}
+
+void CodeGen::AddFuncAttrs(llvm::Function* func, const CFuncType* func_type) {
+    if (func_type->HasAttr(FuncAttr::kAlwaysInline)) {
+        func->addFnAttr(llvm::Attribute::AlwaysInline);
+    }
+    if (func_type->HasAttr(FuncAttr::kNoInline)) {
+        func->addFnAttr(llvm::Attribute::NoInline);
+    }
+    if (func_type->HasAttr(FuncAttr::kHot)) {
+        func->addFnAttr(llvm::Attribute::Hot);
+    }
+    if (func_type->HasAttr(FuncAttr::kCold)) {
+        func->addFnAttr(llvm::Attribute::Cold);
+        if (!func_type->HasAttr(FuncAttr::kOptNone)) {
+            func->addFnAttr(llvm::Attribute::OptimizeForSize);
+        }
+    }
+    // NOTE:
+    // A pure function may still loop forever or not return at all, and then
+    // a call to it can't be removed even if its result isn't used. GCC assumes
+    // it does return, so we promise `willreturn` and `nounwind` too.
+    if (func_type->HasAttr(FuncAttr::kConst)) {
+        func->setDoesNotAccessMemory();
+    } else if (func_type->HasAttr(FuncAttr::kPure)) {
+        func->setOnlyReadsMemory();
+    }
+    if (func_type->HasAttr(FuncAttr::kConst) || func_type->HasAttr(FuncAttr::kPure)) {
+        func->addFnAttr(llvm::Attribute::WillReturn);
+        func->addFnAttr(llvm::Attribute::NoUnwind);
+    }
+    if (func_type->HasAttr(FuncAttr::kNoReturn)) {
+        func->setDoesNotReturn();
+    }
+    // NOTE: LLVM requires an `optnone` function to be `noinline` too.
+    if (func_type->HasAttr(FuncAttr::kOptNone)) {
+        func->addFnAttr(llvm::Attribute::OptimizeNone);
+        func->addFnAttr(llvm::Attribute::NoInline);
+    }
+}
+
 llvm::Value *CodeGen::VisitPostFuncCallExpr(PostFuncCallExpr* func_call_expr) {
     auto func_node = func_call_expr->func_node_;
     auto func_type = llvm::dyn_cast<CFuncType>(func_node->GetCType().get());
-    auto func_llvm_inst = llvm::dyn_cast<llvm::Function>(func_node->Accept(this));
-    auto func_llvm_type = llvm::dyn_cast<llvm::FunctionType>(func_type->Accept(this));
+    auto func_llvm_inst = llvm::dyn_cast<llvm::Function>(Visit(func_node));
+    auto func_llvm_type = llvm::dyn_cast<llvm::FunctionType>(VisitType(func_type));
 
     const auto& func_params = func_type->GetParams();
     const auto& func_args = func_call_expr->arg_nodes_;
@@ -1068,33 +2131,63 @@ llvm::Value *CodeGen::VisitPostFuncCallExpr(PostFuncCallExpr* func_call_expr) {
     llvm::SmallVector<llvm::Value*> args;
     for (int i = 0; i < func_args.size(); ++i) {
         // Force cast the type of argument.
-        auto arg_value = func_args[i]->Accept(this);
-        auto param_type = func_params[i].type->Accept(this);
+        auto arg_value = Visit(func_args[i]);
+        auto param_type = VisitType(func_params[i].type);
+        if (func_params[i].type->GetKind() == CType::TypeKind::kRecord) {
+            arg_value = ir_builder_.CreateLoad(param_type, arg_value);
+        }
         CastValue(&arg_value, param_type);
         // Add the argument to argument list.
         args.push_back(arg_value);
     }
 
-    return ir_builder_.CreateCall(func_llvm_type, func_llvm_inst, args);
+    auto ret_value = ir_builder_.CreateCall(func_llvm_type, func_llvm_inst, args);
+    // NOTE:
+    // LLVM has no `flatten`, so we ask to inline each call in the function,
+    // like Clang. Unlike GCC, the calls in the inlined bodies are kept.
+    if (is_flatten_ &&
+        !func_type->HasAttr(FuncAttr::kNoInline) &&
+        !func_type->HasAttr(FuncAttr::kOptNone)) 
+    {
+        ret_value->addFnAttr(llvm::Attribute::AlwaysInline);
+    }
+
+    // A record returned by value is spilled into a temporary,
+    // since we represent the aggregates by their addresses.
+    auto ret_ctype = func_type->GetRetType();
+    if (ret_ctype->GetKind() == CType::TypeKind::kRecord) {
+        auto ret_addr = CreateEntryBlockAlloca(ret_ctype.get());
+        ir_builder_.CreateStore(ret_value, ret_addr);
+        return ret_addr;
+    }
+    return ret_value;
 }
 
 llvm::Value *CodeGen::VisitReturnStmt(ReturnStmt* ret_stmt) {
     auto ret_value_node = ret_stmt->value_node_;
     if (ret_value_node) {
-        auto ret_value = ret_value_node->Accept(this);
-        return ir_builder_.CreateRet(ret_value);
+        auto ret_value = Visit(ret_value_node);
+        auto ret_ctype = ret_value_node->GetCType();
+        if (ret_ctype->GetKind() == CType::TypeKind::kRecord) {
+            ret_value = ir_builder_.CreateLoad(VisitType(ret_ctype), ret_value);
+        }
+        EmitLifetimeEnds(0);
+        ir_builder_.CreateRet(ret_value);
     } else {
-        return ir_builder_.CreateRetVoid();
+        EmitLifetimeEnds(0);
+        ir_builder_.CreateRetVoid();
     }
+    // The code after `return` is unreachable.
+    ir_builder_.ClearInsertionPoint();
     return nullptr;
 }
 
 llvm::Type *CodeGen::VisitFuncType(CFuncType* func_type) {
-    llvm::Type* ret_llvm_type = func_type->GetRetType()->Accept(this);
+    llvm::Type* ret_llvm_type = VisitType(func_type->GetRetType());
 
     llvm::SmallVector<llvm::Type*> param_llvm_types;
     for (const auto& param : func_type->GetParams()) {
-        param_llvm_types.push_back(param.type->Accept(this));
+        param_llvm_types.push_back(VisitType(param.type));
     }
 
     return llvm::FunctionType::get(ret_llvm_type, param_llvm_types, false);
@@ -1116,9 +2209,4 @@ void CodeGen::CastValue(llvm::Value** value, llvm::Type* dest_type) {
             *value = ir_builder_.CreatePtrToInt(*value, dest_type);
         }
     }
-    else if (cur_type->isArrayTy()) {
-        if (dest_type->isPointerTy()) {
-            *value = llvm::dyn_cast<llvm::LoadInst>(*value)->getPointerOperand();
-        }
-    }
 }
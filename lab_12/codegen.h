@@ -10,13 +10,18 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/ValueHandle.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 
 #include "ast.h"
 #include "parser.h"
 #include "type.h"
 
-class CodeGen : public Visitor, public TypeVisitor {
+class CodeGen : public StaticVisitor<CodeGen>, public StaticTypeVisitor<CodeGen> {
  private:
     llvm::LLVMContext context_;
     llvm::IRBuilder<> ir_builder_ { context_ };
@@ -36,75 +41,283 @@ class CodeGen : public Visitor, public TypeVisitor {
     llvm::DenseMap<AstNode*, llvm::BasicBlock*> break_block_map_;
     llvm::DenseMap<AstNode*, llvm::BasicBlock*> continue_block_map_;
 
+    // The `switch` instruction of each switch statement,
+    // which gets a new case when a label in its body is generated.
+    llvm::DenseMap<AstNode*, llvm::SwitchInst*> switch_inst_map_;
+
+    // The local variables declared in each open scope, the innermost one is
+    // at the back. Their lifetimes end when the scope is exited, either by
+    // falling off its end, or by `break`, `continue` and `return`.
+    struct LocalScope {
+        llvm::SmallVector<llvm::AllocaInst*, 4> variables;
+        // The scope can be entered by jumping to a label in the middle of it,
+        // skipping the declarations, so its variables get no lifetime markers.
+        bool has_label;
+    };
+    llvm::SmallVector<LocalScope> local_scopes_;
+    // The depth of `local_scopes_` inside each loop or switch, so that a jump
+    // out of its body knows which scopes it leaves.
+    llvm::DenseMap<AstNode*, size_t> jump_scope_depth_map_;
+
+    // The statements of the current function which contain a label,
+    // including the labels themselves.
+    llvm::DenseSet<AstNode*> label_stmts_;
+    // The number of `goto` labels collected so far.
+    size_t goto_label_count_ { 0 };
+
+    // The block of each `goto` label in the current function.
+    // NOTE:
+    // A label can be jumped to from anywhere in the function, so its block
+    // isn't sealed until the whole function is generated.
+    llvm::MapVector<AstNode*, llvm::BasicBlock*> label_block_map_;
+    // All the `goto *expr` of the current function jump to this block,
+    // which dispatches to the labels whose address is taken.
+    llvm::BasicBlock* indirect_goto_block_ { nullptr };
+
+    llvm::BasicBlock* GetLabelBlock(AstNode* label);
+    llvm::BasicBlock* GetIndirectGotoBlock();
+    // Add the destinations of `indirect_goto_block_`, and seal the blocks
+    // of the labels, after all the jumps to them are generated.
+    void FinishLabels();
+
+    // Find the statements containing a label in `node`, return whether
+    // `node` is one of them.
+    bool CollectLabelStmts(AstNode* node);
+    bool ContainsLabel(AstNode* node) const {
+        return label_stmts_.count(node);
+    }
+
+    // There is no insert point after a terminator, until a new block is
+    // started, so the unreachable code is not generated.
+    bool HaveInsertPoint() const {
+        return ir_builder_.GetInsertBlock() != nullptr;
+    }
+    // Jump to `target_block` from the current block, if it's reachable.
+    void EmitBranch(llvm::BasicBlock* target_block);
+    // Fall through into `block`, and start to generate code in it.
+    // If `is_finished`, i.e. no more jumps to it will be generated,
+    // an unreachable `block` is deleted instead.
+    void EmitBlock(llvm::BasicBlock* block, bool is_finished = false);
+
+    // Generate a statement, which is skipped if it can't be reached,
+    // unless there is a label in it.
+    void EmitStmt(AstNode* node);
+
+    void EnterLocalScope(bool has_label);
+    void ExitLocalScope();
+    // End the lifetimes of the variables in the scopes from `depth` to the
+    // innermost one, without closing these scopes.
+    void EmitLifetimeEnds(size_t depth);
+
+    // The lowered LLVM type of each CType, since `TypeContext` has interned
+    // the types, we can look them up by pointer.
+    llvm::DenseMap<CType*, llvm::Type*> llvm_type_map_;
+
+    // The type-based alias analysis metadata, in the same shape as clang's.
+    // All the types are under `char`, which may alias any object. Each
+    // pointer type is under `any pointer` too, so `int*` and `struct A*`
+    // don't alias, but both of them alias `void*`.
+    //
+    // The scalar types are looked up by name, since `int` and `const int`
+    // are the same object in memory. The struct types are looked up by
+    // pointer, since two structs in different scopes may have one name.
+    llvm::MDNode* tbaa_root_ { nullptr };
+    llvm::MDNode* tbaa_char_ { nullptr };
+    llvm::MDNode* tbaa_any_pointer_ { nullptr };
+    llvm::StringMap<llvm::MDNode*> tbaa_scalar_types_;
+    llvm::DenseMap<CRecordType*, llvm::MDNode*> tbaa_struct_types_;
+
+    llvm::MDNode* GetTBAATypeNode(CType* ctype);
+    llvm::MDNode* GetTBAAStructTypeNode(CRecordType* record_type);
+    // The access tag of a scalar of `ctype` which isn't known to be in a struct.
+    llvm::MDNode* GetTBAAScalarTag(CType* ctype);
+    // The access tag of the scalar designated by `node`. If `node` is a member
+    // like `p->a.b`, the tag holds the outermost struct and the offset in it.
+    llvm::MDNode* GetTBAAAccessTag(AstNode* node);
+
+    // Each restrict pointer declared at the top level of the current function,
+    // i.e. a parameter or a variable in the outermost block, has an alias scope.
+    // An access through one of them is in its scope, and doesn't alias the
+    // ones through the others in the function.
+    //
+    // NOTE:
+    // The restrict pointers in the inner blocks are skipped, since they may be
+    // copied from an outer one, and then the accesses through the two pointers
+    // in different blocks do alias, which can't be told by the function-wide
+    // scopes.
+    struct RestrictScope {
+        llvm::MDNode* scope_list;
+        llvm::MDNode* noalias_list;
+    };
+    llvm::DenseMap<AstNode*, RestrictScope> restrict_scopes_;
+
+    // Is the current function declared with `__attribute__((flatten))`?
+    // If so, all the calls in its body are inlined.
+    bool is_flatten_ { false };
+
+    void CreateRestrictScopes(FuncDecl* func_decl);
+    // Add the TBAA and alias scope metadata to `inst`,
+    // a load or store of the scalar designated by `node`.
+    void SetAccessMetadata(llvm::Instruction* inst, AstNode* node);
+
  private:
-    llvm::StringMap<std::pair<llvm::Value*, llvm::Type*>> global_variable_map_;
-    llvm::SmallVector<llvm::StringMap<std::pair<llvm::Value*, llvm::Type*>>> local_variable_map_;    
+    // The address and type of each variable, keyed by its declaration,
+    // which sema has bound to every `VariableAccessExpr`.
+    llvm::DenseMap<AstNode*, std::pair<llvm::Value*, llvm::Type*>> variable_map_;
 
-    void AddLocalVariable(llvm::StringRef name, llvm::Value* addr, llvm::Type* llvm_type);
-    void AddGlobalVariable(llvm::StringRef name, llvm::Value* addr, llvm::Type* llvm_type);
-    std::pair<llvm::Value*, llvm::Type*> GetVariableByName(llvm::StringRef name);
+    void AddVariable(AstNode* decl, llvm::Value* addr, llvm::Type* llvm_type);
+
+ private:
+    // NOTE:
+    // If `build_ssa_` is set, the local scalars whose address is never taken
+    // aren't allocated in memory. Each assignment to them defines a new SSA
+    // value instead, and the PHI nodes are built on the fly when they are
+    // read, following "Simple and Efficient Construction of Static Single
+    // Assignment Form" (Braun et al., CC 2013). So the code is in SSA form
+    // without running mem2reg.
+    bool build_ssa_ { false };
+    llvm::DenseSet<AstNode*> ssa_variables_;
+    // The current definition of each SSA variable in each block. They are
+    // tracking handles, so they follow the PHI nodes replaced later.
+    llvm::DenseMap<llvm::BasicBlock*, llvm::DenseMap<AstNode*, llvm::WeakTrackingVH>> current_defs_;
+    // A block is sealed when all of its predecessors are known. The PHI nodes
+    // created in a block before that get their operands when it's sealed.
+    llvm::DenseSet<llvm::BasicBlock*> sealed_blocks_;
+    llvm::DenseMap<llvm::BasicBlock*, llvm::SmallVector<std::pair<AstNode*, llvm::PHINode*>>> incomplete_phis_;
 
-    void PushScope();
-    void PopScope();
-    void ClearVariableScope();
+    static bool CanBeSSAVariable(const VariableDecl* decl_node);
+    bool IsSSAVariable(AstNode* decl) const;
+    void WriteVariable(AstNode* decl, llvm::BasicBlock* block, llvm::Value* value);
+    llvm::Value* ReadVariable(AstNode* decl, llvm::BasicBlock* block);
+    llvm::Value* ReadVariableRecursive(AstNode* decl, llvm::BasicBlock* block);
+    llvm::Value* AddPhiOperands(AstNode* decl, llvm::PHINode* phi);
+    llvm::Value* TryRemoveTrivialPhi(llvm::PHINode* phi);
+    void SealBlock(llvm::BasicBlock* block);
 
  public:
-    explicit CodeGen(std::shared_ptr<Program> prog);
+    explicit CodeGen(std::shared_ptr<Program> prog, bool build_ssa = false);
 
     std::unique_ptr<llvm::Module>& GetModule() {
         return module_;
     }
 
  public:
-    llvm::Value* VisitProgram(Program*) override;
+    llvm::Value* VisitProgram(Program*);
 
-    llvm::Value* VisitDeclStmt(DeclStmt*) override;
-    llvm::Value* VisitBlockStmt(BlockStmt*) override;
-    llvm::Value* VisitIfStmt(IfStmt*) override;
-    llvm::Value* VisitForStmt(ForStmt*) override;
-    llvm::Value* VisitBreakStmt(BreakStmt*) override;
-    llvm::Value* VisitContinueStmt(ContinueStmt*) override;
+    llvm::Value* VisitDeclStmt(DeclStmt*);
+    llvm::Value* VisitBlockStmt(BlockStmt*);
+    llvm::Value* VisitIfStmt(IfStmt*);
+    llvm::Value* VisitForStmt(ForStmt*);
+    llvm::Value* VisitBreakStmt(BreakStmt*);
+    llvm::Value* VisitContinueStmt(ContinueStmt*);
+    llvm::Value* VisitSwitchStmt(SwitchStmt*);
+    llvm::Value* VisitCaseStmt(CaseStmt*);
+    llvm::Value* VisitLabelStmt(LabelStmt*);
+    llvm::Value* VisitGotoStmt(GotoStmt*);
+    llvm::Value* VisitIndirectGotoStmt(IndirectGotoStmt*);
 
-    llvm::Value* VisitUnaryExpr(UnaryExpr*) override;
-    llvm::Value* VisitBinaryExpr(BinaryExpr*) override;
-    llvm::Value* VisitTernaryExpr(TernaryExpr*) override;
+    llvm::Value* VisitUnaryExpr(UnaryExpr*);
+    llvm::Value* VisitBinaryExpr(BinaryExpr*);
+    llvm::Value* VisitTernaryExpr(TernaryExpr*);
+
+ private:
+    // Return the `i1` result of a relational or equality operator.
+    llvm::Value* EmitCompare(BinaryOpCode op_code, llvm::Value* left, llvm::Value* right);
+    // Evaluate `cond_node` as a condition, and jump to `true_block` if it's
+    // nonzero, otherwise to `false_block`.
+    // NOTE:
+    // The relational, `!`, `&&` and `||` operators are lowered into the
+    // branches directly, instead of producing an `int` first.
+    void EmitBranchOnBool(AstNode* cond_node,
+                          llvm::BasicBlock* true_block,
+                          llvm::BasicBlock* false_block);
+
+ public:
 
-    llvm::Value* VisitNumberExpr(NumberExpr*) override;
-    llvm::Value* VisitVariableAccessExpr(VariableAccessExpr*) override;
-    llvm::Value* VisitVariableDecl(VariableDecl*) override;
+    llvm::Value* VisitNumberExpr(NumberExpr*);
+    llvm::Value* VisitVariableAccessExpr(VariableAccessExpr*);
+    llvm::Value* VisitVariableDecl(VariableDecl*);
 
  private:
-    std::shared_ptr<VariableDecl::InitValue> GetInitValueStructByIndexList(
-                                                        const VariableDecl* decl_node, 
-                                                        const std::vector<int>& index);
-    llvm::Constant* GetInitialValueForGlobalVariable(
+    // NOTE:
+    // The initial values are sorted by their index lists, since the parser
+    // visits the initializer in order. So the callers walking the object
+    // in order find them with a cursor `next`, instead of searching them.
+    VariableDecl::InitValue* GetInitValueStructByIndexList(
+                                           const VariableDecl* decl_node, 
+                                           const std::vector<int>& index,
+                                           size_t& next);
+    // Is any object inside the one of `index` initialized?
+    bool HasInitValueIn(const VariableDecl* decl_node,
+                        const std::vector<int>& index,
+                        size_t& next);
+    llvm::Constant* GetConstantInitializer(
                                     const VariableDecl* decl_node, 
                                     llvm::Type*, 
-                                    std::vector<int>&);
+                                    std::vector<int>&,
+                                    size_t& next);
     llvm::Value* VisitLocalVariableDecl(VariableDecl*);
     llvm::Value* VisitGlobalVariableDecl(VariableDecl*);
+    static llvm::GlobalValue::LinkageTypes GetFuncLinkage(const FuncDecl* func_decl);
+    static void AddFuncAttrs(llvm::Function* func, const CFuncType* func_type);
+    void EmitLocalAggregateInit(VariableDecl* decl_node, llvm::Value* variable_addr);
 
  public:
-    llvm::Value* VisitSizeofExpr(SizeofExpr*) override;
+    llvm::Value* VisitSizeofExpr(SizeofExpr*);
+    llvm::Value* VisitAddrLabelExpr(AddrLabelExpr*);
 
-    llvm::Value* VisitPostIncExpr(PostIncExpr*) override;
-    llvm::Value* VisitPostDecExpr(PostDecExpr*) override;
+    llvm::Value* VisitPostIncExpr(PostIncExpr*);
+    llvm::Value* VisitPostDecExpr(PostDecExpr*);
 
-    llvm::Value* VisitPostSubscript(PostSubscriptExpr*) override;
+    llvm::Value* VisitPostSubscript(PostSubscriptExpr*);
 
-    llvm::Value* VisitPostMemberDotExpr(PostMemberDotExpr*) override;
-    llvm::Value* VisitPostMemberArrowExpr(PostMemberArrowExpr*) override;
+    llvm::Value* VisitPostMemberDotExpr(PostMemberDotExpr*);
+    llvm::Value* VisitPostMemberArrowExpr(PostMemberArrowExpr*);
 
-    llvm::Value* VisitFuncDecl(FuncDecl*) override;
-    llvm::Value* VisitPostFuncCallExpr(PostFuncCallExpr*) override;
-    llvm::Value* VisitReturnStmt(ReturnStmt*) override;
+ private:
+    llvm::Value* GetMemberAddress(llvm::Value* record_addr,
+                                  CRecordType* record_type,
+                                  const CRecordType::Member& member);
+
+    // Compute the address of the object designated by `node`,
+    // without loading anything from it.
+    llvm::Value* EmitLValue(AstNode* node);
+    // Compute the address of a subscript or member access with one GEP,
+    // e.g. `a[i][j].x`, by folding the accesses to the inner aggregates.
+    llvm::Value* EmitAccessChain(AstNode* node);
+    // Convert the object of `ctype` stored at `addr` into a rvalue.
+    // NOTE:
+    // Arrays, records and functions are represented by their addresses,
+    // so that an aggregate is never loaded as a whole, unless it's passed
+    // to or returned from a function by value.
+    llvm::Value* EmitRValue(AstNode* node, llvm::Value* addr, const llvm::Twine& name = "");
+    // Load or store the scalar designated by `node`, whose address `addr`
+    // is computed by `EmitLValue`, or `nullptr` for an SSA variable.
+    llvm::Value* EmitLoadOfScalar(AstNode* node, llvm::Value* addr);
+    void EmitStoreOfScalar(llvm::Value* value, AstNode* node, llvm::Value* addr);
+    void EmitAggregateCopy(llvm::Value* dest_addr, llvm::Value* src_addr, CType* ctype);
+    llvm::AllocaInst* CreateEntryBlockAlloca(CType* ctype, const llvm::Twine& name = "");
+
+ public:
+
+    llvm::Value* VisitFuncDecl(FuncDecl*);
+    llvm::Value* VisitPostFuncCallExpr(PostFuncCallExpr*);
+    llvm::Value* VisitReturnStmt(ReturnStmt*);
 
     // Convert NaiveC type object to LLVM type object by these methods.
-    llvm::Type* VisitPrimaryType(CPrimaryType*) override;
-    llvm::Type* VisitPointerType(CPointerType*) override;
-    llvm::Type* VisitArrayType(CArrayType*) override;
-    llvm::Type* VisitRecordType(CRecordType*) override;
-    llvm::Type* VisitFuncType(CFuncType*) override;
+    // NOTE:
+    // These hide `StaticTypeVisitor::VisitType`, so that each type is only
+    // lowered once, even when it's visited from the methods below.
+    llvm::Type* VisitType(CType* ctype);
+    llvm::Type* VisitType(const std::shared_ptr<CType>& ctype) {
+        return VisitType(ctype.get());
+    }
+
+    llvm::Type* VisitPrimaryType(CPrimaryType*);
+    llvm::Type* VisitPointerType(CPointerType*);
+    llvm::Type* VisitArrayType(CArrayType*);
+    llvm::Type* VisitRecordType(CRecordType*);
+    llvm::Type* VisitFuncType(CFuncType*);
 
  private:
     void CastValue(llvm::Value** value, llvm::Type* dest_type);
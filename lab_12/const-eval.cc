@@ -0,0 +1,148 @@
+// Copyright 2025 WU-SUNFLOWER. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the LICENSE file.
+
+#include "const-eval.h"
+
+#include <climits>
+#include <cstdint>
+
+#include "llvm/Support/Casting.h"
+
+namespace {
+
+// NOTE:
+// Signed overflow is undefined behavior in C++, so we do the arithmetic on
+// unsigned integers, which wraps around like the `i32` of LLVM IR.
+int Wrap(uint32_t value) {
+    return static_cast<int>(value);
+}
+
+}  // namespace
+
+std::optional<int> ConstEvaluator::EvaluateUnary(UnaryOpCode op, int value) {
+    switch (op) {
+        case UnaryOpCode::kPositive:
+            return value;
+        case UnaryOpCode::kNegative:
+            return Wrap(0u - static_cast<uint32_t>(value));
+        case UnaryOpCode::kLogicalNot:
+            return !value;
+        case UnaryOpCode::kBitwiseNot:
+            return ~value;
+        default:
+            // `++`, `--`, `*` and `&` never produce a constant.
+            return std::nullopt;
+    }
+}
+
+std::optional<int> ConstEvaluator::EvaluateBinary(BinaryOpCode op, int left, int right) {
+    auto uleft = static_cast<uint32_t>(left);
+    auto uright = static_cast<uint32_t>(right);
+
+    switch (op) {
+        case BinaryOpCode::kEqualEqual:
+            return left == right;
+        case BinaryOpCode::kNotEqual:
+            return left != right;
+        case BinaryOpCode::kLess:
+            return left < right;
+        case BinaryOpCode::kLessEqual:
+            return left <= right;
+        case BinaryOpCode::kGreater:
+            return left > right;
+        case BinaryOpCode::kGreaterEqual:
+            return left >= right;
+        case BinaryOpCode::kAdd:
+            return Wrap(uleft + uright);
+        case BinaryOpCode::kSub:
+            return Wrap(uleft - uright);
+        case BinaryOpCode::kMul:
+            return Wrap(uleft * uright);
+        case BinaryOpCode::kDiv:
+        case BinaryOpCode::kMod: {
+            // Leave the undefined cases to the runtime,
+            // just like what the generated code would do.
+            if (right == 0 || (left == INT_MIN && right == -1)) {
+                return std::nullopt;
+            }
+            return op == BinaryOpCode::kDiv ? left / right : left % right;
+        }
+        case BinaryOpCode::kLogicalOr:
+            return left || right;
+        case BinaryOpCode::kLogicalAnd:
+            return left && right;
+        case BinaryOpCode::kBitwiseOr:
+            return left | right;
+        case BinaryOpCode::kBitwiseAnd:
+            return left & right;
+        case BinaryOpCode::kBitwiseXor:
+            return left ^ right;
+        case BinaryOpCode::kLeftShift:
+        case BinaryOpCode::kRightShift: {
+            if (right < 0 || right >= 32) {
+                return std::nullopt;
+            }
+            if (op == BinaryOpCode::kLeftShift) {
+                return Wrap(uleft << right);
+            }
+            // NOTE: `>>` on a negative value is an arithmetic shift, like `ashr`.
+            return left >> right;
+        }
+        default:
+            // Assignments and `,` are never constant expressions.
+            return std::nullopt;
+    }
+}
+
+std::optional<int> ConstEvaluator::Evaluate(const AstNode* node) {
+    if (!node) {
+        return std::nullopt;
+    }
+
+    auto ctype = node->GetCType();
+    if (!ctype || ctype->GetKind() != CType::TypeKind::kInt) {
+        return std::nullopt;
+    }
+
+    switch (node->GetNodeKind()) {
+        case AstNode::AstNodeKind::kNumberExpr: {
+            return llvm::cast<NumberExpr>(node)->GetNumber();
+        }
+        case AstNode::AstNodeKind::kSizeof: {
+            auto expr = llvm::cast<SizeofExpr>(node);
+            if (expr->sub_ctype_) {
+                return static_cast<int>(expr->sub_ctype_->GetSize());
+            }
+            return static_cast<int>(expr->sub_node_->GetCType()->GetSize());
+        }
+        case AstNode::AstNodeKind::kUnaryExpr: {
+            auto expr = static_cast<const UnaryExpr*>(node);
+            auto value = expr->sub_node_->GetConstantValue();
+            if (!value) {
+                return std::nullopt;
+            }
+            return EvaluateUnary(expr->op_, *value);
+        }
+        case AstNode::AstNodeKind::kBinaryExpr: {
+            auto expr = llvm::cast<BinaryExpr>(node);
+            auto left = expr->left_->GetConstantValue();
+            auto right = expr->right_->GetConstantValue();
+            if (!left || !right) {
+                return std::nullopt;
+            }
+            return EvaluateBinary(expr->op_, *left, *right);
+        }
+        case AstNode::AstNodeKind::kTernaryExpr: {
+            auto expr = llvm::cast<TernaryExpr>(node);
+            auto cond = expr->cond_->GetConstantValue();
+            if (!cond) {
+                return std::nullopt;
+            }
+            return *cond ? expr->then_->GetConstantValue() : expr->els_->GetConstantValue();
+        }
+        default: {
+            return std::nullopt;
+        }
+    }
+}
@@ -0,0 +1,28 @@
+// Copyright 2025 WU-SUNFLOWER. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the LICENSE file.
+
+#ifndef CONST_EVAL_H_
+#define CONST_EVAL_H_
+
+#include <optional>
+
+#include "ast.h"
+
+// Evaluate integer constant expressions at compile time.
+//
+// The evaluator never walks a whole subtree. Instead, it computes the value
+// of a node from the values folded into its children before, so sema can
+// fold every expression bottom-up in O(1) per node while building the AST.
+class ConstEvaluator {
+ private:
+    static std::optional<int> EvaluateUnary(UnaryOpCode op, int value);
+    static std::optional<int> EvaluateBinary(BinaryOpCode op, int left, int right);
+
+ public:
+    // Return the value of `node` if it is an integer constant expression,
+    // otherwise return `std::nullopt`.
+    static std::optional<int> Evaluate(const AstNode* node);
+};
+
+#endif  // CONST_EVAL_H_
@@ -0,0 +1,290 @@
+// Copyright 2025 WU-SUNFLOWER. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the LICENSE file.
+
+#include "flat-ast.h"
+
+#include <cassert>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Casting.h"
+
+FlatAst::FlatAst(std::shared_ptr<Program> prog) : file_name_(prog->file_name_) {
+    top_level_nodes_ = FlattenList(prog->nodes_);
+
+    for (auto [payload, label] : label_fixups_) {
+        jump_nodes_[payload].target = label_refs_.lookup(label);
+    }
+}
+
+uint32_t FlatAst::InternType(std::shared_ptr<CType> ctype) {
+    if (!ctype) {
+        return kNullType;
+    }
+
+    auto [iter, inserted] = type_indices_.insert({ ctype.get(), types_.size() });
+    if (inserted) {
+        types_.push_back(ctype);
+    }
+    return iter->second;
+}
+
+FlatAst::ListRef FlatAst::FlattenList(llvm::ArrayRef<AstNode*> nodes) {
+    // Flatten the children at first, since they will append their own lists
+    // to `child_lists_` too.
+    llvm::SmallVector<NodeRef> refs;
+    for (auto node : nodes) {
+        refs.push_back(Flatten(node));
+    }
+
+    ListRef list;
+    list.begin = child_lists_.size();
+    list.size = refs.size();
+    child_lists_.insert(child_lists_.end(), refs.begin(), refs.end());
+    return list;
+}
+
+FlatAst::NodeRef FlatAst::Flatten(AstNode* node) {
+    if (!node) {
+        return kNullNode;
+    }
+
+    // NOTE:
+    // We assign the index of a node before visiting its children,
+    // so that the nodes are laid out in pre-order, which is also
+    // the order that most of traversals visit them in.
+    NodeRef ref = kinds_.size();
+    kinds_.push_back(node->GetNodeKind());
+    payloads_.push_back(0);
+    ctypes_.push_back(InternType(node->GetCType()));
+    lvalues_.push_back(node->IsLValue());
+
+    uint32_t payload = 0;
+    switch (node->GetNodeKind()) {
+        case AstNode::AstNodeKind::kDeclStmt: {
+            auto decl_stmt = llvm::cast<DeclStmt>(node);
+            payload = AddPayload(list_nodes_, { FlattenList(decl_stmt->nodes_) });
+            break;
+        }
+        case AstNode::AstNodeKind::kBlockStmt: {
+            auto block_stmt = llvm::cast<BlockStmt>(node);
+            payload = AddPayload(list_nodes_, { FlattenList(block_stmt->nodes_) });
+            break;
+        }
+        case AstNode::AstNodeKind::kIfStmt: {
+            auto if_stmt = llvm::cast<IfStmt>(node);
+            IfNode if_node;
+            if_node.cond = Flatten(if_stmt->cond_node_);
+            if_node.then = Flatten(if_stmt->then_node_);
+            if_node.els = Flatten(if_stmt->else_node_);
+            payload = AddPayload(if_nodes_, if_node);
+            break;
+        }
+        case AstNode::AstNodeKind::kForStmt: {
+            auto for_stmt = llvm::cast<ForStmt>(node);
+            loop_refs_.insert({ node, ref });
+            ForNode for_node;
+            for_node.init = Flatten(for_stmt->init_node_);
+            for_node.cond = Flatten(for_stmt->cond_node_);
+            for_node.inc = Flatten(for_stmt->inc_node_);
+            for_node.body = Flatten(for_stmt->body_node_);
+            payload = AddPayload(for_nodes_, for_node);
+            break;
+        }
+        case AstNode::AstNodeKind::kBreakStmt: {
+            auto break_stmt = llvm::cast<BreakStmt>(node);
+            payload = AddPayload(jump_nodes_, { loop_refs_.lookup(break_stmt->target_) });
+            break;
+        }
+        case AstNode::AstNodeKind::kContinueStmt: {
+            auto continue_stmt = llvm::cast<ContinueStmt>(node);
+            payload = AddPayload(jump_nodes_, { loop_refs_.lookup(continue_stmt->target_) });
+            break;
+        }
+        case AstNode::AstNodeKind::kSwitchStmt: {
+            auto switch_stmt = llvm::cast<SwitchStmt>(node);
+            loop_refs_.insert({ node, ref });
+            SwitchNode switch_node;
+            switch_node.cond = Flatten(switch_stmt->cond_node_);
+            switch_node.body = Flatten(switch_stmt->body_node_);
+
+            // The labels have been flattened in the body,
+            // so we only need to collect their indices here.
+            switch_node.cases.begin = child_lists_.size();
+            switch_node.cases.size = switch_stmt->case_nodes_.size();
+            for (auto case_stmt : switch_stmt->case_nodes_) {
+                child_lists_.push_back(label_refs_.lookup(case_stmt));
+            }
+            payload = AddPayload(switch_nodes_, switch_node);
+            break;
+        }
+        case AstNode::AstNodeKind::kCaseStmt: {
+            auto case_stmt = llvm::cast<CaseStmt>(node);
+            label_refs_.insert({ node, ref });
+            CaseNode case_node;
+            case_node.value = Flatten(case_stmt->value_node_);
+            case_node.sub = Flatten(case_stmt->sub_stmt_);
+            case_node.target = loop_refs_.lookup(case_stmt->target_);
+            payload = AddPayload(case_nodes_, case_node);
+            break;
+        }
+        case AstNode::AstNodeKind::kLabelStmt: {
+            auto label_stmt = llvm::cast<LabelStmt>(node);
+            label_refs_.insert({ node, ref });
+            LabelNode label_node;
+            label_node.name = label_stmt->GetLabelName();
+            label_node.sub = Flatten(label_stmt->sub_stmt_);
+            label_node.is_address_taken = label_stmt->is_address_taken_;
+            payload = AddPayload(label_nodes_, label_node);
+            break;
+        }
+        case AstNode::AstNodeKind::kGotoStmt: {
+            auto goto_stmt = llvm::cast<GotoStmt>(node);
+            payload = AddPayload(jump_nodes_, { kNullNode });
+            label_fixups_.push_back({ payload, goto_stmt->target_ });
+            break;
+        }
+        case AstNode::AstNodeKind::kIndirectGotoStmt: {
+            auto goto_stmt = llvm::cast<IndirectGotoStmt>(node);
+            payload = AddPayload(indirect_goto_nodes_, { Flatten(goto_stmt->target_node_) });
+            break;
+        }
+        case AstNode::AstNodeKind::kUnaryExpr: {
+            auto expr = static_cast<UnaryExpr*>(node);
+            payload = AddPayload(unary_nodes_, { expr->op_, Flatten(expr->sub_node_) });
+            break;
+        }
+        case AstNode::AstNodeKind::kBinaryExpr: {
+            auto expr = llvm::cast<BinaryExpr>(node);
+            BinaryNode binary_node;
+            binary_node.op = expr->op_;
+            binary_node.left = Flatten(expr->left_);
+            binary_node.right = Flatten(expr->right_);
+            payload = AddPayload(binary_nodes_, binary_node);
+            break;
+        }
+        case AstNode::AstNodeKind::kTernaryExpr: {
+            auto expr = llvm::cast<TernaryExpr>(node);
+            TernaryNode ternary_node;
+            ternary_node.cond = Flatten(expr->cond_);
+            ternary_node.then = Flatten(expr->then_);
+            ternary_node.els = Flatten(expr->els_);
+            payload = AddPayload(ternary_nodes_, ternary_node);
+            break;
+        }
+        case AstNode::AstNodeKind::kVariableDecl: {
+            auto decl = llvm::cast<VariableDecl>(node);
+            llvm::SmallVector<InitValue> init_values;
+            for (const auto init_value : decl->init_values_) {
+                InitValue flat_init_value;
+                flat_init_value.decl_type = InternType(init_value->decl_type);
+                flat_init_value.init_node = Flatten(init_value->init_node);
+                flat_init_value.index_begin = index_lists_.size();
+                flat_init_value.index_size = init_value->index_list.size();
+                index_lists_.insert(index_lists_.end(),
+                                    init_value->index_list.begin(),
+                                    init_value->index_list.end());
+                init_values.push_back(flat_init_value);
+            }
+
+            VariableDeclNode decl_node;
+            decl_node.name = decl->GetVariableName();
+            decl_node.init_begin = init_values_.size();
+            decl_node.init_size = init_values.size();
+            decl_node.is_global = decl->is_global_;
+            decl_node.storage_class = decl->storage_class_;
+            init_values_.insert(init_values_.end(), init_values.begin(), init_values.end());
+            payload = AddPayload(variable_decl_nodes_, decl_node);
+            break;
+        }
+        case AstNode::AstNodeKind::kNumberExpr: {
+            auto expr = llvm::cast<NumberExpr>(node);
+            payload = AddPayload(number_nodes_, { expr->GetNumber() });
+            break;
+        }
+        case AstNode::AstNodeKind::kVariableAccessExpr: {
+            auto expr = llvm::cast<VariableAccessExpr>(node);
+            payload = AddPayload(variable_access_nodes_, { expr->GetVariableName() });
+            break;
+        }
+        case AstNode::AstNodeKind::kSizeof: {
+            auto expr = llvm::cast<SizeofExpr>(node);
+            SizeofNode sizeof_node;
+            sizeof_node.sub = Flatten(expr->sub_node_);
+            sizeof_node.sub_type = InternType(expr->sub_ctype_);
+            payload = AddPayload(sizeof_nodes_, sizeof_node);
+            break;
+        }
+        case AstNode::AstNodeKind::kAddrLabelExpr: {
+            auto expr = llvm::cast<AddrLabelExpr>(node);
+            payload = AddPayload(jump_nodes_, { kNullNode });
+            label_fixups_.push_back({ payload, expr->target_ });
+            break;
+        }
+        case AstNode::AstNodeKind::kPostIncExpr: {
+            auto expr = llvm::cast<PostIncExpr>(node);
+            payload = AddPayload(postfix_nodes_, { Flatten(expr->sub_node_) });
+            break;
+        }
+        case AstNode::AstNodeKind::kPostDecExpr: {
+            auto expr = llvm::cast<PostDecExpr>(node);
+            payload = AddPayload(postfix_nodes_, { Flatten(expr->sub_node_) });
+            break;
+        }
+        case AstNode::AstNodeKind::kPostSubscriptExpr: {
+            auto expr = llvm::cast<PostSubscriptExpr>(node);
+            SubscriptNode subscript_node;
+            subscript_node.sub = Flatten(expr->sub_node_);
+            subscript_node.index = Flatten(expr->index_node_);
+            payload = AddPayload(subscript_nodes_, subscript_node);
+            break;
+        }
+        case AstNode::AstNodeKind::kPostMemberDotExpr: {
+            auto expr = llvm::cast<PostMemberDotExpr>(node);
+            MemberNode member_node;
+            member_node.base = Flatten(expr->struct_node_);
+            member_node.record_type = InternType(expr->struct_node_->GetCType());
+            member_node.member_rank = expr->target_member_.rank;
+            payload = AddPayload(member_nodes_, member_node);
+            break;
+        }
+        case AstNode::AstNodeKind::kPostMemberArrowExpr: {
+            auto expr = llvm::cast<PostMemberArrowExpr>(node);
+            auto pointer_type = llvm::cast<CPointerType>(expr->struct_pointer_node_->GetCType().get());
+            MemberNode member_node;
+            member_node.base = Flatten(expr->struct_pointer_node_);
+            member_node.record_type = InternType(pointer_type->GetBaseType());
+            member_node.member_rank = expr->target_member_.rank;
+            payload = AddPayload(member_nodes_, member_node);
+            break;
+        }
+        case AstNode::AstNodeKind::kFuncDecl: {
+            auto func_decl = llvm::cast<FuncDecl>(node);
+            FuncDeclNode func_decl_node;
+            func_decl_node.body = Flatten(func_decl->block_stmt_);
+            func_decl_node.storage_class = func_decl->storage_class_;
+            func_decl_node.is_inline = func_decl->is_inline_;
+            payload = AddPayload(func_decl_nodes_, func_decl_node);
+            break;
+        }
+        case AstNode::AstNodeKind::kPostFuncCallExpr: {
+            auto expr = llvm::cast<PostFuncCallExpr>(node);
+            CallNode call_node;
+            call_node.func = Flatten(expr->func_node_);
+            call_node.args = FlattenList(expr->arg_nodes_);
+            payload = AddPayload(call_nodes_, call_node);
+            break;
+        }
+        case AstNode::AstNodeKind::kReturnStmt: {
+            auto ret_stmt = llvm::cast<ReturnStmt>(node);
+            payload = AddPayload(return_nodes_, { Flatten(ret_stmt->value_node_) });
+            break;
+        }
+        default: {
+            assert(0);
+        }
+    }
+
+    payloads_[ref] = payload;
+    return ref;
+}
@@ -0,0 +1,327 @@
+// Copyright 2025 WU-SUNFLOWER. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the LICENSE file.
+
+#ifndef FLAT_AST_H_
+#define FLAT_AST_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "ast.h"
+#include "type.h"
+
+// A compact, data-oriented copy of the AST.
+//
+// Instead of linking heap objects through pointers, every node is identified
+// by a 32-bit index. The data shared by all the nodes (kind, type and lvalue
+// flag) is stored in separate parallel arrays, and the data specific to a kind
+// of node lives in a contiguous array for this kind. So a traversal touches
+// only a few dense arrays, instead of jumping all over the heap.
+class FlatAst {
+ public:
+    using NodeRef = uint32_t;
+    static constexpr NodeRef kNullNode = UINT32_MAX;
+
+    // A range of `child_lists_`.
+    struct ListRef {
+        uint32_t begin { 0 };
+        uint32_t size { 0 };
+    };
+
+    // Payloads of each kind of node.
+    struct ListNode {  // DeclStmt, BlockStmt
+        ListRef nodes;
+    };
+    struct IfNode {
+        NodeRef cond, then, els;
+    };
+    struct ForNode {
+        NodeRef init, cond, inc, body;
+    };
+    struct JumpNode {  // BreakStmt, ContinueStmt, GotoStmt, AddrLabelExpr
+        NodeRef target;
+    };
+    struct SwitchNode {
+        NodeRef cond, body;
+        // The labels in `body`, which are flattened together with it.
+        ListRef cases;
+    };
+    struct CaseNode {
+        // `kNullNode` for the `default` label.
+        NodeRef value, sub, target;
+    };
+    struct LabelNode {
+        llvm::StringRef name;
+        NodeRef sub;
+        bool is_address_taken;
+    };
+    struct IndirectGotoNode {
+        NodeRef target;
+    };
+    struct UnaryNode {
+        UnaryOpCode op;
+        NodeRef sub;
+    };
+    struct BinaryNode {
+        BinaryOpCode op;
+        NodeRef left, right;
+    };
+    struct TernaryNode {
+        NodeRef cond, then, els;
+    };
+    struct NumberNode {
+        int value;
+    };
+    struct VariableAccessNode {
+        llvm::StringRef name;
+    };
+    struct VariableDeclNode {
+        llvm::StringRef name;
+        // A range of `init_values_`.
+        uint32_t init_begin, init_size;
+        bool is_global;
+        StorageClass storage_class;
+    };
+    struct InitValue {
+        uint32_t decl_type;
+        NodeRef init_node;
+        // A range of `index_lists_`.
+        uint32_t index_begin, index_size;
+    };
+    struct SizeofNode {
+        NodeRef sub;
+        // `kNullType` if the operand is an expression.
+        uint32_t sub_type;
+    };
+    struct PostfixNode {  // PostIncExpr, PostDecExpr
+        NodeRef sub;
+    };
+    struct SubscriptNode {
+        NodeRef sub, index;
+    };
+    struct MemberNode {  // PostMemberDotExpr, PostMemberArrowExpr
+        NodeRef base;
+        // The record type which owns the member, and the member's rank in it.
+        uint32_t record_type;
+        uint32_t member_rank;
+    };
+    struct FuncDeclNode {
+        NodeRef body;
+        StorageClass storage_class;
+        bool is_inline;
+    };
+    struct CallNode {
+        NodeRef func;
+        ListRef args;
+    };
+    struct ReturnNode {
+        NodeRef value;
+    };
+
+    static constexpr uint32_t kNullType = UINT32_MAX;
+
+ private:
+    llvm::StringRef file_name_;
+    ListRef top_level_nodes_;
+
+    // Per-node data, indexed by `NodeRef`.
+    std::vector<AstNode::AstNodeKind> kinds_;
+    std::vector<uint32_t> payloads_;
+    std::vector<uint32_t> ctypes_;
+    llvm::BitVector lvalues_;
+
+    // Per-kind data, indexed by `payloads_[node]`.
+    std::vector<ListNode> list_nodes_;
+    std::vector<IfNode> if_nodes_;
+    std::vector<ForNode> for_nodes_;
+    std::vector<JumpNode> jump_nodes_;
+    std::vector<SwitchNode> switch_nodes_;
+    std::vector<CaseNode> case_nodes_;
+    std::vector<LabelNode> label_nodes_;
+    std::vector<IndirectGotoNode> indirect_goto_nodes_;
+    std::vector<UnaryNode> unary_nodes_;
+    std::vector<BinaryNode> binary_nodes_;
+    std::vector<TernaryNode> ternary_nodes_;
+    std::vector<NumberNode> number_nodes_;
+    std::vector<VariableAccessNode> variable_access_nodes_;
+    std::vector<VariableDeclNode> variable_decl_nodes_;
+    std::vector<SizeofNode> sizeof_nodes_;
+    std::vector<PostfixNode> postfix_nodes_;
+    std::vector<SubscriptNode> subscript_nodes_;
+    std::vector<MemberNode> member_nodes_;
+    std::vector<FuncDeclNode> func_decl_nodes_;
+    std::vector<CallNode> call_nodes_;
+    std::vector<ReturnNode> return_nodes_;
+
+    std::vector<NodeRef> child_lists_;
+    std::vector<InitValue> init_values_;
+    std::vector<int> index_lists_;
+
+    // Every distinct type is stored once, and nodes refer to it by index.
+    std::vector<std::shared_ptr<CType>> types_;
+    llvm::DenseMap<CType*, uint32_t> type_indices_;
+
+    // Map each loop or switch statement to its index,
+    // so that `break`, `continue` and `case` can refer to their targets.
+    llvm::DenseMap<AstNode*, NodeRef> loop_refs_;
+    // Map each label to its index, so that the switch statement can list
+    // its `case` and `default` labels, and the others can be jumped to.
+    llvm::DenseMap<AstNode*, NodeRef> label_refs_;
+    // A label may be used before it's flattened, so the targets of `goto`
+    // and `&&` are filled in `jump_nodes_` after all the nodes are flattened.
+    std::vector<std::pair<uint32_t, AstNode*>> label_fixups_;
+
+    NodeRef Flatten(AstNode* node);
+    ListRef FlattenList(llvm::ArrayRef<AstNode*> nodes);
+    uint32_t InternType(std::shared_ptr<CType> ctype);
+
+    template <typename T>
+    uint32_t AddPayload(std::vector<T>& payloads, const T& payload) {
+        payloads.push_back(payload);
+        return payloads.size() - 1;
+    }
+
+ public:
+    explicit FlatAst(std::shared_ptr<Program> prog);
+
+    llvm::StringRef GetFileName() const {
+        return file_name_;
+    }
+
+    llvm::ArrayRef<NodeRef> GetTopLevelNodes() const {
+        return GetList(top_level_nodes_);
+    }
+
+    size_t GetNodeCount() const {
+        return kinds_.size();
+    }
+
+    AstNode::AstNodeKind GetKind(NodeRef node) const {
+        return kinds_[node];
+    }
+
+    CType* GetCType(NodeRef node) const {
+        return GetType(ctypes_[node]);
+    }
+
+    bool IsLValue(NodeRef node) const {
+        return lvalues_.test(node);
+    }
+
+    CType* GetType(uint32_t type) const {
+        return type == kNullType ? nullptr : types_[type].get();
+    }
+
+    llvm::ArrayRef<NodeRef> GetList(ListRef list) const {
+        return llvm::ArrayRef<NodeRef>(child_lists_).slice(list.begin, list.size);
+    }
+
+    llvm::ArrayRef<InitValue> GetInitValues(const VariableDeclNode& decl) const {
+        return llvm::ArrayRef<InitValue>(init_values_).slice(decl.init_begin, decl.init_size);
+    }
+
+    llvm::ArrayRef<int> GetIndexList(const InitValue& init_value) const {
+        return llvm::ArrayRef<int>(index_lists_).slice(init_value.index_begin, init_value.index_size);
+    }
+
+    const CRecordType::Member& GetMember(const MemberNode& node) const {
+        auto record_type = llvm::cast<CRecordType>(GetType(node.record_type));
+        return record_type->GetMembers()[node.member_rank];
+    }
+
+    // Accessors of per-kind data.
+    // The caller should make sure that the kind of `node` is right.
+
+    const ListNode& GetListNode(NodeRef node) const {
+        return list_nodes_[payloads_[node]];
+    }
+
+    const IfNode& GetIfNode(NodeRef node) const {
+        return if_nodes_[payloads_[node]];
+    }
+
+    const ForNode& GetForNode(NodeRef node) const {
+        return for_nodes_[payloads_[node]];
+    }
+
+    const JumpNode& GetJumpNode(NodeRef node) const {
+        return jump_nodes_[payloads_[node]];
+    }
+
+    const SwitchNode& GetSwitchNode(NodeRef node) const {
+        return switch_nodes_[payloads_[node]];
+    }
+
+    const CaseNode& GetCaseNode(NodeRef node) const {
+        return case_nodes_[payloads_[node]];
+    }
+
+    const LabelNode& GetLabelNode(NodeRef node) const {
+        return label_nodes_[payloads_[node]];
+    }
+
+    const IndirectGotoNode& GetIndirectGotoNode(NodeRef node) const {
+        return indirect_goto_nodes_[payloads_[node]];
+    }
+
+    const UnaryNode& GetUnaryNode(NodeRef node) const {
+        return unary_nodes_[payloads_[node]];
+    }
+
+    const BinaryNode& GetBinaryNode(NodeRef node) const {
+        return binary_nodes_[payloads_[node]];
+    }
+
+    const TernaryNode& GetTernaryNode(NodeRef node) const {
+        return ternary_nodes_[payloads_[node]];
+    }
+
+    const NumberNode& GetNumberNode(NodeRef node) const {
+        return number_nodes_[payloads_[node]];
+    }
+
+    const VariableAccessNode& GetVariableAccessNode(NodeRef node) const {
+        return variable_access_nodes_[payloads_[node]];
+    }
+
+    const VariableDeclNode& GetVariableDeclNode(NodeRef node) const {
+        return variable_decl_nodes_[payloads_[node]];
+    }
+
+    const SizeofNode& GetSizeofNode(NodeRef node) const {
+        return sizeof_nodes_[payloads_[node]];
+    }
+
+    const PostfixNode& GetPostfixNode(NodeRef node) const {
+        return postfix_nodes_[payloads_[node]];
+    }
+
+    const SubscriptNode& GetSubscriptNode(NodeRef node) const {
+        return subscript_nodes_[payloads_[node]];
+    }
+
+    const MemberNode& GetMemberNode(NodeRef node) const {
+        return member_nodes_[payloads_[node]];
+    }
+
+    const FuncDeclNode& GetFuncDeclNode(NodeRef node) const {
+        return func_decl_nodes_[payloads_[node]];
+    }
+
+    const CallNode& GetCallNode(NodeRef node) const {
+        return call_nodes_[payloads_[node]];
+    }
+
+    const ReturnNode& GetReturnNode(NodeRef node) const {
+        return return_nodes_[payloads_[node]];
+    }
+};
+
+#endif  // FLAT_AST_H_
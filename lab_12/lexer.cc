@@ -132,6 +132,18 @@ void Lexer::GetNextToken(Token& token) {
         else if (IS_KEYWORD("continue")) {
             token.type_ = TokenType::kContinue;
         }
+        else if (IS_KEYWORD("switch")) {
+            token.type_ = TokenType::kSwitch;
+        }
+        else if (IS_KEYWORD("case")) {
+            token.type_ = TokenType::kCase;
+        }
+        else if (IS_KEYWORD("default")) {
+            token.type_ = TokenType::kDefault;
+        }
+        else if (IS_KEYWORD("goto")) {
+            token.type_ = TokenType::kGoto;
+        }
         else if (IS_KEYWORD("sizeof")) {
             token.type_ = TokenType::kSizeof;
         }
@@ -147,6 +159,21 @@ void Lexer::GetNextToken(Token& token) {
         else if (IS_KEYWORD("void")) {
             token.type_ = TokenType::kVoid;
         }
+        else if (IS_KEYWORD("static")) {
+            token.type_ = TokenType::kStatic;
+        }
+        else if (IS_KEYWORD("inline")) {
+            token.type_ = TokenType::kInline;
+        }
+        else if (IS_KEYWORD("const")) {
+            token.type_ = TokenType::kConst;
+        }
+        else if (IS_KEYWORD("restrict")) {
+            token.type_ = TokenType::kRestrict;
+        }
+        else if (IS_KEYWORD("__attribute__")) {
+            token.type_ = TokenType::kAttribute;
+        }
 #undef IS_KEYWORD
     }
     else {
@@ -557,6 +584,14 @@ llvm::StringRef Token::GetSpellingText(TokenType token_type) {
             return "break";
         case TokenType::kContinue:
             return "continue";
+        case TokenType::kSwitch:
+            return "switch";
+        case TokenType::kCase:
+            return "case";
+        case TokenType::kDefault:
+            return "default";
+        case TokenType::kGoto:
+            return "goto";
         case TokenType::kSizeof:
             return "sizeof";
         case TokenType::kStruct:
@@ -567,6 +602,16 @@ llvm::StringRef Token::GetSpellingText(TokenType token_type) {
             return "return";
         case TokenType::kVoid:
             return "void";
+        case TokenType::kStatic:
+            return "static";
+        case TokenType::kInline:
+            return "inline";
+        case TokenType::kConst:
+            return "const";
+        case TokenType::kRestrict:
+            return "restrict";
+        case TokenType::kAttribute:
+            return "__attribute__";
         case TokenType::kLBracket:
             return "[";
         case TokenType::kRBracket:
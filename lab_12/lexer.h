@@ -67,11 +67,20 @@ enum class TokenType {
     kFor,                   // 'for'
     kBreak,                 // 'break'
     kContinue,              // 'continue'
+    kSwitch,                // 'switch'
+    kCase,                  // 'case'
+    kDefault,               // 'default'
+    kGoto,                  // 'goto'
     kSizeof,                // 'sizeof'
     kStruct,                // 'struct'
     kUnion,                 // 'union'
     kReturn,                // 'return'
     kVoid,                  // 'void'
+    kStatic,                // 'static'
+    kInline,                // 'inline'
+    kConst,                 // 'const'
+    kRestrict,              // 'restrict'
+    kAttribute,             // '__attribute__'
 
     kEOF,                   // The end of file
     kUnknown,
@@ -95,6 +104,7 @@ class Token {
 
  public:
     friend class Lexer;
+    friend class ModuleReader;
 
     Token() = default;
 
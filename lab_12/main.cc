@@ -8,6 +8,7 @@
 
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
 #include "llvm/IR/Verifier.h"
@@ -19,6 +20,8 @@
 #include "codegen.h"
 #include "sema.h"
 #include "diag-engine.h"
+#include "flat-ast.h"
+#include "module-file.h"
 
 #define JIT_TEST
 
@@ -29,30 +32,112 @@ int main(int argc, char *argv[]) {
     LLVMLinkInMCJIT();
 #endif
 
-    if (argc < 2) {
+    // Usage: NaiveC [-emit-module <output>] [-import-module <module>] [-direct-ssa] [-print-ast] [file]
+    //
+    // `-emit-module` saves the checked program into a precompiled module,
+    // and `-import-module` loads one, so that its declarations and definitions
+    // can be used without going through lexer, parser and sema again.
+    //
+    // `-direct-ssa` keeps the local scalars in SSA values instead of memory,
+    // if their address is never taken.
+    //
+    // `-print-ast` prints the program back as source code, walking the flat
+    // form of the AST, instead of running it.
+    const char *file_name = nullptr;
+    const char *emit_module_name = nullptr;
+    const char *import_module_name = nullptr;
+    bool build_ssa = false;
+    bool print_ast = false;
+    for (int i = 1; i < argc; ++i) {
+        llvm::StringRef arg = argv[i];
+        if (arg == "-emit-module" && i + 1 < argc) {
+            emit_module_name = argv[++i];
+        } else if (arg == "-import-module" && i + 1 < argc) {
+            import_module_name = argv[++i];
+        } else if (arg == "-direct-ssa") {
+            build_ssa = true;
+        } else if (arg == "-print-ast") {
+            print_ast = true;
+        } else {
+            file_name = argv[i];
+        }
+    }
+
+    if (!file_name && !import_module_name) {
         printf("please input filename!\n");
         return 0;
     }
 
-    const char *file_name = argv[1];
-
-    static llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buf = llvm::MemoryBuffer::getFile(file_name);
-    if (!buf) {
-        llvm::errs() << "can't open file!!!\n";
-        return -1;
+    std::unique_ptr<ModuleReader> reader;
+    std::shared_ptr<Program> imported_program;
+    if (import_module_name) {
+        reader = ModuleReader::Open(import_module_name);
+        if (!reader) {
+            llvm::errs() << "can't open module!!!\n";
+            return -1;
+        }
     }
 
     llvm::SourceMgr mgr;
     DiagEngine diagEngine(mgr);
+    Sema sema(diagEngine);
+    std::shared_ptr<Program> program;
 
-    mgr.AddNewSourceBuffer(std::move(*buf), llvm::SMLoc());
+    if (file_name) {
+        static llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buf = llvm::MemoryBuffer::getFile(file_name);
+        if (!buf) {
+            llvm::errs() << "can't open file!!!\n";
+            return -1;
+        }
+        mgr.AddNewSourceBuffer(std::move(*buf), llvm::SMLoc());
 
-    Lexer lex(mgr, diagEngine);
-    Sema sema(diagEngine);
-    Parser parser(lex, sema);
-    auto program = parser.ParseProgram();
-    // PrintVisitor visitor(program);
-    CodeGen codegen(program);
+        // The program can refer to the global symbols of the imported module.
+        if (reader) {
+            reader->ImportSymbols(sema.GetScope(), sema.GetTypeContext());
+        }
+
+        Lexer lex(mgr, diagEngine);
+        Parser parser(lex, sema);
+        program = parser.ParseProgram();
+    }
+
+    if (emit_module_name) {
+        if (!program) {
+            llvm::errs() << "no program to emit!!!\n";
+            return -1;
+        }
+        std::error_code ec;
+        llvm::raw_fd_ostream out(emit_module_name, ec, llvm::sys::fs::OF_None);
+        if (ec) {
+            llvm::errs() << "can't write module: " << ec.message() << "\n";
+            return -1;
+        }
+        ModuleWriter writer(program, sema.GetScope());
+        writer.Write(out);
+        return 0;
+    }
+
+    // The definitions in the imported module come before the ones in our program,
+    // in the same way as if they were written at the top of the source file.
+    if (reader) {
+        imported_program = reader->LoadProgram();
+        if (program) {
+            program->nodes_.insert(program->nodes_.begin(),
+                                   imported_program->nodes_.begin(),
+                                   imported_program->nodes_.end());
+        } else {
+            program = imported_program;
+        }
+    }
+
+    if (print_ast) {
+        FlatAst flat_ast(program);
+        PrintVisitor visitor(flat_ast, &llvm::outs());
+        llvm::outs() << "\n";
+        return 0;
+    }
+
+    CodeGen codegen(program, build_ssa);
 
     auto &module = codegen.GetModule();
     module->print(llvm::outs(), nullptr);    
@@ -0,0 +1,973 @@
+// Copyright 2025 WU-SUNFLOWER. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the LICENSE file.
+
+#include "module-file.h"
+
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/Casting.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/ErrorHandling.h"
+
+#include "const-eval.h"
+
+using module_file::kNone;
+
+// The size of `module_file::Header` in the file, i.e. the magic and 17 fields.
+static constexpr uint32_t kHeaderSize = sizeof(module_file::kMagic) + 17 * 4;
+
+static void Emit32(llvm::SmallVectorImpl<char>& buf, uint32_t value) {
+    char bytes[4];
+    llvm::support::endian::write32le(bytes, value);
+    buf.append(bytes, bytes + 4);
+}
+
+static void AlignTo4(llvm::SmallVectorImpl<char>& buf) {
+    while (buf.size() % 4 != 0) {
+        buf.push_back(0);
+    }
+}
+
+ModuleWriter::ModuleWriter(std::shared_ptr<Program> program, Scope& scope)
+    : program_(program), scope_(scope)
+{
+    // The built-in types have fixed ids,
+    // so that the reader can map them back to the shared objects.
+    EmitType(CType::kIntType);
+    EmitType(CType::kVoidType);
+    assert(type_ids_[CType::kIntType.get()] == module_file::kIntTypeId);
+    assert(type_ids_[CType::kVoidType.get()] == module_file::kVoidTypeId);
+}
+
+uint32_t ModuleWriter::InternString(llvm::StringRef str) {
+    auto [iter, inserted] = string_offsets_.insert({ str, strings_.size() });
+    if (inserted) {
+        strings_.append(str.begin(), str.end());
+    }
+    return iter->second;
+}
+
+void ModuleWriter::EmitString(llvm::SmallVectorImpl<char>& buf, llvm::StringRef str) {
+    Emit32(buf, InternString(str));
+    Emit32(buf, str.size());
+}
+
+uint32_t ModuleWriter::EmitType(CType* ctype) {
+    if (!ctype) {
+        return kNone;
+    }
+
+    auto iter = type_ids_.find(ctype);
+    if (iter != type_ids_.end()) {
+        return iter->second;
+    }
+
+    // NOTE:
+    // The id must be assigned before visiting the types referred by `ctype`,
+    // since a record type may refer to itself through the pointer member.
+    uint32_t id = type_offsets_.size();
+    type_ids_.insert({ ctype, id });
+    type_offsets_.push_back(0);
+
+    // NOTE:
+    // A qualified type is saved like the unqualified one, but with the bit 8
+    // set for const, and the bit 9 set for restrict.
+    llvm::SmallVector<char> record;
+    Emit32(record, static_cast<uint32_t>(ctype->GetKind()) | 
+                   (ctype->IsConst() << 8) | 
+                   (ctype->IsRestrict() << 9));
+    switch (ctype->GetKind()) {
+        case CType::TypeKind::kInt:
+        case CType::TypeKind::kVoid:
+            break;
+        case CType::TypeKind::kPointer: {
+            auto pointer_type = llvm::cast<CPointerType>(ctype);
+            Emit32(record, EmitType(pointer_type->GetBaseType()));
+            break;
+        }
+        case CType::TypeKind::kArray: {
+            auto array_type = llvm::cast<CArrayType>(ctype);
+            Emit32(record, EmitType(array_type->GetElementType()));
+            Emit32(record, array_type->GetElementCount());
+            break;
+        }
+        case CType::TypeKind::kRecord: {
+            auto record_type = llvm::cast<CRecordType>(ctype);
+            Emit32(record, static_cast<uint32_t>(record_type->GetTagKind()));
+            EmitString(record, record_type->GetName());
+            Emit32(record, record_type->GetMembers().size());
+            for (const auto& member : record_type->GetMembers()) {
+                Emit32(record, EmitType(member.type));
+                EmitString(record, member.name);
+            }
+            break;
+        }
+        case CType::TypeKind::kFunc: {
+            auto func_type = llvm::cast<CFuncType>(ctype);
+            EmitString(record, func_type->GetFuncName());
+            Emit32(record, EmitType(func_type->GetRetType()));
+            Emit32(record, func_type->has_body_);
+            Emit32(record, func_type->attrs_);
+            Emit32(record, func_type->GetParams().size());
+            for (const auto& param : func_type->GetParams()) {
+                Emit32(record, EmitType(param.type));
+                EmitString(record, param.name);
+            }
+            break;
+        }
+    }
+
+    type_offsets_[id] = type_data_.size();
+    type_data_.append(record.begin(), record.end());
+    return id;
+}
+
+void ModuleWriter::EmitNodeList(llvm::SmallVectorImpl<char>& buf, llvm::ArrayRef<AstNode*> nodes) {
+    llvm::SmallVector<uint32_t> ids;
+    for (auto node : nodes) {
+        ids.push_back(EmitNode(node));
+    }
+    Emit32(buf, ids.size());
+    for (auto id : ids) {
+        Emit32(buf, id);
+    }
+}
+
+uint32_t ModuleWriter::EmitNode(AstNode* node) {
+    if (!node) {
+        return kNone;
+    }
+
+    // `break`, `continue` and `case` refer to the statement containing them,
+    // which has been emitted already, so does a switch to its labels.
+    // A label used by `goto` or `&&` before its definition is emitted at the
+    // first use, and found here when its definition is reached.
+    auto iter = node_ids_.find(node);
+    if (iter != node_ids_.end()) {
+        return iter->second;
+    }
+
+    uint32_t id = node_offsets_.size();
+    node_ids_.insert({ node, id });
+    node_offsets_.push_back(0);
+
+    // 1. Emit the data shared by all the nodes.
+    //    Only the content of the bound token is kept, which holds the names.
+    llvm::SmallVector<char> record;
+    Emit32(record, static_cast<uint32_t>(node->GetNodeKind()) | (node->IsLValue() << 8));
+    Emit32(record, EmitType(node->GetCType()));
+    EmitString(record, node->GetBoundToken().GetContent());
+
+    // 2. Emit the data specific to this kind of node.
+    switch (node->GetNodeKind()) {
+        case AstNode::AstNodeKind::kDeclStmt: {
+            EmitNodeList(record, llvm::cast<DeclStmt>(node)->nodes_);
+            break;
+        }
+        case AstNode::AstNodeKind::kBlockStmt: {
+            EmitNodeList(record, llvm::cast<BlockStmt>(node)->nodes_);
+            break;
+        }
+        case AstNode::AstNodeKind::kIfStmt: {
+            auto if_stmt = llvm::cast<IfStmt>(node);
+            Emit32(record, EmitNode(if_stmt->cond_node_));
+            Emit32(record, EmitNode(if_stmt->then_node_));
+            Emit32(record, EmitNode(if_stmt->else_node_));
+            break;
+        }
+        case AstNode::AstNodeKind::kForStmt: {
+            auto for_stmt = llvm::cast<ForStmt>(node);
+            Emit32(record, EmitNode(for_stmt->init_node_));
+            Emit32(record, EmitNode(for_stmt->cond_node_));
+            Emit32(record, EmitNode(for_stmt->inc_node_));
+            Emit32(record, EmitNode(for_stmt->body_node_));
+            break;
+        }
+        case AstNode::AstNodeKind::kBreakStmt: {
+            Emit32(record, EmitNode(llvm::cast<BreakStmt>(node)->target_));
+            break;
+        }
+        case AstNode::AstNodeKind::kContinueStmt: {
+            Emit32(record, EmitNode(llvm::cast<ContinueStmt>(node)->target_));
+            break;
+        }
+        case AstNode::AstNodeKind::kSwitchStmt: {
+            auto switch_stmt = llvm::cast<SwitchStmt>(node);
+            Emit32(record, EmitNode(switch_stmt->cond_node_));
+            Emit32(record, EmitNode(switch_stmt->body_node_));
+            EmitNodeList(record, switch_stmt->case_nodes_);
+            break;
+        }
+        case AstNode::AstNodeKind::kCaseStmt: {
+            auto case_stmt = llvm::cast<CaseStmt>(node);
+            Emit32(record, EmitNode(case_stmt->value_node_));
+            Emit32(record, EmitNode(case_stmt->sub_stmt_));
+            Emit32(record, EmitNode(case_stmt->target_));
+            break;
+        }
+        case AstNode::AstNodeKind::kLabelStmt: {
+            auto label_stmt = llvm::cast<LabelStmt>(node);
+            Emit32(record, EmitNode(label_stmt->sub_stmt_));
+            Emit32(record, label_stmt->is_address_taken_);
+            break;
+        }
+        case AstNode::AstNodeKind::kGotoStmt: {
+            Emit32(record, EmitNode(llvm::cast<GotoStmt>(node)->target_));
+            break;
+        }
+        case AstNode::AstNodeKind::kIndirectGotoStmt: {
+            Emit32(record, EmitNode(llvm::cast<IndirectGotoStmt>(node)->target_node_));
+            break;
+        }
+        case AstNode::AstNodeKind::kUnaryExpr: {
+            auto expr = static_cast<UnaryExpr*>(node);
+            Emit32(record, static_cast<uint32_t>(expr->op_));
+            Emit32(record, EmitNode(expr->sub_node_));
+            break;
+        }
+        case AstNode::AstNodeKind::kBinaryExpr: {
+            auto expr = llvm::cast<BinaryExpr>(node);
+            Emit32(record, static_cast<uint32_t>(expr->op_));
+            Emit32(record, EmitNode(expr->left_));
+            Emit32(record, EmitNode(expr->right_));
+            break;
+        }
+        case AstNode::AstNodeKind::kTernaryExpr: {
+            auto expr = llvm::cast<TernaryExpr>(node);
+            Emit32(record, EmitNode(expr->cond_));
+            Emit32(record, EmitNode(expr->then_));
+            Emit32(record, EmitNode(expr->els_));
+            break;
+        }
+        case AstNode::AstNodeKind::kVariableDecl: {
+            auto decl = llvm::cast<VariableDecl>(node);
+            Emit32(record, decl->is_global_);
+            Emit32(record, decl->is_address_taken_);
+            Emit32(record, static_cast<uint32_t>(decl->storage_class_));
+            Emit32(record, decl->static_array_size_);
+            Emit32(record, decl->init_values_.size());
+            for (const auto init_value : decl->init_values_) {
+                Emit32(record, EmitType(init_value->decl_type));
+                Emit32(record, EmitNode(init_value->init_node));
+                Emit32(record, init_value->index_list.size());
+                for (auto index : init_value->index_list) {
+                    Emit32(record, index);
+                }
+            }
+            break;
+        }
+        case AstNode::AstNodeKind::kNumberExpr: {
+            Emit32(record, llvm::cast<NumberExpr>(node)->GetNumber());
+            break;
+        }
+        case AstNode::AstNodeKind::kVariableAccessExpr: {
+            Emit32(record, EmitNode(llvm::cast<VariableAccessExpr>(node)->decl_));
+            break;
+        }
+        case AstNode::AstNodeKind::kSizeof: {
+            auto expr = llvm::cast<SizeofExpr>(node);
+            Emit32(record, EmitNode(expr->sub_node_));
+            Emit32(record, EmitType(expr->sub_ctype_));
+            break;
+        }
+        case AstNode::AstNodeKind::kAddrLabelExpr: {
+            Emit32(record, EmitNode(llvm::cast<AddrLabelExpr>(node)->target_));
+            break;
+        }
+        case AstNode::AstNodeKind::kPostIncExpr: {
+            Emit32(record, EmitNode(llvm::cast<PostIncExpr>(node)->sub_node_));
+            break;
+        }
+        case AstNode::AstNodeKind::kPostDecExpr: {
+            Emit32(record, EmitNode(llvm::cast<PostDecExpr>(node)->sub_node_));
+            break;
+        }
+        case AstNode::AstNodeKind::kPostSubscriptExpr: {
+            auto expr = llvm::cast<PostSubscriptExpr>(node);
+            Emit32(record, EmitNode(expr->sub_node_));
+            Emit32(record, EmitNode(expr->index_node_));
+            break;
+        }
+        case AstNode::AstNodeKind::kPostMemberDotExpr: {
+            auto expr = llvm::cast<PostMemberDotExpr>(node);
+            Emit32(record, EmitNode(expr->struct_node_));
+            Emit32(record, EmitType(expr->struct_node_->GetCType()));
+            Emit32(record, expr->target_member_.rank);
+            break;
+        }
+        case AstNode::AstNodeKind::kPostMemberArrowExpr: {
+            auto expr = llvm::cast<PostMemberArrowExpr>(node);
+            auto pointer_type = llvm::cast<CPointerType>(expr->struct_pointer_node_->GetCType().get());
+            Emit32(record, EmitNode(expr->struct_pointer_node_));
+            Emit32(record, EmitType(pointer_type->GetBaseType()));
+            Emit32(record, expr->target_member_.rank);
+            break;
+        }
+        case AstNode::AstNodeKind::kFuncDecl: {
+            auto func_decl = llvm::cast<FuncDecl>(node);
+            EmitNodeList(record, func_decl->params_);
+            Emit32(record, EmitNode(func_decl->block_stmt_));
+            Emit32(record, static_cast<uint32_t>(func_decl->storage_class_));
+            Emit32(record, func_decl->is_inline_);
+            break;
+        }
+        case AstNode::AstNodeKind::kPostFuncCallExpr: {
+            auto expr = llvm::cast<PostFuncCallExpr>(node);
+            Emit32(record, EmitNode(expr->func_node_));
+            EmitNodeList(record, expr->arg_nodes_);
+            break;
+        }
+        case AstNode::AstNodeKind::kReturnStmt: {
+            Emit32(record, EmitNode(llvm::cast<ReturnStmt>(node)->value_node_));
+            break;
+        }
+    }
+
+    node_offsets_[id] = node_data_.size();
+    node_data_.append(record.begin(), record.end());
+    return id;
+}
+
+void ModuleWriter::Write(llvm::raw_ostream& out) {
+    // 1. Emit the nodes, together with the types and strings they refer to.
+    llvm::SmallVector<uint32_t> top_level_ids;
+    for (auto node : program_->nodes_) {
+        top_level_ids.push_back(EmitNode(node));
+    }
+
+    // 2. Emit the symbols in the global scope, sorted by name,
+    //    so that the same program is always saved into the same file.
+    llvm::SmallVector<Symbol*> symbols(scope_.GetGlobalSymbols().begin(),
+                                       scope_.GetGlobalSymbols().end());
+    llvm::sort(symbols, [](const Symbol* a, const Symbol* b) {
+        return std::make_pair(a->GetSymbolKind(), a->GetSymbolName()) <
+               std::make_pair(b->GetSymbolKind(), b->GetSymbolName());
+    });
+
+    llvm::SmallVector<char> symbol_data;
+    for (auto symbol : symbols) {
+        Emit32(symbol_data, static_cast<uint32_t>(symbol->GetSymbolKind()));
+        EmitString(symbol_data, symbol->GetSymbolName());
+        Emit32(symbol_data, EmitType(symbol->GetCType()));
+        Emit32(symbol_data, EmitNode(symbol->GetDecl()));
+    }
+
+    // 3. Lay out the sections, every section starts at a 4-byte boundary.
+    module_file::Header header;
+    std::memcpy(header.magic, module_file::kMagic, sizeof(header.magic));
+    header.version = module_file::kVersion;
+    header.file_name_offset = InternString(program_->file_name_);
+    header.file_name_size = program_->file_name_.size();
+
+    AlignTo4(strings_);
+    uint32_t offset = kHeaderSize;
+    header.strings_offset = offset;
+    header.strings_size = strings_.size();
+    offset += strings_.size();
+
+    header.type_count = type_offsets_.size();
+    header.type_index_offset = offset;
+    offset += type_offsets_.size() * 4;
+    header.type_data_offset = offset;
+    header.type_data_size = type_data_.size();
+    offset += type_data_.size();
+
+    header.node_count = node_offsets_.size();
+    header.node_index_offset = offset;
+    offset += node_offsets_.size() * 4;
+    header.node_data_offset = offset;
+    header.node_data_size = node_data_.size();
+    offset += node_data_.size();
+
+    header.top_level_count = top_level_ids.size();
+    header.top_level_offset = offset;
+    offset += top_level_ids.size() * 4;
+
+    header.symbol_count = symbols.size();
+    header.symbol_offset = offset;
+    offset += symbol_data.size();
+
+    // 4. Write out the whole file.
+    llvm::SmallVector<char> file;
+    file.reserve(offset);
+    file.append(header.magic, header.magic + sizeof(header.magic));
+    for (uint32_t value : { header.version,
+                            header.file_name_offset, header.file_name_size,
+                            header.strings_offset, header.strings_size,
+                            header.type_count, header.type_index_offset, 
+                            header.type_data_offset, header.type_data_size,
+                            header.node_count, header.node_index_offset, 
+                            header.node_data_offset, header.node_data_size,
+                            header.top_level_count, header.top_level_offset,
+                            header.symbol_count, header.symbol_offset })
+    {
+        Emit32(file, value);
+    }
+    assert(file.size() == kHeaderSize);
+
+    file.append(strings_.begin(), strings_.end());
+    for (auto type_offset : type_offsets_) {
+        Emit32(file, type_offset);
+    }
+    file.append(type_data_.begin(), type_data_.end());
+    for (auto node_offset : node_offsets_) {
+        Emit32(file, node_offset);
+    }
+    file.append(node_data_.begin(), node_data_.end());
+    for (auto id : top_level_ids) {
+        Emit32(file, id);
+    }
+    file.append(symbol_data.begin(), symbol_data.end());
+    assert(file.size() == offset);
+
+    out.write(file.data(), file.size());
+}
+
+ModuleReader::ModuleReader(std::unique_ptr<llvm::MemoryBuffer> buf)
+    : buf_(std::move(buf)), program_(std::make_shared<Program>())
+{
+    // 1. Check the magic and version.
+    if (buf_->getBufferSize() < kHeaderSize ||
+        std::memcmp(buf_->getBufferStart(), module_file::kMagic, sizeof(module_file::kMagic)) != 0)
+    {
+        return;
+    }
+
+    // 2. Read the remaining fields of header.
+    uint32_t offset = sizeof(module_file::kMagic);
+    std::memcpy(header_.magic, module_file::kMagic, sizeof(header_.magic));
+    header_.version = Read32(offset);
+    if (header_.version != module_file::kVersion) {
+        return;
+    }
+    for (uint32_t* field : { &header_.file_name_offset, &header_.file_name_size,
+                             &header_.strings_offset, &header_.strings_size,
+                             &header_.type_count, &header_.type_index_offset, 
+                             &header_.type_data_offset, &header_.type_data_size,
+                             &header_.node_count, &header_.node_index_offset, 
+                             &header_.node_data_offset, &header_.node_data_size,
+                             &header_.top_level_count, &header_.top_level_offset,
+                             &header_.symbol_count, &header_.symbol_offset })
+    {
+        *field = Read32(offset);
+    }
+
+    // 3. Make sure that every section lies in the file.
+    if (!IsSectionValid(header_.strings_offset, header_.strings_size) ||
+        !IsSectionValid(header_.type_index_offset, header_.type_count * 4ull) ||
+        !IsSectionValid(header_.type_data_offset, header_.type_data_size) ||
+        !IsSectionValid(header_.node_index_offset, header_.node_count * 4ull) ||
+        !IsSectionValid(header_.node_data_offset, header_.node_data_size) ||
+        !IsSectionValid(header_.top_level_offset, header_.top_level_count * 4ull) ||
+        !IsSectionValid(header_.symbol_offset, header_.symbol_count * 20ull) ||
+        header_.type_count < 2)
+    {
+        return;
+    }
+
+    // 4. Make sure that every record, and the file name, lies in its section.
+    if (!IsIndexValid(header_.type_index_offset, header_.type_count, header_.type_data_size) ||
+        !IsIndexValid(header_.node_index_offset, header_.node_count, header_.node_data_size) ||
+        uint64_t(header_.file_name_offset) + header_.file_name_size > header_.strings_size)
+    {
+        return;
+    }
+
+    // NOTE:
+    // Nothing else is decoded here,
+    // types and nodes are built when they are first used.
+    types_.resize(header_.type_count);
+    decoding_types_.resize(header_.type_count);
+    nodes_.resize(header_.node_count);
+    decoding_nodes_.resize(header_.node_count);
+    program_->file_name_ = GetFileName();
+    is_valid_ = true;
+}
+
+std::unique_ptr<ModuleReader> ModuleReader::Open(llvm::StringRef path) {
+    // Without the null terminator, LLVM is free to map the file into memory.
+    auto buf = llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buf) {
+        return nullptr;
+    }
+
+    auto reader = std::make_unique<ModuleReader>(std::move(*buf));
+    if (!reader->IsValid()) {
+        return nullptr;
+    }
+    return reader;
+}
+
+bool ModuleReader::IsSectionValid(uint32_t offset, uint64_t size) const {
+    return offset % 4 == 0 && offset + size <= buf_->getBufferSize();
+}
+
+bool ModuleReader::IsIndexValid(uint32_t index_offset, uint32_t count, uint32_t data_size) const {
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t offset = index_offset + i * 4;
+        uint32_t record_offset = Read32(offset);
+        // Each record starts with its kind.
+        if (record_offset % 4 != 0 || record_offset + 4ull > data_size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t ModuleReader::Read32(uint32_t& offset) const {
+    if (offset + 4ull > buf_->getBufferSize()) {
+        llvm::report_fatal_error("invalid module file: read out of the file");
+    }
+    uint32_t value = llvm::support::endian::read32le(buf_->getBufferStart() + offset);
+    offset += 4;
+    return value;
+}
+
+llvm::StringRef ModuleReader::ReadString(uint32_t& offset) const {
+    uint32_t string_offset = Read32(offset);
+    uint32_t string_size = Read32(offset);
+    if (uint64_t(string_offset) + string_size > header_.strings_size) {
+        llvm::report_fatal_error("invalid module file: string out of the string section");
+    }
+    return llvm::StringRef(buf_->getBufferStart() + header_.strings_offset + string_offset, string_size);
+}
+
+llvm::StringRef ModuleReader::GetFileName() const {
+    return llvm::StringRef(buf_->getBufferStart() + header_.strings_offset + header_.file_name_offset,
+                           header_.file_name_size);
+}
+
+uint32_t ModuleReader::GetTypeOffset(uint32_t id) const {
+    assert(id < header_.type_count);
+    uint32_t offset = header_.type_index_offset + id * 4;
+    return header_.type_data_offset + Read32(offset);
+}
+
+uint32_t ModuleReader::GetNodeOffset(uint32_t id) const {
+    assert(id < header_.node_count);
+    uint32_t offset = header_.node_index_offset + id * 4;
+    return header_.node_data_offset + Read32(offset);
+}
+
+std::shared_ptr<CType> ModuleReader::GetType(uint32_t id) {
+    if (id == kNone) {
+        return nullptr;
+    }
+    if (id >= types_.size()) {
+        llvm::report_fatal_error("invalid module file: type id out of range");
+    }
+    if (!types_[id]) {
+        // NOTE:
+        // A record type is cached before its members are decoded, so a cycle
+        // through a record ends there. Any other cycle is a broken file.
+        if (decoding_types_[id]) {
+            llvm::report_fatal_error("invalid module file: type refers to itself");
+        }
+        decoding_types_[id] = true;
+        types_[id] = DecodeType(id);
+        decoding_types_[id] = false;
+    }
+    return types_[id];
+}
+
+std::shared_ptr<CType> ModuleReader::DecodeType(uint32_t id) {
+    uint32_t offset = GetTypeOffset(id);
+    uint32_t kind_and_quals = Read32(offset);
+    auto kind = static_cast<CType::TypeKind>(kind_and_quals & 0xff);
+    auto qualify = [&](std::shared_ptr<CType> ctype) {
+        bool is_const = (kind_and_quals >> 8) & 1;
+        bool is_restrict = kind == CType::TypeKind::kPointer && ((kind_and_quals >> 9) & 1);
+        return type_context_->GetQualifiedType(ctype, is_const, is_restrict);
+    };
+    switch (kind) {
+        case CType::TypeKind::kInt:
+            return qualify(CType::kIntType);
+        case CType::TypeKind::kVoid:
+            return qualify(CType::kVoidType);
+        case CType::TypeKind::kPointer: {
+            auto base_type = GetType(Read32(offset));
+            return qualify(type_context_->GetPointerType(base_type));
+        }
+        case CType::TypeKind::kArray: {
+            auto element_type = GetType(Read32(offset));
+            int element_count = Read32(offset);
+            return type_context_->GetArrayType(element_type, element_count);
+        }
+        case CType::TypeKind::kRecord: {
+            auto tag_kind = static_cast<CType::TagKind>(Read32(offset));
+            auto name = ReadString(offset);
+            auto record_type = std::make_shared<CRecordType>(name, tag_kind);
+            // Cache the record type before decoding its members,
+            // which may refer to the record type itself.
+            types_[id] = record_type;
+            // The types outside the record may be reached again from its members,
+            // e.g. the pointer type of `struct Node *next`.
+            auto outer_decoding_types = std::exchange(decoding_types_, std::vector<bool>(types_.size()));
+
+            std::vector<CRecordType::Member> members;
+            uint32_t member_count = Read32(offset);
+            for (uint32_t i = 0; i < member_count; ++i) {
+                auto member_type = GetType(Read32(offset));
+                auto member_name = ReadString(offset);
+                members.emplace_back(member_type, member_name);
+            }
+            decoding_types_ = std::move(outer_decoding_types);
+            record_type->SetMembers(std::move(members));
+            return record_type;
+        }
+        case CType::TypeKind::kFunc: {
+            auto func_name = ReadString(offset);
+            auto ret_type = GetType(Read32(offset));
+            bool has_body = Read32(offset);
+            uint32_t attrs = Read32(offset);
+
+            std::vector<CFuncType::Param> params;
+            uint32_t param_count = Read32(offset);
+            for (uint32_t i = 0; i < param_count; ++i) {
+                auto param_type = GetType(Read32(offset));
+                auto param_name = ReadString(offset);
+                params.emplace_back(param_type, param_name);
+            }
+            auto func_type = type_context_->GetFuncType(func_name, ret_type, std::move(params));
+            if (has_body) {
+                llvm::cast<CFuncType>(func_type.get())->has_body_ = true;
+            }
+            llvm::cast<CFuncType>(func_type.get())->attrs_ |= attrs;
+            return func_type;
+        }
+    }
+
+    llvm::report_fatal_error("invalid module file: unknown type kind");
+}
+
+AstNode* ModuleReader::GetNode(uint32_t id) {
+    if (id == kNone) {
+        return nullptr;
+    }
+    if (id >= nodes_.size()) {
+        llvm::report_fatal_error("invalid module file: node id out of range");
+    }
+    if (!nodes_[id]) {
+        uint32_t offset = GetNodeOffset(id);
+        uint32_t kind_offset = offset;
+        auto kind = static_cast<AstNode::AstNodeKind>(Read32(kind_offset) & 0xff);
+        // Cache the node before decoding its children,
+        // since `break` and `continue` refer back to the loop containing them.
+        nodes_[id] = CreateNode(kind);
+        decoding_nodes_[id] = true;
+        DecodeNode(nodes_[id], offset);
+        decoding_nodes_[id] = false;
+    }
+    return nodes_[id];
+}
+
+AstNode* ModuleReader::GetChildNode(uint32_t id) {
+    if (id != kNone && id < decoding_nodes_.size() && decoding_nodes_[id]) {
+        llvm::report_fatal_error("invalid module file: node is its own child");
+    }
+    return GetNode(id);
+}
+
+AstNode* ModuleReader::GetTopLevelNode(size_t i) {
+    assert(i < header_.top_level_count);
+    uint32_t offset = header_.top_level_offset + i * 4;
+    return GetNode(Read32(offset));
+}
+
+AstNode* ModuleReader::CreateNode(AstNode::AstNodeKind kind) {
+    switch (kind) {
+        case AstNode::AstNodeKind::kDeclStmt:
+            return program_->Create<DeclStmt>();
+        case AstNode::AstNodeKind::kBlockStmt:
+            return program_->Create<BlockStmt>();
+        case AstNode::AstNodeKind::kIfStmt:
+            return program_->Create<IfStmt>();
+        case AstNode::AstNodeKind::kForStmt:
+            return program_->Create<ForStmt>();
+        case AstNode::AstNodeKind::kBreakStmt:
+            return program_->Create<BreakStmt>();
+        case AstNode::AstNodeKind::kContinueStmt:
+            return program_->Create<ContinueStmt>();
+        case AstNode::AstNodeKind::kSwitchStmt:
+            return program_->Create<SwitchStmt>();
+        case AstNode::AstNodeKind::kCaseStmt:
+            return program_->Create<CaseStmt>();
+        case AstNode::AstNodeKind::kLabelStmt:
+            return program_->Create<LabelStmt>();
+        case AstNode::AstNodeKind::kGotoStmt:
+            return program_->Create<GotoStmt>();
+        case AstNode::AstNodeKind::kIndirectGotoStmt:
+            return program_->Create<IndirectGotoStmt>();
+        case AstNode::AstNodeKind::kUnaryExpr:
+            return program_->Create<UnaryExpr>();
+        case AstNode::AstNodeKind::kBinaryExpr:
+            return program_->Create<BinaryExpr>();
+        case AstNode::AstNodeKind::kTernaryExpr:
+            return program_->Create<TernaryExpr>();
+        case AstNode::AstNodeKind::kVariableDecl:
+            return program_->Create<VariableDecl>();
+        case AstNode::AstNodeKind::kNumberExpr:
+            return program_->Create<NumberExpr>();
+        case AstNode::AstNodeKind::kVariableAccessExpr:
+            return program_->Create<VariableAccessExpr>();
+        case AstNode::AstNodeKind::kSizeof:
+            return program_->Create<SizeofExpr>();
+        case AstNode::AstNodeKind::kAddrLabelExpr:
+            return program_->Create<AddrLabelExpr>();
+        case AstNode::AstNodeKind::kPostIncExpr:
+            return program_->Create<PostIncExpr>();
+        case AstNode::AstNodeKind::kPostDecExpr:
+            return program_->Create<PostDecExpr>();
+        case AstNode::AstNodeKind::kPostSubscriptExpr:
+            return program_->Create<PostSubscriptExpr>();
+        case AstNode::AstNodeKind::kPostMemberDotExpr:
+            return program_->Create<PostMemberDotExpr>();
+        case AstNode::AstNodeKind::kPostMemberArrowExpr:
+            return program_->Create<PostMemberArrowExpr>();
+        case AstNode::AstNodeKind::kFuncDecl:
+            return program_->Create<FuncDecl>();
+        case AstNode::AstNodeKind::kPostFuncCallExpr:
+            return program_->Create<PostFuncCallExpr>();
+        case AstNode::AstNodeKind::kReturnStmt:
+            return program_->Create<ReturnStmt>();
+    }
+
+    llvm::report_fatal_error("invalid module file: unknown node kind");
+}
+
+llvm::ArrayRef<AstNode*> ModuleReader::DecodeNodeList(uint32_t& offset) {
+    llvm::SmallVector<AstNode*> nodes;
+    uint32_t count = Read32(offset);
+    for (uint32_t i = 0; i < count; ++i) {
+        nodes.push_back(GetChildNode(Read32(offset)));
+    }
+    return program_->CopyArray<AstNode*>(nodes);
+}
+
+void ModuleReader::DecodeNode(AstNode* node, uint32_t offset) {
+    // 1. Decode the data shared by all the nodes.
+    node->SetLValue(Read32(offset) >> 8);
+    node->SetCType(GetType(Read32(offset)));
+
+    auto content = ReadString(offset);
+    Token token;
+    token.content_ptr_ = content.data();
+    token.content_length_ = content.size();
+
+    // 2. Decode the data specific to this kind of node.
+    //    NOTE: The jump targets and the declarations are referred to,
+    //    rather than owned, so they may be the nodes being decoded.
+    switch (node->GetNodeKind()) {
+        case AstNode::AstNodeKind::kDeclStmt: {
+            llvm::cast<DeclStmt>(node)->nodes_ = DecodeNodeList(offset);
+            break;
+        }
+        case AstNode::AstNodeKind::kBlockStmt: {
+            llvm::cast<BlockStmt>(node)->nodes_ = DecodeNodeList(offset);
+            break;
+        }
+        case AstNode::AstNodeKind::kIfStmt: {
+            auto if_stmt = llvm::cast<IfStmt>(node);
+            if_stmt->cond_node_ = GetChildNode(Read32(offset));
+            if_stmt->then_node_ = GetChildNode(Read32(offset));
+            if_stmt->else_node_ = GetChildNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kForStmt: {
+            auto for_stmt = llvm::cast<ForStmt>(node);
+            for_stmt->init_node_ = GetChildNode(Read32(offset));
+            for_stmt->cond_node_ = GetChildNode(Read32(offset));
+            for_stmt->inc_node_ = GetChildNode(Read32(offset));
+            for_stmt->body_node_ = GetChildNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kBreakStmt: {
+            llvm::cast<BreakStmt>(node)->target_ = GetNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kContinueStmt: {
+            llvm::cast<ContinueStmt>(node)->target_ = GetNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kSwitchStmt: {
+            auto switch_stmt = llvm::cast<SwitchStmt>(node);
+            switch_stmt->cond_node_ = GetChildNode(Read32(offset));
+            switch_stmt->body_node_ = GetChildNode(Read32(offset));
+            switch_stmt->case_nodes_ = DecodeNodeList(offset);
+            break;
+        }
+        case AstNode::AstNodeKind::kCaseStmt: {
+            auto case_stmt = llvm::cast<CaseStmt>(node);
+            case_stmt->value_node_ = GetChildNode(Read32(offset));
+            case_stmt->sub_stmt_ = GetChildNode(Read32(offset));
+            case_stmt->target_ = GetNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kLabelStmt: {
+            auto label_stmt = llvm::cast<LabelStmt>(node);
+            label_stmt->sub_stmt_ = GetChildNode(Read32(offset));
+            label_stmt->is_address_taken_ = Read32(offset);
+            break;
+        }
+        case AstNode::AstNodeKind::kGotoStmt: {
+            llvm::cast<GotoStmt>(node)->target_ = GetNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kIndirectGotoStmt: {
+            llvm::cast<IndirectGotoStmt>(node)->target_node_ = GetChildNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kUnaryExpr: {
+            auto expr = static_cast<UnaryExpr*>(node);
+            expr->op_ = static_cast<UnaryOpCode>(Read32(offset));
+            expr->sub_node_ = GetChildNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kBinaryExpr: {
+            auto expr = llvm::cast<BinaryExpr>(node);
+            expr->op_ = static_cast<BinaryOpCode>(Read32(offset));
+            expr->left_ = GetChildNode(Read32(offset));
+            expr->right_ = GetChildNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kTernaryExpr: {
+            auto expr = llvm::cast<TernaryExpr>(node);
+            expr->cond_ = GetChildNode(Read32(offset));
+            expr->then_ = GetChildNode(Read32(offset));
+            expr->els_ = GetChildNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kVariableDecl: {
+            auto decl = llvm::cast<VariableDecl>(node);
+            decl->is_global_ = Read32(offset);
+            decl->is_address_taken_ = Read32(offset);
+            decl->storage_class_ = static_cast<StorageClass>(Read32(offset));
+            decl->static_array_size_ = Read32(offset);
+
+            llvm::SmallVector<VariableDecl::InitValue*> init_values;
+            uint32_t init_count = Read32(offset);
+            for (uint32_t i = 0; i < init_count; ++i) {
+                auto init_value = program_->Create<VariableDecl::InitValue>();
+                init_value->decl_type = GetType(Read32(offset));
+                init_value->init_node = GetChildNode(Read32(offset));
+
+                llvm::SmallVector<int> index_list;
+                uint32_t index_count = Read32(offset);
+                for (uint32_t j = 0; j < index_count; ++j) {
+                    index_list.push_back(static_cast<int>(Read32(offset)));
+                }
+                init_value->index_list = program_->CopyArray<int>(index_list);
+                init_values.push_back(init_value);
+            }
+            decl->init_values_ = program_->CopyArray<VariableDecl::InitValue*>(init_values);
+            break;
+        }
+        case AstNode::AstNodeKind::kNumberExpr: {
+            token.value_ = Read32(offset);
+            break;
+        }
+        case AstNode::AstNodeKind::kVariableAccessExpr: {
+            llvm::cast<VariableAccessExpr>(node)->decl_ = GetNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kSizeof: {
+            auto expr = llvm::cast<SizeofExpr>(node);
+            expr->sub_node_ = GetChildNode(Read32(offset));
+            expr->sub_ctype_ = GetType(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kAddrLabelExpr: {
+            llvm::cast<AddrLabelExpr>(node)->target_ = GetNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kPostIncExpr: {
+            llvm::cast<PostIncExpr>(node)->sub_node_ = GetChildNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kPostDecExpr: {
+            llvm::cast<PostDecExpr>(node)->sub_node_ = GetChildNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kPostSubscriptExpr: {
+            auto expr = llvm::cast<PostSubscriptExpr>(node);
+            expr->sub_node_ = GetChildNode(Read32(offset));
+            expr->index_node_ = GetChildNode(Read32(offset));
+            break;
+        }
+        case AstNode::AstNodeKind::kPostMemberDotExpr: {
+            auto expr = llvm::cast<PostMemberDotExpr>(node);
+            expr->struct_node_ = GetChildNode(Read32(offset));
+            auto record_type = llvm::cast<CRecordType>(GetType(Read32(offset)).get());
+            expr->target_member_ = record_type->GetMembers()[Read32(offset)];
+            break;
+        }
+        case AstNode::AstNodeKind::kPostMemberArrowExpr: {
+            auto expr = llvm::cast<PostMemberArrowExpr>(node);
+            expr->struct_pointer_node_ = GetChildNode(Read32(offset));
+            auto record_type = llvm::cast<CRecordType>(GetType(Read32(offset)).get());
+            expr->target_member_ = record_type->GetMembers()[Read32(offset)];
+            break;
+        }
+        case AstNode::AstNodeKind::kFuncDecl: {
+            auto func_decl = llvm::cast<FuncDecl>(node);
+            func_decl->params_ = DecodeNodeList(offset);
+            func_decl->block_stmt_ = GetChildNode(Read32(offset));
+            func_decl->storage_class_ = static_cast<StorageClass>(Read32(offset));
+            func_decl->is_inline_ = Read32(offset);
+            break;
+        }
+        case AstNode::AstNodeKind::kPostFuncCallExpr: {
+            auto expr = llvm::cast<PostFuncCallExpr>(node);
+            expr->func_node_ = GetChildNode(Read32(offset));
+            expr->arg_nodes_ = DecodeNodeList(offset);
+            break;
+        }
+        case AstNode::AstNodeKind::kReturnStmt: {
+            llvm::cast<ReturnStmt>(node)->value_node_ = GetChildNode(Read32(offset));
+            break;
+        }
+    }
+
+    node->SetBoundToken(token);
+
+    // 3. The folded values aren't saved in the file, since they can be
+    //    computed from the children cheaply.
+    node->SetConstantValue(ConstEvaluator::Evaluate(node));
+}
+
+void ModuleReader::ImportSymbols(Scope& scope, TypeContext& type_context) {
+    type_context_ = &type_context;
+
+    uint32_t offset = header_.symbol_offset;
+    for (uint32_t i = 0; i < header_.symbol_count; ++i) {
+        auto kind = static_cast<SymbolKind>(Read32(offset));
+        auto name = ReadString(offset);
+        auto ctype = GetType(Read32(offset));
+        auto decl_id = Read32(offset);
+        switch (kind) {
+            case SymbolKind::kObject:
+                // The functions are looked up by name in codegen,
+                // so only the declarations of the global variables are needed.
+                scope.AddObjectSymbol(name, ctype,
+                                      llvm::isa<CFuncType>(ctype.get()) ? nullptr : GetNode(decl_id));
+                break;
+            case SymbolKind::kTag:
+                scope.AddTagSymbol(name, ctype);
+                break;
+        }
+    }
+}
+
+std::shared_ptr<Program> ModuleReader::LoadProgram() {
+    if (program_->nodes_.size() != header_.top_level_count) {
+        program_->nodes_.clear();
+        for (size_t i = 0; i < header_.top_level_count; ++i) {
+            program_->nodes_.push_back(GetTopLevelNode(i));
+        }
+    }
+    return program_;
+}
@@ -0,0 +1,171 @@
+// Copyright 2025 WU-SUNFLOWER. All rights reserved.
+// Use of this source code is governed by a GPL-style license that can be
+// found in the LICENSE file.
+
+#ifndef MODULE_FILE_H_
+#define MODULE_FILE_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "ast.h"
+#include "scope.h"
+#include "type.h"
+
+// A precompiled module is a checked program saved in a binary file,
+// so that it can be imported later without running lexer, parser and sema.
+//
+// All the integers in the file are 32-bit little-endian, and each object
+// refers to the others by index, so the file can be mapped into memory and
+// used in place. The layout is:
+//
+//   Header        magic, version, and the position and size of each section below
+//   Strings       raw bytes, a string is stored as (offset, length)
+//   Types         offset of each type record, then the records
+//   Nodes         offset of each node record, then the records
+//   Top-level     index of each top-level node
+//   Symbols       (kind, name, type, decl) of each symbol in the global scope
+namespace module_file {
+
+constexpr char kMagic[8] = { 'N', 'A', 'I', 'V', 'E', 'C', 'M', 'F' };
+constexpr uint32_t kVersion = 10;
+
+// Used for a missing child node or type.
+constexpr uint32_t kNone = UINT32_MAX;
+
+// Type 0 and 1 are always the built-in `int` and `void`.
+constexpr uint32_t kIntTypeId = 0;
+constexpr uint32_t kVoidTypeId = 1;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t file_name_offset, file_name_size;
+    uint32_t strings_offset, strings_size;
+    uint32_t type_count, type_index_offset, type_data_offset, type_data_size;
+    uint32_t node_count, node_index_offset, node_data_offset, node_data_size;
+    uint32_t top_level_count, top_level_offset;
+    uint32_t symbol_count, symbol_offset;
+};
+
+}  // namespace module_file
+
+class ModuleWriter {
+ private:
+    std::shared_ptr<Program> program_;
+    Scope& scope_;
+
+    llvm::SmallVector<char> strings_;
+    llvm::StringMap<uint32_t> string_offsets_;
+
+    std::vector<uint32_t> type_offsets_;
+    llvm::SmallVector<char> type_data_;
+    llvm::DenseMap<CType*, uint32_t> type_ids_;
+
+    std::vector<uint32_t> node_offsets_;
+    llvm::SmallVector<char> node_data_;
+    llvm::DenseMap<AstNode*, uint32_t> node_ids_;
+
+    uint32_t InternString(llvm::StringRef str);
+    void EmitString(llvm::SmallVectorImpl<char>& buf, llvm::StringRef str);
+    uint32_t EmitType(CType* ctype);
+    uint32_t EmitType(const std::shared_ptr<CType>& ctype) {
+        return EmitType(ctype.get());
+    }
+    uint32_t EmitNode(AstNode* node);
+    void EmitNodeList(llvm::SmallVectorImpl<char>& buf, llvm::ArrayRef<AstNode*> nodes);
+
+ public:
+    // `scope` should be the one used to check `program`,
+    // its global symbols are saved together with the nodes.
+    ModuleWriter(std::shared_ptr<Program> program, Scope& scope);
+
+    void Write(llvm::raw_ostream& out);
+};
+
+// The reader decodes the types and nodes lazily, i.e. an object is built
+// from its record when it is first used. The names in the nodes, types and
+// symbols refer to the memory of the file directly, so the reader should
+// outlive all of them.
+class ModuleReader {
+ private:
+    std::unique_ptr<llvm::MemoryBuffer> buf_;
+    module_file::Header header_ {};
+    bool is_valid_ { false };
+
+    std::shared_ptr<Program> program_;
+    std::vector<std::shared_ptr<CType>> types_;
+    // The types and nodes being decoded, to catch the cycles in a broken file.
+    std::vector<bool> decoding_types_;
+    std::vector<bool> decoding_nodes_;
+
+    // The decoded types are interned in `type_context_`, which is our own one
+    // until the symbols are imported into a compilation.
+    TypeContext own_type_context_;
+    TypeContext* type_context_ { &own_type_context_ };
+    std::vector<AstNode*> nodes_;
+
+    // Read a value at `offset`, and move `offset` to the next one.
+    // NOTE:
+    // The constructor only checks the layout of the file, so a broken record
+    // can still refer to anything. Such a read is a fatal error, instead of
+    // going out of the file.
+    uint32_t Read32(uint32_t& offset) const;
+    llvm::StringRef ReadString(uint32_t& offset) const;
+
+    uint32_t GetTypeOffset(uint32_t id) const;
+    uint32_t GetNodeOffset(uint32_t id) const;
+
+    std::shared_ptr<CType> DecodeType(uint32_t id);
+    AstNode* CreateNode(AstNode::AstNodeKind kind);
+    // Like `GetNode`, but for a child, which can't be one of its ancestors.
+    AstNode* GetChildNode(uint32_t id);
+    void DecodeNode(AstNode* node, uint32_t offset);
+    llvm::ArrayRef<AstNode*> DecodeNodeList(uint32_t& offset);
+    bool IsSectionValid(uint32_t offset, uint64_t size) const;
+    // Check that each offset in the index at `index_offset` points to
+    // a record in the data section.
+    bool IsIndexValid(uint32_t index_offset, uint32_t count, uint32_t data_size) const;
+
+ public:
+    explicit ModuleReader(std::unique_ptr<llvm::MemoryBuffer> buf);
+
+    // Map the file into memory, return `nullptr` if it isn't a valid module.
+    static std::unique_ptr<ModuleReader> Open(llvm::StringRef path);
+
+    bool IsValid() const {
+        return is_valid_;
+    }
+
+    llvm::StringRef GetFileName() const;
+
+    std::shared_ptr<CType> GetType(uint32_t id);
+    AstNode* GetNode(uint32_t id);
+
+    size_t GetTopLevelNodeCount() const {
+        return header_.top_level_count;
+    }
+
+    AstNode* GetTopLevelNode(size_t i);
+
+    // Add the global symbols of the module to `scope`, so that a program
+    // parsed later can refer to them. Only the types of the symbols and the
+    // declarations of the global variables are decoded.
+    //
+    // From now on, the types are interned in `type_context`, which should be
+    // the one of the compilation using `scope`, and should outlive the reader.
+    void ImportSymbols(Scope& scope, TypeContext& type_context);
+
+    // Decode all the top-level nodes, and return the program owning them.
+    std::shared_ptr<Program> LoadProgram();
+};
+
+#endif  // MODULE_FILE_H_
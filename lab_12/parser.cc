@@ -13,13 +13,21 @@ bool IsTypeName(TokenType token_type) {
     return (token_type == TokenType::kInt ||
             token_type == TokenType::kStruct ||
             token_type == TokenType::kUnion ||
-            token_type == TokenType::kVoid);
+            token_type == TokenType::kVoid ||
+            token_type == TokenType::kConst);
 }
 
 bool IsTypeName(const Token& token) {
     return IsTypeName(token.GetType());
 }
 
+bool IsDeclSpec(const Token& token) {
+    return (IsTypeName(token) ||
+            token.GetType() == TokenType::kStatic ||
+            token.GetType() == TokenType::kInline ||
+            token.GetType() == TokenType::kAttribute);
+}
+
 Parser::Parser(Lexer& lexer, Sema& sema) : lexer_(lexer), sema_(sema) {
     Advance();
 }
@@ -31,7 +39,8 @@ bool Parser::IsFuncDecl() {
     lexer_.SaveState();
     sema_.SetMode(Sema::Mode::kSkip);
     {
-        auto base_type = ParseDeclSpec();
+        DeclSpec spec;
+        auto base_type = ParseDeclSpec(&spec);
         if (token_.GetType() != TokenType::kSemi) {
             auto decl_node = ParseDeclarator(base_type, true);
             if (decl_node->GetCType()->GetKind() == CType::TypeKind::kFunc) {
@@ -46,10 +55,27 @@ bool Parser::IsFuncDecl() {
     return is_func_decl;
 }
 
+bool Parser::IsLabel() {
+    if (token_.GetType() != TokenType::kIdentifier) {
+        return false;
+    }
+
+    Token next;
+    lexer_.SaveState();
+    lexer_.GetNextToken(next);
+    lexer_.RestoreState();
+
+    return next.GetType() == TokenType::kColon;
+}
+
 std::shared_ptr<Program> Parser::ParseProgram() {
     auto prog = std::make_shared<Program>();
     prog->file_name_ = lexer_.GetFileName();
 
+    // All the AST nodes will be allocated in the arena of this program.
+    program_ = prog.get();
+    sema_.SetProgram(program_);
+
     while (token_.GetType() != TokenType::kEOF) {
         auto node = IsFuncDecl() ? ParseFuncDecl() : 
                                    ParseDeclStmt(true);
@@ -62,12 +88,13 @@ std::shared_ptr<Program> Parser::ParseProgram() {
     return prog;
 }
 
-std::shared_ptr<AstNode> Parser::ParseFuncDecl() {
-    auto base_type = ParseDeclSpec();
+AstNode* Parser::ParseFuncDecl() {
+    DeclSpec spec;
+    auto base_type = ParseDeclSpec(&spec);
 
     Token func_name_token;
     std::shared_ptr<CType> func_type = nullptr;
-    std::shared_ptr<AstNode> func_body_node = nullptr;
+    AstNode* func_body_node = nullptr;
 
     // NOTE:
     // Since the variables in function's parameter list are in
@@ -80,16 +107,20 @@ std::shared_ptr<AstNode> Parser::ParseFuncDecl() {
         
         func_name_token = decl_node->GetBoundToken();
         func_type = decl_node->GetCType();
+        sema_.SemaFuncAttrs(func_type, spec.attrs);
 
         if (token_.GetType() == TokenType::kLBrace) {
+            sema_.SetCurrentFuncType(func_type);
             func_body_node = ParseBlockStmt();
+            sema_.SetCurrentFuncType(nullptr);
         }
     }
     sema_.ExitScope();
 
     // Create function declare node, 
     // and add the function's name to symbol table.
-    auto func_decl_node = sema_.SemaFuncDecl(func_name_token, func_type, func_body_node);
+    auto func_decl_node = sema_.SemaFuncDecl(func_name_token, func_type, func_param_nodes_, func_body_node,
+                                             spec.storage_class, spec.is_inline);
 
     // Eliminate potential redundant semicolons.
     while (token_.GetType() == TokenType::kSemi) {
@@ -99,14 +130,14 @@ std::shared_ptr<AstNode> Parser::ParseFuncDecl() {
     return func_decl_node;
 }
 
-std::shared_ptr<AstNode> Parser::ParseStmt() {
+AstNode* Parser::ParseStmt() {
 #define TOKEN_TYPE_IS(type) (token_.GetType() == type)
 
     if (TOKEN_TYPE_IS(TokenType::kSemi)) {
         Advance();
         return nullptr;
     }
-    else if (IsTypeName(token_)) {
+    else if (IsDeclSpec(token_)) {
         return ParseDeclStmt(false);
     }
     else if (TOKEN_TYPE_IS(TokenType::kIf)) {
@@ -124,6 +155,18 @@ std::shared_ptr<AstNode> Parser::ParseStmt() {
     else if (TOKEN_TYPE_IS(TokenType::kContinue)) {
         return ParseContinueStmt();
     }
+    else if (TOKEN_TYPE_IS(TokenType::kSwitch)) {
+        return ParseSwitchStmt();
+    }
+    else if (TOKEN_TYPE_IS(TokenType::kCase) || TOKEN_TYPE_IS(TokenType::kDefault)) {
+        return ParseCaseStmt();
+    }
+    else if (TOKEN_TYPE_IS(TokenType::kGoto)) {
+        return ParseGotoStmt();
+    }
+    else if (IsLabel()) {
+        return ParseLabelStmt();
+    }
     else if (TOKEN_TYPE_IS(TokenType::kReturn)) {
         return ParseReturnStmt();
     }
@@ -133,27 +176,81 @@ std::shared_ptr<AstNode> Parser::ParseStmt() {
     return ParseExprStmt();
 }
 
-std::shared_ptr<CType> Parser::ParseDeclSpec() {
+std::shared_ptr<CType> Parser::ParseDeclSpec(DeclSpec* spec) {
+    // `const` may come before or after the type, e.g. `const int` or `int const`.
+    Token const_token;
+    bool is_const = false;
+
+    while (token_.GetType() == TokenType::kStatic || 
+           token_.GetType() == TokenType::kInline ||
+           token_.GetType() == TokenType::kConst ||
+           token_.GetType() == TokenType::kAttribute) 
+    {
+        if (token_.GetType() == TokenType::kConst) {
+            const_token = token_;
+            is_const = true;
+            Advance();
+            continue;
+        }
+        if (!spec) {
+            GetDiagEngine().Report(llvm::SMLoc::getFromPointer(token_.GetRawContentPtr()), 
+                                   Diag::kErrInvalidSpecifier,
+                                   token_.GetContent());
+        }
+        if (token_.GetType() == TokenType::kAttribute) {
+            ParseAttributes(spec->attrs);
+            continue;
+        }
+        if (token_.GetType() == TokenType::kStatic) {
+            spec->storage_class = StorageClass::kStatic;
+        } else {
+            spec->is_inline = true;
+            spec->inline_token = token_;
+        }
+        Advance();
+    }
+
+    std::shared_ptr<CType> base_type = nullptr;
     switch (token_.GetType()) {
         case TokenType::kVoid: {
             Advance();
-            return CType::kVoidType;
+            base_type = CType::kVoidType;
+            break;
         }
         case TokenType::kInt: {
             Advance();
-            return CType::kIntType;
+            base_type = CType::kIntType;
+            break;
         }
         case TokenType::kStruct:
         case TokenType::kUnion: {
-            return ParseStructOrUnionSpec();
+            base_type = ParseStructOrUnionSpec();
+            break;
         }
         default: {
             GetDiagEngine().Report(llvm::SMLoc::getFromPointer(token_.GetRawContentPtr()), 
                                    Diag::kErrType);
         }
     }
+
+    while (token_.GetType() == TokenType::kConst || 
+           token_.GetType() == TokenType::kRestrict) 
+    {
+        // NOTE: The base type is never a pointer, so `int restrict` is rejected here.
+        if (token_.GetType() == TokenType::kRestrict) {
+            base_type = sema_.SemaRestrictType(base_type, token_);
+            Advance();
+            continue;
+        }
+        const_token = token_;
+        is_const = true;
+        Advance();
+    }
+    if (is_const) {
+        base_type = sema_.SemaConstType(base_type, const_token);
+    }
     
-    return nullptr;
+    return base_type;
 }
 
 std::shared_ptr<CType> Parser::ParseStructOrUnionSpec() {
@@ -198,10 +295,10 @@ std::shared_ptr<CType> Parser::ParseStructOrUnionSpec() {
         sema_.EnterScope();
         {
             while (token_.GetType() != TokenType::kRBrace) {
-                auto decl_stmt = ParseDeclStmt(false);
-                auto raw_decl_stmt = llvm::dyn_cast<DeclStmt>(decl_stmt.get());
+                auto decl_stmt = ParseDeclStmt(false, true);
+                auto raw_decl_stmt = llvm::dyn_cast<DeclStmt>(decl_stmt);
                 for (const auto& decl_node : raw_decl_stmt->nodes_) {
-                    auto raw_decl_node = llvm::dyn_cast<VariableDecl>(decl_node.get());
+                    auto raw_decl_node = llvm::dyn_cast<VariableDecl>(decl_node);
                     members.emplace_back(raw_decl_node->GetCType(), raw_decl_node->GetVariableName());
                 }
             }
@@ -227,21 +324,82 @@ std::shared_ptr<CType> Parser::ParseStructOrUnionSpec() {
     return nullptr;
 }
 
-std::shared_ptr<AstNode> Parser::ParseDeclarator(std::shared_ptr<CType> base_type, bool is_global) {
+AstNode* Parser::ParseDeclarator(std::shared_ptr<CType> base_type, bool is_global) {
     // Process pointer variable.
     // For example:
     //     1. `int** ptr = &something` => `int**`
     //     2. `int* ar[10];` => `int*`
     while (token_.GetType() == TokenType::kStar) {
         Consume(TokenType::kStar);
-        base_type = std::make_shared<CPointerType>(base_type);
+        base_type = ParsePointerQualifiers(sema_.GetTypeContext().GetPointerType(base_type));
     }
 
     return ParseDirectDeclarator(base_type, is_global);
 }
 
-std::shared_ptr<AstNode> Parser::ParseDirectDeclarator(std::shared_ptr<CType> base_type, bool is_global) {
-    std::shared_ptr<AstNode> variable_decl_node = nullptr;
+// NOTE:
+// The arguments of an attribute, e.g. `aligned(16)`, are skipped,
+// since none of the supported attributes has any.
+void Parser::ParseAttributes(llvm::SmallVectorImpl<Token>& attrs) {
+    while (token_.GetType() == TokenType::kAttribute) {
+        Consume(TokenType::kAttribute);
+        Consume(TokenType::kLParent);
+        Consume(TokenType::kLParent);
+        while (token_.GetType() != TokenType::kRParent) {
+            // An empty attribute is allowed, e.g. `__attribute__((, cold))`.
+            if (token_.GetType() == TokenType::kComma) {
+                Advance();
+                continue;
+            }
+            // `const` is a keyword, but also the name of an attribute.
+            if (token_.GetType() != TokenType::kConst) {
+                Expect(TokenType::kIdentifier);
+            }
+            attrs.push_back(token_);
+            Advance();
+
+            if (token_.GetType() == TokenType::kLParent) {
+                int depth = 0;
+                do {
+                    if (token_.GetType() == TokenType::kLParent) {
+                        ++depth;
+                    } else if (token_.GetType() == TokenType::kRParent) {
+                        --depth;
+                    } else if (token_.GetType() == TokenType::kEOF) {
+                        Expect(TokenType::kRParent);
+                    }
+                    Advance();
+                } while (depth > 0);
+            }
+            if (token_.GetType() != TokenType::kRParent) {
+                Consume(TokenType::kComma);
+            }
+        }
+        Consume(TokenType::kRParent);
+        Consume(TokenType::kRParent);
+    }
+}
+
+// NOTE:
+// The qualifiers after `*` belong to the pointer itself, e.g. `int* const p`
+// is a const pointer, and `int* restrict p` is the only way to access the
+// object it points to.
+std::shared_ptr<CType> Parser::ParsePointerQualifiers(std::shared_ptr<CType> pointer_type) {
+    while (token_.GetType() == TokenType::kConst || 
+           token_.GetType() == TokenType::kRestrict) 
+    {
+        if (token_.GetType() == TokenType::kConst) {
+            pointer_type = sema_.SemaConstType(pointer_type, token_);
+        } else {
+            pointer_type = sema_.SemaRestrictType(pointer_type, token_);
+        }
+        Advance();
+    }
+    return pointer_type;
+}
+
+AstNode* Parser::ParseDirectDeclarator(std::shared_ptr<CType> base_type, bool is_global) {
+    AstNode* variable_decl_node = nullptr;
     
     // 1. Create the declarator node.
     switch (token_.GetType()) {
@@ -267,7 +425,7 @@ std::shared_ptr<AstNode> Parser::ParseDirectDeclarator(std::shared_ptr<CType> ba
                 // In this time while calling `ParseDeclarator`, 
                 // we don't care about what you filled in the parentheses.
                 // So, we just pass a dummy argument here.
-                auto tmp_variable_decl_node = ParseDeclarator(CType::kIntType, is_global);
+                ParseDeclarator(CType::kIntType, is_global);
                 Consume(TokenType::kRParent);
                 // However, we are interested in what you wrote after the right parenthesis.
                 base_type = ParseDirectDeclaratorSuffix(dummy, base_type, is_global);
@@ -301,7 +459,7 @@ std::shared_ptr<AstNode> Parser::ParseDirectDeclarator(std::shared_ptr<CType> ba
     // 2. Create tne initializer node.
     if (token_.GetType() == TokenType::kEqual) {
         Advance();
-        VariableDecl* raw_decl_node = llvm::dyn_cast<VariableDecl>(variable_decl_node.get());
+        VariableDecl* raw_decl_node = llvm::dyn_cast<VariableDecl>(variable_decl_node);
         // NOTE: Why we have to add a zero in each `index_list`?
         // That's because when generating LLVM IR for initialize the member of an array, struct or union, 
         // we have to complete a dereference operation at first, which is the meaning of this zero.
@@ -309,7 +467,9 @@ std::shared_ptr<AstNode> Parser::ParseDirectDeclarator(std::shared_ptr<CType> ba
         // we have to deref this pointer(`*p`) at first,
         // before we try to write or read an element from the array(`(*p)[idx]`).
         std::vector<int> index_list = { 0 };
-        ParseInitializer(raw_decl_node->init_values_, raw_decl_node->GetCType(), index_list, false);
+        llvm::SmallVector<VariableDecl::InitValue*> init_values;
+        ParseInitializer(init_values, raw_decl_node->GetCType(), index_list, false);
+        raw_decl_node->init_values_ = program_->CopyArray<VariableDecl::InitValue*>(init_values);
     }
 
     return variable_decl_node;
@@ -346,18 +506,51 @@ std::shared_ptr<CType> Parser::ParseDirectDeclaratorArraySuffix(
         return element_type;
     }
 
+    // Take the spec of the parameter, the size of this array might have
+    // another declarator in it, e.g. `int a[sizeof(int[2])]`.
+    auto param_spec = array_param_spec_;
+    array_param_spec_ = nullptr;
+
     int array_element_cnt = -1;
     Consume(TokenType::kLBracket);
     {
+        // e.g. `int a[static const 3]` in the parameters.
+        while (token_.GetType() == TokenType::kStatic || 
+               token_.GetType() == TokenType::kConst || 
+               token_.GetType() == TokenType::kRestrict) 
+        {
+            if (!param_spec) {
+                GetDiagEngine().Report(llvm::SMLoc::getFromPointer(token_.GetRawContentPtr()), 
+                                       Diag::kErrArrayParamQualifier,
+                                       token_.GetContent());
+            }
+            switch (token_.GetType()) {
+                case TokenType::kStatic:
+                    param_spec->is_static = true;
+                    break;
+                case TokenType::kConst:
+                    param_spec->is_const = true;
+                    break;
+                default:
+                    param_spec->is_restrict = true;
+                    break;
+            }
+            Advance();
+        }
+        if (param_spec && param_spec->is_static && token_.GetType() == TokenType::kRBracket) {
+            GetDiagEngine().Report(llvm::SMLoc::getFromPointer(token_.GetRawContentPtr()), 
+                                   Diag::kErrArrayParamStatic);
+        }
         if (token_.GetType() != TokenType::kRBracket) {
-            array_element_cnt = token_.GetValue();
-            Consume(TokenType::kNumber);
+            auto size_token = token_;
+            auto size_node = ParseConditionalExpr();
+            array_element_cnt = sema_.SemaArraySize(size_node, size_token);
         }
     }
     Consume(TokenType::kRBracket);
 
     auto sub_array_type = ParseDirectDeclaratorArraySuffix(element_type, is_global);
-    return std::make_shared<CArrayType>(sub_array_type, array_element_cnt);
+    return sema_.GetTypeContext().GetArrayType(sub_array_type, array_element_cnt);
 }
 
 std::shared_ptr<CType> Parser::ParseDirectDeclaratorFuncSuffix(
@@ -369,6 +562,7 @@ std::shared_ptr<CType> Parser::ParseDirectDeclaratorFuncSuffix(
 
     int i = 0;
     std::vector<CFuncType::Param> params;
+    llvm::SmallVector<AstNode*> param_nodes;
     while (token_.GetType() != TokenType::kRParent) {
         if (0 < i && token_.GetType() == TokenType::kComma) {
             Consume(TokenType::kComma);
@@ -376,26 +570,42 @@ std::shared_ptr<CType> Parser::ParseDirectDeclaratorFuncSuffix(
         ++i;
 
         auto param_base_type = ParseDeclSpec();
+        ArrayParamSpec array_param_spec;
+        auto outer_array_param_spec = array_param_spec_;
+        array_param_spec_ = &array_param_spec;
         auto param_decl_node = ParseDeclarator(param_base_type, false);
-        auto param_final_type = param_decl_node->GetCType();
+        array_param_spec_ = outer_array_param_spec;
 
-        if (param_final_type->GetKind() == CType::TypeKind::kArray) {
-            auto array_type = llvm::dyn_cast<CArrayType>(param_final_type.get());
-            auto pointer_type = std::make_shared<CPointerType>(array_type->GetElementType());
-            param_decl_node->SetCType(pointer_type);
+        if (param_decl_node->GetCType()->GetKind() == CType::TypeKind::kArray) {
+            sema_.SemaArrayParamDecay(param_decl_node, 
+                                      array_param_spec.is_static,
+                                      array_param_spec.is_const,
+                                      array_param_spec.is_restrict);
         }
 
         params.emplace_back(param_decl_node->GetCType(), 
                             param_decl_node->GetBoundToken().GetContent());
+        param_nodes.push_back(param_decl_node);
     }
 
     Consume(TokenType::kRParent);
 
-    return std::make_shared<CFuncType>(iden.GetContent(), ret_type, std::move(params));
+    // e.g. `void f() __attribute__((noreturn));`
+    llvm::SmallVector<Token> attrs;
+    ParseAttributes(attrs);
+
+    // NOTE:
+    // Save them after parsing the whole parameter list, since a parameter
+    // itself might be declared with a function declarator.
+    func_param_nodes_ = std::move(param_nodes);
+
+    auto func_type = sema_.GetTypeContext().GetFuncType(iden.GetContent(), ret_type, std::move(params));
+    sema_.SemaFuncAttrs(func_type, attrs);
+    return func_type;
 }
 
 bool Parser::ParseInitializer(
-    std::vector<std::shared_ptr<VariableDecl::InitValue>> &init_values, 
+    llvm::SmallVectorImpl<VariableDecl::InitValue*> &init_values, 
     std::shared_ptr<CType> decl_type, 
     std::vector<int> &index_list,
     bool has_lbrace)
@@ -497,42 +707,47 @@ bool Parser::ParseInitializer(
     return false;
 }
 
-std::shared_ptr<AstNode> Parser::ParseReturnStmt() {
+AstNode* Parser::ParseReturnStmt() {
+    Token ret_token = token_;
     Consume(TokenType::kReturn);
 
-    std::shared_ptr<AstNode> ret_value_expr = nullptr;
+    AstNode* ret_value_expr = nullptr;
     if (token_.GetType() != TokenType::kSemi) {
         ret_value_expr = ParseExpr();
         Consume(TokenType::kSemi);        
     }
 
-    auto ret_stmt_node = std::make_shared<ReturnStmt>();
-    ret_stmt_node->value_node_ = ret_value_expr;
-
-    return ret_stmt_node;
+    return sema_.SemaReturnStmt(ret_value_expr, ret_token);
 }
 
-std::shared_ptr<AstNode> Parser::ParseDeclStmt(bool is_global) {
+AstNode* Parser::ParseDeclStmt(bool is_global, bool is_member) {
     // Extract the BASE TYPE of variable declared.
     // For example:
     //     1. `int x, y, z;` => `int`
     //     2. `int** p;` => `int`
     //     3. `int ar[1][2][3];` => `int`
-    std::shared_ptr<CType> variable_base_type = ParseDeclSpec();
+    // The members of a struct or union have no storage class.
+    DeclSpec spec;
+    std::shared_ptr<CType> variable_base_type = ParseDeclSpec(is_member ? nullptr : &spec);
 
     if (token_.GetType() == TokenType::kSemi) {
         Consume(TokenType::kSemi);
         return nullptr;
     }
 
-    auto decl_stmt = std::make_shared<DeclStmt>();
+    auto decl_stmt = program_->Create<DeclStmt>();
 
+    llvm::SmallVector<AstNode*> nodes;
     while (token_.GetType() != TokenType::kSemi) {
-        decl_stmt->nodes_.emplace_back(ParseDeclarator(variable_base_type, is_global));
+        auto decl_node = ParseDeclarator(variable_base_type, is_global);
+        sema_.SemaVariableDeclSpec(decl_node, spec.storage_class, spec.is_inline, spec.inline_token);
+        sema_.SemaFuncAttrs(decl_node->GetCType(), spec.attrs);
+        nodes.emplace_back(decl_node);
         if (token_.GetType() == TokenType::kComma) {
             Advance();
         }
     }
+    decl_stmt->nodes_ = program_->CopyArray<AstNode*>(nodes);
 
     // Don't forget me!
     Consume(TokenType::kSemi);
@@ -540,7 +755,7 @@ std::shared_ptr<AstNode> Parser::ParseDeclStmt(bool is_global) {
     return decl_stmt;
 }
 
-std::shared_ptr<AstNode> Parser::ParseIfStmt() {
+AstNode* Parser::ParseIfStmt() {
     Consume(TokenType::kIf);
 
     Consume(TokenType::kLParent);
@@ -549,7 +764,7 @@ std::shared_ptr<AstNode> Parser::ParseIfStmt() {
 
     auto then_stmt = ParseStmt();
 
-    std::shared_ptr<AstNode> else_stmt = nullptr;
+    AstNode* else_stmt = nullptr;
     if (token_.GetType() == TokenType::kElse) {
         Consume(TokenType::kElse);
         else_stmt = ParseStmt();
@@ -558,18 +773,20 @@ std::shared_ptr<AstNode> Parser::ParseIfStmt() {
     return sema_.SemaIfStmtNode(cond_expr, then_stmt, else_stmt);
 }
 
-std::shared_ptr<AstNode> Parser::ParseBlockStmt() {
-    auto block_stmt = std::make_shared<BlockStmt>();
+AstNode* Parser::ParseBlockStmt() {
+    auto block_stmt = program_->Create<BlockStmt>();
 
     Consume(TokenType::kLBrace);
     sema_.EnterScope();
     
+    llvm::SmallVector<AstNode*> nodes;
     while (token_.GetType() != TokenType::kRBrace) {
         auto stmt = ParseStmt();
         if (stmt != nullptr) {
-            block_stmt->nodes_.emplace_back(stmt);
+            nodes.emplace_back(stmt);
         }
     }
+    block_stmt->nodes_ = program_->CopyArray<AstNode*>(nodes);
     
     sema_.ExitScope();
     Consume(TokenType::kRBrace);
@@ -577,7 +794,7 @@ std::shared_ptr<AstNode> Parser::ParseBlockStmt() {
     return block_stmt;
 }
 
-std::shared_ptr<AstNode> Parser::ParseForStmt() {
+AstNode* Parser::ParseForStmt() {
     Consume(TokenType::kFor);
     Consume(TokenType::kLParent);
 
@@ -585,16 +802,16 @@ std::shared_ptr<AstNode> Parser::ParseForStmt() {
     sema_.EnterScope();
 
     // Create forstmt node.
-    auto for_stmt_node = std::make_shared<ForStmt>();
+    auto for_stmt_node = program_->Create<ForStmt>();
     // Record loop statement node, 
     // so that it can be breaked or continued by code in its body.
     AddBreakedAbleNode(for_stmt_node);
     AddContinuedAbleNode(for_stmt_node);
 
-    std::shared_ptr<AstNode> init_node = nullptr;
-    std::shared_ptr<AstNode> cond_node = nullptr;
-    std::shared_ptr<AstNode> inc_node = nullptr;
-    std::shared_ptr<AstNode> body_node = nullptr;
+    AstNode* init_node = nullptr;
+    AstNode* cond_node = nullptr;
+    AstNode* inc_node = nullptr;
+    AstNode* body_node = nullptr;
 
     // Build all the sub nodes of forstmt node.
     if (IsTypeName(token_)) {
@@ -627,33 +844,119 @@ std::shared_ptr<AstNode> Parser::ParseForStmt() {
     return for_stmt_node;
 }
 
-std::shared_ptr<AstNode> Parser::ParseBreakStmt() {
+AstNode* Parser::ParseBreakStmt() {
     if (breaked_able_nodes_.empty()) {
         GetDiagEngine().Report(llvm::SMLoc::getFromPointer(token_.GetRawContentPtr()),
                                Diag::kErrBreakStmt);
     }
 
     Consume(TokenType::kBreak);
-    auto node = std::make_shared<BreakStmt>();
+    auto node = program_->Create<BreakStmt>();
     node->target_ = breaked_able_nodes_.back();
     Consume(TokenType::kSemi);
     return node;
 }
 
-std::shared_ptr<AstNode> Parser::ParseContinueStmt() {
+AstNode* Parser::ParseContinueStmt() {
     if (continued_able_nodes_.empty()) {
         GetDiagEngine().Report(llvm::SMLoc::getFromPointer(token_.GetRawContentPtr()),
                                Diag::kErrContinueStmt);
     }
 
     Consume(TokenType::kContinue);
-    auto node = std::make_shared<ContinueStmt>();
+    auto node = program_->Create<ContinueStmt>();
     node->target_ = continued_able_nodes_.back();
     Consume(TokenType::kSemi);
     return node;
 }
 
-std::shared_ptr<AstNode> Parser::ParseExprStmt() {
+AstNode* Parser::ParseSwitchStmt() {
+    auto switch_token = token_;
+    Consume(TokenType::kSwitch);
+
+    Consume(TokenType::kLParent);
+    auto cond_node = ParseExpr();
+    Consume(TokenType::kRParent);
+
+    // Record switch statement node, so that it can be breaked
+    // and the labels in its body can be attached to it.
+    auto switch_node = program_->Create<SwitchStmt>();
+    AddBreakedAbleNode(switch_node);
+    switch_contexts_.push_back({ switch_node, {} });
+
+    auto body_node = ParseStmt();
+
+    auto case_nodes = std::move(switch_contexts_.back().case_nodes);
+    switch_contexts_.pop_back();
+    RemoveBreakedAbleNode(switch_node);
+
+    return sema_.SemaSwitchStmtNode(switch_node, cond_node, body_node, case_nodes, switch_token);
+}
+
+AstNode* Parser::ParseCaseStmt() {
+    auto case_token = token_;
+    if (switch_contexts_.empty()) {
+        GetDiagEngine().Report(llvm::SMLoc::getFromPointer(token_.GetRawContentPtr()),
+                               Diag::kErrCaseStmt,
+                               case_token.GetContent());
+    }
+
+    AstNode* value_node = nullptr;
+    if (token_.GetType() == TokenType::kCase) {
+        Consume(TokenType::kCase);
+        value_node = ParseConditionalExpr();
+    } else {
+        Consume(TokenType::kDefault);
+    }
+    Consume(TokenType::kColon);
+
+    auto node = sema_.SemaCaseStmtNode(value_node, case_token);
+    node->target_ = switch_contexts_.back().switch_node;
+    switch_contexts_.back().case_nodes.push_back(node);
+
+    // NOTE: A label may be the last one in a block, e.g. `default: }`.
+    if (token_.GetType() != TokenType::kRBrace) {
+        node->sub_stmt_ = ParseStmt();
+    }
+
+    return node;
+}
+
+AstNode* Parser::ParseLabelStmt() {
+    auto label_token = token_;
+    Consume(TokenType::kIdentifier);
+    Consume(TokenType::kColon);
+
+    auto node = sema_.SemaLabelStmtNode(label_token);
+
+    // NOTE: A label may be the last one in a block, e.g. `out: }`.
+    if (token_.GetType() != TokenType::kRBrace) {
+        node->sub_stmt_ = ParseStmt();
+    }
+
+    return node;
+}
+
+AstNode* Parser::ParseGotoStmt() {
+    Consume(TokenType::kGoto);
+
+    // `goto *expr`
+    if (token_.GetType() == TokenType::kStar) {
+        auto star_token = token_;
+        Consume(TokenType::kStar);
+        auto target_node = ParseExpr();
+        Consume(TokenType::kSemi);
+        return sema_.SemaIndirectGotoStmtNode(target_node, star_token);
+    }
+
+    // `goto label`
+    auto label_token = token_;
+    Consume(TokenType::kIdentifier);
+    Consume(TokenType::kSemi);
+    return sema_.SemaGotoStmtNode(label_token);
+}
+
+AstNode* Parser::ParseExprStmt() {
     if (token_.GetType() == TokenType::kSemi) {
         Advance();
         return nullptr;
@@ -664,7 +967,7 @@ std::shared_ptr<AstNode> Parser::ParseExprStmt() {
     return expr;
 }
 
-std::shared_ptr<AstNode> Parser::ParseExpr() {
+AstNode* Parser::ParseExpr() {
     auto left = ParseAssignExpr();
     while (token_.GetType() == TokenType::kComma) {
         Consume(TokenType::kComma);
@@ -674,12 +977,13 @@ std::shared_ptr<AstNode> Parser::ParseExpr() {
     return left;
 }
 
-std::shared_ptr<AstNode> Parser::ParseAssignExpr() {
+AstNode* Parser::ParseAssignExpr() {
     auto left = ParseConditionalExpr();
     if (!CurrentTokenIsAssignOperator()) {
         return left;
     }
 
+    Token op_token = token_;
     BinaryOpCode op;
     switch (token_.GetType()) {
         case TokenType::kEqual:
@@ -719,11 +1023,11 @@ std::shared_ptr<AstNode> Parser::ParseAssignExpr() {
     Advance();
 
     auto right = ParseAssignExpr();
-    return sema_.SemaBinaryExprNode(left, right, op);
+    return sema_.SemaAssignExprNode(left, right, op, op_token);
 }
 
 // Process something like `a ? b : c`
-std::shared_ptr<AstNode> Parser::ParseConditionalExpr() {
+AstNode* Parser::ParseConditionalExpr() {
     auto cond_node = ParseLogOrExpr();
     if (token_.GetType() != TokenType::kQuestion) {
         return cond_node;
@@ -739,7 +1043,7 @@ std::shared_ptr<AstNode> Parser::ParseConditionalExpr() {
 }
 
 // Process "==" or "!=" expression.
-std::shared_ptr<AstNode> Parser::ParseEqualExpr() {
+AstNode* Parser::ParseEqualExpr() {
     auto left_expr = ParseRelationalExpr();
     while (token_.GetType() == TokenType::kEqualEqual 
            || token_.GetType() == TokenType::kNotEqual) {
@@ -760,7 +1064,7 @@ std::shared_ptr<AstNode> Parser::ParseEqualExpr() {
 }
 
 // Process "<", ">", "<=" or ">=" expression.
-std::shared_ptr<AstNode> Parser::ParseRelationalExpr() {
+AstNode* Parser::ParseRelationalExpr() {
     auto left_expr = ParseBitShiftExpr();
 
 #define TOKEN_TYPE_IS(type) (token_.GetType() == type)
@@ -800,7 +1104,7 @@ std::shared_ptr<AstNode> Parser::ParseRelationalExpr() {
 }
 
 // Process "+" or "-" expression.
-std::shared_ptr<AstNode> Parser::ParseAddExpr() {
+AstNode* Parser::ParseAddExpr() {
     auto left_expr = ParseMultiExpr();
     while (token_.GetType() == TokenType::kPlus 
            || token_.GetType() == TokenType::kMinus) {
@@ -821,7 +1125,7 @@ std::shared_ptr<AstNode> Parser::ParseAddExpr() {
 }
 
 // Process "*" or "/" expression.
-std::shared_ptr<AstNode> Parser::ParseMultiExpr() {
+AstNode* Parser::ParseMultiExpr() {
     auto left_expr = ParseUnaryExpr();
     while (token_.GetType() == TokenType::kStar 
            || token_.GetType() == TokenType::kSlash
@@ -848,7 +1152,7 @@ std::shared_ptr<AstNode> Parser::ParseMultiExpr() {
     return left_expr;
 }
 
-std::shared_ptr<AstNode> Parser::ParseUnaryExpr() {
+AstNode* Parser::ParseUnaryExpr() {
     if (!CurrentTokenIsUnaryOperator()) {
         return ParsePostFixExpr();
     }
@@ -869,7 +1173,6 @@ std::shared_ptr<AstNode> Parser::ParseUnaryExpr() {
             lexer_.RestoreState();
         }
 
-        auto node = std::make_shared<SizeofExpr>();
         if (is_type_name) {
             Consume(TokenType::kLParent);
             auto ctype = ParseTypeName();
@@ -878,8 +1181,14 @@ std::shared_ptr<AstNode> Parser::ParseUnaryExpr() {
         } else {
             return sema_.SemaSizeofExprNode(ParseUnaryExpr(), nullptr);
         }
+    }
 
-        return node;
+    // `&&label`
+    if (token_.GetType() == TokenType::kAmpAmp) {
+        Consume(TokenType::kAmpAmp);
+        auto label_token = token_;
+        Consume(TokenType::kIdentifier);
+        return sema_.SemaAddrLabelExprNode(label_token);
     }
 
     UnaryOpCode op;
@@ -923,7 +1232,7 @@ std::shared_ptr<AstNode> Parser::ParseUnaryExpr() {
     return sema_.SemaUnaryExprNode(sub_node, op, tmp);
 }
 
-std::shared_ptr<AstNode> Parser::ParsePostFixExpr() {
+AstNode* Parser::ParsePostFixExpr() {
     auto left = ParsePrimaryExpr();
     while (true) {
         Token tmp = token_;
@@ -966,7 +1275,7 @@ std::shared_ptr<AstNode> Parser::ParsePostFixExpr() {
                 Consume(TokenType::kLParent);
 
                 int i = 0;
-                std::vector<std::shared_ptr<AstNode>> arg_nodes;
+                llvm::SmallVector<AstNode*> arg_nodes;
                 while (token_.GetType() != TokenType::kRParent) {
                     if (0 < i && token_.GetType() == TokenType::kComma) {
                         Consume(TokenType::kComma);
@@ -988,7 +1297,7 @@ std::shared_ptr<AstNode> Parser::ParsePostFixExpr() {
     return left;
 }
 
-std::shared_ptr<AstNode> Parser::ParseLogOrExpr() {
+AstNode* Parser::ParseLogOrExpr() {
     auto left_expr = ParseLogAndExpr();
     while (token_.GetType() == TokenType::kPipePipe)  {
         Advance();
@@ -999,7 +1308,7 @@ std::shared_ptr<AstNode> Parser::ParseLogOrExpr() {
     return left_expr;
 }
 
-std::shared_ptr<AstNode> Parser::ParseLogAndExpr() {
+AstNode* Parser::ParseLogAndExpr() {
     auto left_expr = ParseBitOrExpr();
     while (token_.GetType() == TokenType::kAmpAmp)  {
         Advance();
@@ -1012,7 +1321,7 @@ std::shared_ptr<AstNode> Parser::ParseLogAndExpr() {
     return left_expr;
 }
 
-std::shared_ptr<AstNode> Parser::ParseBitOrExpr() {
+AstNode* Parser::ParseBitOrExpr() {
     auto left_expr = ParseBitXorExpr();
     while (token_.GetType() == TokenType::kPipe)  {
         Advance();
@@ -1025,7 +1334,7 @@ std::shared_ptr<AstNode> Parser::ParseBitOrExpr() {
     return left_expr;
 }
 
-std::shared_ptr<AstNode> Parser::ParseBitXorExpr() {
+AstNode* Parser::ParseBitXorExpr() {
     auto left_expr = ParseBitAndExpr();
     while (token_.GetType() == TokenType::kCaret)  {
         Advance();
@@ -1038,7 +1347,7 @@ std::shared_ptr<AstNode> Parser::ParseBitXorExpr() {
     return left_expr;
 }
 
-std::shared_ptr<AstNode> Parser::ParseBitAndExpr() {
+AstNode* Parser::ParseBitAndExpr() {
     auto left_expr = ParseEqualExpr();
     while (token_.GetType() == TokenType::kAmp)  {
         Advance();
@@ -1051,7 +1360,7 @@ std::shared_ptr<AstNode> Parser::ParseBitAndExpr() {
     return left_expr;
 }
 
-std::shared_ptr<AstNode> Parser::ParseBitShiftExpr() {
+AstNode* Parser::ParseBitShiftExpr() {
     auto left_expr = ParseAddExpr();
     while (token_.GetType() == TokenType::kLessLess 
            || token_.GetType() == TokenType::kGreaterGreater) 
@@ -1076,7 +1385,7 @@ std::shared_ptr<AstNode> Parser::ParseBitShiftExpr() {
     return left_expr;
 }
 
-std::shared_ptr<AstNode> Parser::ParsePrimaryExpr() {
+AstNode* Parser::ParsePrimaryExpr() {
     if (token_.GetType() == TokenType::kLParent) {
         Consume(TokenType::kLParent);
         auto sub_expr = ParseExpr();
@@ -1108,8 +1417,9 @@ std::shared_ptr<CType> Parser::ParseTypeName() {
     
     // Process pointer typename
     while (token_.GetType() == TokenType::kStar) {
-        base_type = std::make_shared<CPointerType>(base_type);
+        base_type = sema_.GetTypeContext().GetPointerType(base_type);
         Consume(TokenType::kStar);
+        base_type = ParsePointerQualifiers(base_type);
     }
 
     Token dummy = token_;
@@ -1165,5 +1475,6 @@ bool Parser::CurrentTokenIsUnaryOperator() const {
             token_.GetType() == TokenType::kMinus ||
             token_.GetType() == TokenType::kTilde ||
             token_.GetType() == TokenType::kNot ||
-            token_.GetType() == TokenType::kSizeof);
+            token_.GetType() == TokenType::kSizeof ||
+            token_.GetType() == TokenType::kAmpAmp);
 }
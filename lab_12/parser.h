@@ -8,6 +8,8 @@
 #include <memory>
 #include <vector>
 
+#include "llvm/ADT/SmallVector.h"
+
 #include "lexer.h"
 #include "ast.h"
 #include "sema.h"
@@ -18,23 +20,58 @@ class Parser {
     Sema& sema_;
     Token token_ {};
 
-    std::vector<std::shared_ptr<AstNode>> breaked_able_nodes_;
-    std::vector<std::shared_ptr<AstNode>> continued_able_nodes_;
-
-    void AddBreakedAbleNode(std::shared_ptr<AstNode> node) {
+    // The program which owns the AST nodes created by us.
+    Program* program_ { nullptr };
+
+    // The parameter declarations of the last function declarator,
+    // which will be saved in the `FuncDecl` node.
+    llvm::SmallVector<AstNode*> func_param_nodes_;
+
+    std::vector<AstNode*> breaked_able_nodes_;
+    std::vector<AstNode*> continued_able_nodes_;
+
+    // The enclosing switch statements, and the `case` and `default` labels
+    // collected for each of them so far.
+    struct SwitchContext {
+        SwitchStmt* switch_node;
+        llvm::SmallVector<AstNode*> case_nodes;
+    };
+    std::vector<SwitchContext> switch_contexts_;
+
+    // The specifiers before the base type of a declaration.
+    struct DeclSpec {
+        StorageClass storage_class { StorageClass::kNone };
+        bool is_inline { false };
+        Token inline_token {};
+        // The names in `__attribute__((...))`.
+        llvm::SmallVector<Token> attrs;
+    };
+
+    // The `static` and qualifiers in the outermost `[]` of an array parameter,
+    // e.g. `int a[static restrict 3]`, which apply to the pointer it decays to.
+    struct ArrayParamSpec {
+        bool is_static { false };
+        bool is_const { false };
+        bool is_restrict { false };
+    };
+    // Set while parsing the declarator of a parameter, and taken by the first
+    // array suffix in it, so that the inner ones can't have the qualifiers.
+    ArrayParamSpec* array_param_spec_ { nullptr };
+
+    void AddBreakedAbleNode(AstNode* node) {
         breaked_able_nodes_.emplace_back(node);
     }
 
-    void AddContinuedAbleNode(std::shared_ptr<AstNode> node) {
+    void AddContinuedAbleNode(AstNode* node) {
         continued_able_nodes_.emplace_back(node);
     }
 
-    void RemoveBreakedAbleNode(std::shared_ptr<AstNode> node) {
+    void RemoveBreakedAbleNode(AstNode* node) {
         assert(!breaked_able_nodes_.empty() && breaked_able_nodes_.back() == node);
         breaked_able_nodes_.pop_back();
     }
 
-    void RemoveContinuedAbleNode(std::shared_ptr<AstNode> node) {
+    void RemoveContinuedAbleNode(AstNode* node) {
         assert(!continued_able_nodes_.empty() && continued_able_nodes_.back() == node);
         continued_able_nodes_.pop_back();
     }
@@ -46,18 +83,25 @@ class Parser {
 
  private:
     bool IsFuncDecl();
-    std::shared_ptr<AstNode> ParseFuncDecl();
+    // Is the current token an identifier followed by `:`?
+    bool IsLabel();
+    AstNode* ParseFuncDecl();
 
-    std::shared_ptr<AstNode> ParseStmt();
-    std::shared_ptr<AstNode> ParseBlockStmt();
-    std::shared_ptr<AstNode> ParseReturnStmt();
+    AstNode* ParseStmt();
+    AstNode* ParseBlockStmt();
+    AstNode* ParseReturnStmt();
     
-    std::shared_ptr<AstNode> ParseDeclStmt(bool is_global);
-    std::shared_ptr<CType> ParseDeclSpec();
+    AstNode* ParseDeclStmt(bool is_global, bool is_member = false);
+    // The storage class and `inline` are only allowed if `spec` is given.
+    std::shared_ptr<CType> ParseDeclSpec(DeclSpec* spec = nullptr);
     std::shared_ptr<CType> ParseStructOrUnionSpec();
 
-    std::shared_ptr<AstNode> ParseDeclarator(std::shared_ptr<CType>, bool is_global);
-    std::shared_ptr<AstNode> ParseDirectDeclarator(std::shared_ptr<CType>, bool is_global);
+    AstNode* ParseDeclarator(std::shared_ptr<CType>, bool is_global);
+    // Parse `__attribute__((a, b))`s, and collect the tokens of the names.
+    void ParseAttributes(llvm::SmallVectorImpl<Token>& attrs);
+    // Parse the qualifiers after `*`, e.g. `int* const restrict p`.
+    std::shared_ptr<CType> ParsePointerQualifiers(std::shared_ptr<CType> pointer_type);
+    AstNode* ParseDirectDeclarator(std::shared_ptr<CType>, bool is_global);
 
     std::shared_ptr<CType> ParseDirectDeclaratorSuffix(const Token& identifier, 
                                                        std::shared_ptr<CType>, 
@@ -68,40 +112,44 @@ class Parser {
                                                            std::shared_ptr<CType>, 
                                                            bool is_global);
 
-    bool ParseInitializer(std::vector<std::shared_ptr<VariableDecl::InitValue>>& init_values,
+    bool ParseInitializer(llvm::SmallVectorImpl<VariableDecl::InitValue*>& init_values,
                           std::shared_ptr<CType> decl_type,
                           std::vector<int>& index_list,
                           bool has_lbrace);
 
-    std::shared_ptr<AstNode> ParseExprStmt();
-    std::shared_ptr<AstNode> ParseIfStmt();
-    std::shared_ptr<AstNode> ParseForStmt();
-    std::shared_ptr<AstNode> ParseBreakStmt();
-    std::shared_ptr<AstNode> ParseContinueStmt();
-
-    std::shared_ptr<AstNode> ParseExpr();
-    std::shared_ptr<AstNode> ParseAssignExpr();
-    std::shared_ptr<AstNode> ParseConditionalExpr();
-    std::shared_ptr<AstNode> ParseEqualExpr();
-    std::shared_ptr<AstNode> ParseRelationalExpr();
-
-    std::shared_ptr<AstNode> ParseAddExpr();
+    AstNode* ParseExprStmt();
+    AstNode* ParseIfStmt();
+    AstNode* ParseForStmt();
+    AstNode* ParseBreakStmt();
+    AstNode* ParseContinueStmt();
+    AstNode* ParseSwitchStmt();
+    AstNode* ParseCaseStmt();
+    AstNode* ParseLabelStmt();
+    AstNode* ParseGotoStmt();
+
+    AstNode* ParseExpr();
+    AstNode* ParseAssignExpr();
+    AstNode* ParseConditionalExpr();
+    AstNode* ParseEqualExpr();
+    AstNode* ParseRelationalExpr();
+
+    AstNode* ParseAddExpr();
     // Including `*`, `/`, `%`
-    std::shared_ptr<AstNode> ParseMultiExpr();
-    std::shared_ptr<AstNode> ParseUnaryExpr();
-    std::shared_ptr<AstNode> ParsePostFixExpr();
+    AstNode* ParseMultiExpr();
+    AstNode* ParseUnaryExpr();
+    AstNode* ParsePostFixExpr();
 
     // Since `||` and `&&` have different priorities, 
     // we should define different functions to process them separately.
-    std::shared_ptr<AstNode> ParseLogOrExpr();
-    std::shared_ptr<AstNode> ParseLogAndExpr();
+    AstNode* ParseLogOrExpr();
+    AstNode* ParseLogAndExpr();
 
-    std::shared_ptr<AstNode> ParseBitOrExpr();
-    std::shared_ptr<AstNode> ParseBitXorExpr();
-    std::shared_ptr<AstNode> ParseBitAndExpr();
-    std::shared_ptr<AstNode> ParseBitShiftExpr();
+    AstNode* ParseBitOrExpr();
+    AstNode* ParseBitXorExpr();
+    AstNode* ParseBitAndExpr();
+    AstNode* ParseBitShiftExpr();
 
-    std::shared_ptr<AstNode> ParsePrimaryExpr();
+    AstNode* ParsePrimaryExpr();
 
     std::shared_ptr<CType> ParseTypeName();
 
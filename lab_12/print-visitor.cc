@@ -11,9 +11,16 @@ PrintVisitor::PrintVisitor(std::shared_ptr<Program> program, llvm::raw_ostream *
     VisitProgram(program.get());
 }
 
+PrintVisitor::PrintVisitor(const FlatAst& ast, llvm::raw_ostream *out) {
+    this->out_ = out;
+    for (auto node : ast.GetTopLevelNodes()) {
+        PrintFlatNode(ast, node);
+    }
+}
+
 llvm::Value* PrintVisitor::VisitProgram(Program* prog) {
     for (auto& node : prog->nodes_) {
-        node->Accept(this);
+        Visit(node);
     }
     return nullptr;
 }
@@ -22,7 +29,7 @@ llvm::Value *PrintVisitor::VisitDeclStmt(DeclStmt* decl_stmt) {
     int i = 0;
     int j = decl_stmt->nodes_.size() - 1;
     for (const auto& node : decl_stmt->nodes_) {
-        node->Accept(this);
+        Visit(node);
         ++i;
         if (i == j) {
             *out_ << ";";
@@ -35,7 +42,7 @@ llvm::Value *PrintVisitor::VisitDeclStmt(DeclStmt* decl_stmt) {
 llvm::Value *PrintVisitor::VisitBlockStmt(BlockStmt* block_stmt) {
     *out_ << "{";
     for (const auto& node : block_stmt->nodes_) {
-        node->Accept(this);
+        Visit(node);
         *out_ << ";";
     }
     *out_ << "}";
@@ -44,12 +51,12 @@ llvm::Value *PrintVisitor::VisitBlockStmt(BlockStmt* block_stmt) {
 
 llvm::Value *PrintVisitor::VisitIfStmt(IfStmt* if_stmt) {
     *out_ << "if(";
-    if_stmt->cond_node_->Accept(this);
+    Visit(if_stmt->cond_node_);
     *out_ << ")";
-    if_stmt->then_node_->Accept(this);
+    Visit(if_stmt->then_node_);
     if (if_stmt->else_node_) {
         *out_ << "else";
-        if_stmt->else_node_->Accept(this);
+        Visit(if_stmt->else_node_);
     }
 
     return nullptr;
@@ -58,20 +65,20 @@ llvm::Value *PrintVisitor::VisitIfStmt(IfStmt* if_stmt) {
 llvm::Value *PrintVisitor::VisitForStmt(ForStmt* for_stmt) {
     *out_ << "for(";
     if (for_stmt->init_node_) {
-        for_stmt->init_node_->Accept(this);
+        Visit(for_stmt->init_node_);
     }
     *out_ << ";";
     if (for_stmt->cond_node_) {
-        for_stmt->cond_node_->Accept(this);
+        Visit(for_stmt->cond_node_);
     }
     *out_ << ";";
     if (for_stmt->inc_node_) {
-        for_stmt->inc_node_->Accept(this);
+        Visit(for_stmt->inc_node_);
     }
     *out_ << ")";
 
     if (for_stmt->body_node_) {
-        for_stmt->body_node_->Accept(this);
+        Visit(for_stmt->body_node_);
     }
     
     return nullptr;
@@ -87,154 +94,75 @@ llvm::Value *PrintVisitor::VisitContinueStmt(ContinueStmt *) {
     return nullptr;
 }
 
-llvm::Value *PrintVisitor::VisitUnaryExpr(UnaryExpr* expr) {
-    switch (expr->op_) {
-        case UnaryOpCode::kPositive:
-            *out_ << "+";
-            break;
-        case UnaryOpCode::kNegative:
-            *out_ << "-";
-            break;
-        case UnaryOpCode::kSelfIncreasing:
-            *out_ << "++";
-            break;
-        case UnaryOpCode::kSelfDecreasing:
-            *out_ << "--";
-            break;
-        case UnaryOpCode::kDereference:
-            *out_ << "*";
-            break;
-        case UnaryOpCode::kAddress:
-            *out_ << "&";
-            break;
-        case UnaryOpCode::kLogicalNot:
-            *out_ << "!";
-            break;
-        case UnaryOpCode::kBitwiseNot:
-            *out_ << "~";
-            break;
-        default:
-            llvm::errs() << "Unknown unary opcode: " 
-                         << static_cast<int>(expr->op_) 
-                         << "\n";
+llvm::Value *PrintVisitor::VisitSwitchStmt(SwitchStmt* switch_stmt) {
+    *out_ << "switch(";
+    Visit(switch_stmt->cond_node_);
+    *out_ << ")";
+    if (switch_stmt->body_node_) {
+        Visit(switch_stmt->body_node_);
     }
 
-    expr->sub_node_->Accept(this);
+    return nullptr;
+}
+
+llvm::Value *PrintVisitor::VisitCaseStmt(CaseStmt* case_stmt) {
+    if (case_stmt->value_node_) {
+        *out_ << "case ";
+        Visit(case_stmt->value_node_);
+    } else {
+        *out_ << "default";
+    }
+    *out_ << ":";
+    if (case_stmt->sub_stmt_) {
+        Visit(case_stmt->sub_stmt_);
+    }
+
+    return nullptr;
+}
+
+llvm::Value *PrintVisitor::VisitLabelStmt(LabelStmt* label_stmt) {
+    *out_ << label_stmt->GetLabelName() << ":";
+    if (label_stmt->sub_stmt_) {
+        Visit(label_stmt->sub_stmt_);
+    }
+
+    return nullptr;
+}
+
+llvm::Value *PrintVisitor::VisitGotoStmt(GotoStmt* goto_stmt) {
+    *out_ << "goto " << llvm::cast<LabelStmt>(goto_stmt->target_)->GetLabelName();
+    return nullptr;
+}
+
+llvm::Value *PrintVisitor::VisitIndirectGotoStmt(IndirectGotoStmt* goto_stmt) {
+    *out_ << "goto *";
+    Visit(goto_stmt->target_node_);
+    return nullptr;
+}
+
+llvm::Value *PrintVisitor::VisitUnaryExpr(UnaryExpr* expr) {
+    PrintUnaryOp(expr->op_);
+    Visit(expr->sub_node_);
 
     return nullptr;
 }
 
 llvm::Value *PrintVisitor::VisitBinaryExpr(BinaryExpr *binary_expr) {
-    binary_expr->left_->Accept(this);
+    Visit(binary_expr->left_);
 
-    switch (binary_expr->op_) {
-        case BinaryOpCode::kEqualEqual:
-            *out_ <<"==";
-            break;
-        case BinaryOpCode::kNotEqual:
-            *out_ <<"!=";
-            break;
-        case BinaryOpCode::kLess:
-            *out_ <<"<";
-            break;
-        case BinaryOpCode::kGreater:
-            *out_ <<">";
-            break;
-        case BinaryOpCode::kLessEqual:
-            *out_ <<"<=";
-            break;
-        case BinaryOpCode::kGreaterEqual:
-            *out_ <<">=";
-            break;
-        case BinaryOpCode::kAdd:
-            *out_ <<"+";
-            break;
-        case BinaryOpCode::kSub:
-            *out_ <<"-";
-            break;
-        case BinaryOpCode::kMul:
-            *out_ <<"*";
-            break;
-        case BinaryOpCode::kDiv:
-            *out_ <<"/";
-            break;
-        case BinaryOpCode::kMod:
-            *out_ <<"%";
-            break;
-        case BinaryOpCode::kLogicalOr:
-            *out_ <<"||";
-            break;
-        case BinaryOpCode::kLogicalAnd:
-            *out_ <<"&&";
-            break;
-        case BinaryOpCode::kBitwiseOr:
-            *out_ <<"|";
-            break;
-        case BinaryOpCode::kBitwiseAnd:
-            *out_ <<"&";
-            break;
-        case BinaryOpCode::kBitwiseXor:
-            *out_ <<"^";
-            break;
-        case BinaryOpCode::kLeftShift:
-            *out_ <<"<<";
-            break;
-        case BinaryOpCode::kRightShift:
-            *out_ <<">>";
-            break;
-        case BinaryOpCode::kAssign:
-            *out_ <<"=";
-            break;
-        case BinaryOpCode::kAddAssign:
-            *out_ <<"+=";
-            break;
-        case BinaryOpCode::kSubAssign:
-            *out_ <<"-=";
-            break;
-        case BinaryOpCode::kMulAssign:
-            *out_ <<"*=";
-            break;
-        case BinaryOpCode::kDivAssign:
-            *out_ <<"/=";
-            break;
-        case BinaryOpCode::kModAssign:
-            *out_ <<"%=";
-            break;
-        case BinaryOpCode::kLeftShiftAssign:
-            *out_ <<"<<=";
-            break;
-        case BinaryOpCode::kRightShiftAssign:
-            *out_ <<">>=";
-            break;
-        case BinaryOpCode::kBitwiseAndAssign:
-            *out_ <<"&=";
-            break;
-        case BinaryOpCode::kBitwiseOrAssign:
-            *out_ <<"|=";
-            break;
-        case BinaryOpCode::kBitwiseXorAssign:
-            *out_ <<"^=";
-            break;
-        case BinaryOpCode::kComma:
-            *out_ <<",";
-            break;
-        default:
-            llvm::errs() <<"Unknown binary opcode:"
-                         << static_cast<int>(binary_expr->op_) 
-                         <<"\n";
-    }
+    PrintBinaryOp(binary_expr->op_);
 
-    binary_expr->right_->Accept(this);
+    Visit(binary_expr->right_);
 
     return nullptr;
 }
 
 llvm::Value *PrintVisitor::VisitTernaryExpr(TernaryExpr* expr) {
-    expr->cond_->Accept(this);
+    Visit(expr->cond_);
     *out_ << "?";
-    expr->then_->Accept(this);
+    Visit(expr->then_);
     *out_ << ":";
-    expr->els_->Accept(this);
+    Visit(expr->els_);
 
     return nullptr;
 }
@@ -250,7 +178,10 @@ llvm::Value *PrintVisitor::VisitVariableAccessExpr(VariableAccessExpr* access_ex
 }
 
 llvm::Value *PrintVisitor::VisitVariableDecl(VariableDecl* decl) {
-    decl->GetCType()->Accept(this);
+    if (decl->storage_class_ == StorageClass::kStatic) {
+        *out_ << "static ";
+    }
+    VisitType(decl->GetCType());
     *out_ << decl->GetVariableName();
 
     int nr_init_values = decl->init_values_.size();
@@ -258,7 +189,7 @@ llvm::Value *PrintVisitor::VisitVariableDecl(VariableDecl* decl) {
         *out_ << "=";
         for (int i = 0; i < nr_init_values; ++i) {
             const auto& init_value_struct = decl->init_values_[i];
-            init_value_struct->init_node->Accept(this);
+            Visit(init_value_struct->init_node);
             if (i != nr_init_values - 1) {
                 *out_ << ",";
             }
@@ -272,38 +203,43 @@ llvm::Value *PrintVisitor::VisitSizeofExpr(SizeofExpr* expr) {
     *out_ << "sizeof ";
     if (expr->sub_ctype_) {
         *out_ << "(";
-        expr->sub_ctype_->Accept(this);
+        VisitType(expr->sub_ctype_);
         *out_ << ")";
     }
     else if (expr->sub_node_) {
-        expr->sub_node_->Accept(this);
+        Visit(expr->sub_node_);
     }
     return nullptr;
 }
 
+llvm::Value *PrintVisitor::VisitAddrLabelExpr(AddrLabelExpr* expr) {
+    *out_ << "&&" << llvm::cast<LabelStmt>(expr->target_)->GetLabelName();
+    return nullptr;
+}
+
 llvm::Value *PrintVisitor::VisitPostIncExpr(PostIncExpr* expr) {
-    expr->sub_node_->Accept(this);
+    Visit(expr->sub_node_);
     *out_ << "++";
     return nullptr;
 }
 
 llvm::Value *PrintVisitor::VisitPostDecExpr(PostDecExpr* expr) {
-    expr->sub_node_->Accept(this);
+    Visit(expr->sub_node_);
     *out_ << "--";
     return nullptr;
 }
 
 llvm::Value *PrintVisitor::VisitPostSubscript(PostSubscriptExpr* expr) {
-    expr->sub_node_->Accept(this);
+    Visit(expr->sub_node_);
     *out_ << "[";
-    expr->index_node_->Accept(this);
+    Visit(expr->index_node_);
     *out_ << "]";
 
     return nullptr;
 }
 
 llvm::Value *PrintVisitor::VisitPostMemberDotExpr(PostMemberDotExpr* expr) {
-    expr->struct_node_->Accept(this);
+    Visit(expr->struct_node_);
     *out_ << ".";
     *out_ << expr->target_member_.name;
 
@@ -311,7 +247,7 @@ llvm::Value *PrintVisitor::VisitPostMemberDotExpr(PostMemberDotExpr* expr) {
 }
 
 llvm::Value *PrintVisitor::VisitPostMemberArrowExpr(PostMemberArrowExpr* expr) {
-    expr->struct_pointer_node_->Accept(this);
+    Visit(expr->struct_pointer_node_);
     *out_ << "->";
     *out_ << expr->target_member_.name;
 
@@ -319,9 +255,15 @@ llvm::Value *PrintVisitor::VisitPostMemberArrowExpr(PostMemberArrowExpr* expr) {
 }
 
 llvm::Value *PrintVisitor::VisitFuncDecl(FuncDecl* func_decl) {
-    func_decl->GetCType()->Accept(this);
+    if (func_decl->storage_class_ == StorageClass::kStatic) {
+        *out_ << "static ";
+    }
+    if (func_decl->is_inline_) {
+        *out_ << "inline ";
+    }
+    VisitType(func_decl->GetCType());
     if (func_decl->block_stmt_) {
-        func_decl->block_stmt_->Accept(this);
+        Visit(func_decl->block_stmt_);
     } else {
         *out_ << ";";
     }
@@ -329,12 +271,12 @@ llvm::Value *PrintVisitor::VisitFuncDecl(FuncDecl* func_decl) {
 }
 
 llvm::Value *PrintVisitor::VisitPostFuncCallExpr(PostFuncCallExpr* func_call_expr) {
-    func_call_expr->func_node_->Accept(this);
+    Visit(func_call_expr->func_node_);
     *out_ << "(";
 
     auto arg_nodes = func_call_expr->arg_nodes_;
     for (int i = 0; i < arg_nodes.size(); ++i) {
-        arg_nodes[i]->Accept(this);
+        Visit(arg_nodes[i]);
         if (i != arg_nodes.size() - 1) {
             *out_ << ",";
         }
@@ -347,12 +289,15 @@ llvm::Value *PrintVisitor::VisitPostFuncCallExpr(PostFuncCallExpr* func_call_exp
 llvm::Value *PrintVisitor::VisitReturnStmt(ReturnStmt* ret_stmt) {
     *out_ << "return ";
     if (ret_stmt->value_node_) {
-        ret_stmt->value_node_->Accept(this);
+        Visit(ret_stmt->value_node_);
     }
     return nullptr;
 }
 
 llvm::Type *PrintVisitor::VisitPrimaryType(CPrimaryType* ctype) {
+    if (ctype->IsConst()) {
+        *out_ << "const ";
+    }
     switch (ctype->GetKind()) {
         case CType::TypeKind::kInt:
             *out_ << "int ";
@@ -365,8 +310,14 @@ llvm::Type *PrintVisitor::VisitPrimaryType(CPrimaryType* ctype) {
 }
 
 llvm::Type *PrintVisitor::VisitPointerType(CPointerType* ctype) {
-    ctype->GetBaseType()->Accept(this);
+    VisitType(ctype->GetBaseType());
     *out_ << "*";
+    if (ctype->IsConst()) {
+        *out_ << "const ";
+    }
+    if (ctype->IsRestrict()) {
+        *out_ << "restrict ";
+    }
     return nullptr;
 }
 
@@ -374,7 +325,7 @@ llvm::Type *PrintVisitor::VisitArrayType(CArrayType* ctype) {
     *out_ << "[";
     *out_ << ctype->GetElementCount();
     *out_ << "]";
-    ctype->GetElementType()->Accept(this);
+    VisitType(ctype->GetElementType());
 
     return nullptr;
 }
@@ -390,23 +341,28 @@ llvm::Type *PrintVisitor::VisitRecordType(CRecordType* ctype) {
             break;
     }
 
+    if (!printing_records_.insert(ctype).second) {
+        *out_ << ctype->GetName() << " ";
+        return nullptr;
+    }
     *out_ << ctype->GetName() << "{";
     for (const auto& member : ctype->GetMembers()) {
-        member.type->Accept(this);
+        VisitType(member.type);
         *out_ << member.name << ";";
     }
     *out_ << "} ";
+    printing_records_.erase(ctype);
 
     return nullptr;
 }
 
 llvm::Type *PrintVisitor::VisitFuncType(CFuncType* func_type) {
-    func_type->GetRetType()->Accept(this);
+    VisitType(func_type->GetRetType());
     *out_ << func_type->GetFuncName() << "(";
 
     const auto& params = func_type->GetParams();
     for (int i = 0; i < params.size(); ++i) {
-        params[i].type->Accept(this);
+        VisitType(params[i].type);
         *out_ << params[i].name;
         if (i != params.size() - 1) {
             *out_ << ",";
@@ -415,5 +371,399 @@ llvm::Type *PrintVisitor::VisitFuncType(CFuncType* func_type) {
 
     *out_ << ")";
 
+    if (func_type->attrs_) {
+        *out_ << " __attribute__((";
+        bool is_first = true;
+        for (int i = 0; i < static_cast<int>(FuncAttr::kCount); ++i) {
+            auto attr = static_cast<FuncAttr>(i);
+            if (func_type->HasAttr(attr)) {
+                *out_ << (is_first ? "" : ",") << CFuncType::GetAttrName(attr);
+                is_first = false;
+            }
+        }
+        *out_ << "))";
+    }
+
     return nullptr;
 }
+
+void PrintVisitor::PrintFlatNode(const FlatAst& ast, FlatAst::NodeRef node) {
+    switch (ast.GetKind(node)) {
+        case AstNode::AstNodeKind::kDeclStmt: {
+            auto nodes = ast.GetList(ast.GetListNode(node).nodes);
+            int i = 0;
+            int j = nodes.size() - 1;
+            for (auto child : nodes) {
+                PrintFlatNode(ast, child);
+                ++i;
+                if (i == j) {
+                    *out_ << ";";
+                }
+            }
+            break;
+        }
+        case AstNode::AstNodeKind::kBlockStmt: {
+            *out_ << "{";
+            for (auto child : ast.GetList(ast.GetListNode(node).nodes)) {
+                PrintFlatNode(ast, child);
+                *out_ << ";";
+            }
+            *out_ << "}";
+            break;
+        }
+        case AstNode::AstNodeKind::kIfStmt: {
+            const auto& if_node = ast.GetIfNode(node);
+            *out_ << "if(";
+            PrintFlatNode(ast, if_node.cond);
+            *out_ << ")";
+            PrintFlatNode(ast, if_node.then);
+            if (if_node.els != FlatAst::kNullNode) {
+                *out_ << "else";
+                PrintFlatNode(ast, if_node.els);
+            }
+            break;
+        }
+        case AstNode::AstNodeKind::kForStmt: {
+            const auto& for_node = ast.GetForNode(node);
+            *out_ << "for(";
+            if (for_node.init != FlatAst::kNullNode) {
+                PrintFlatNode(ast, for_node.init);
+            }
+            *out_ << ";";
+            if (for_node.cond != FlatAst::kNullNode) {
+                PrintFlatNode(ast, for_node.cond);
+            }
+            *out_ << ";";
+            if (for_node.inc != FlatAst::kNullNode) {
+                PrintFlatNode(ast, for_node.inc);
+            }
+            *out_ << ")";
+            if (for_node.body != FlatAst::kNullNode) {
+                PrintFlatNode(ast, for_node.body);
+            }
+            break;
+        }
+        case AstNode::AstNodeKind::kBreakStmt: {
+            *out_ << "break";
+            break;
+        }
+        case AstNode::AstNodeKind::kContinueStmt: {
+            *out_ << "continue";
+            break;
+        }
+        case AstNode::AstNodeKind::kSwitchStmt: {
+            const auto& switch_node = ast.GetSwitchNode(node);
+            *out_ << "switch(";
+            PrintFlatNode(ast, switch_node.cond);
+            *out_ << ")";
+            if (switch_node.body != FlatAst::kNullNode) {
+                PrintFlatNode(ast, switch_node.body);
+            }
+            break;
+        }
+        case AstNode::AstNodeKind::kCaseStmt: {
+            const auto& case_node = ast.GetCaseNode(node);
+            if (case_node.value != FlatAst::kNullNode) {
+                *out_ << "case ";
+                PrintFlatNode(ast, case_node.value);
+            } else {
+                *out_ << "default";
+            }
+            *out_ << ":";
+            if (case_node.sub != FlatAst::kNullNode) {
+                PrintFlatNode(ast, case_node.sub);
+            }
+            break;
+        }
+        case AstNode::AstNodeKind::kLabelStmt: {
+            const auto& label_node = ast.GetLabelNode(node);
+            *out_ << label_node.name << ":";
+            if (label_node.sub != FlatAst::kNullNode) {
+                PrintFlatNode(ast, label_node.sub);
+            }
+            break;
+        }
+        case AstNode::AstNodeKind::kGotoStmt: {
+            *out_ << "goto " << ast.GetLabelNode(ast.GetJumpNode(node).target).name;
+            break;
+        }
+        case AstNode::AstNodeKind::kIndirectGotoStmt: {
+            *out_ << "goto *";
+            PrintFlatNode(ast, ast.GetIndirectGotoNode(node).target);
+            break;
+        }
+        case AstNode::AstNodeKind::kUnaryExpr: {
+            const auto& unary_node = ast.GetUnaryNode(node);
+            PrintUnaryOp(unary_node.op);
+            PrintFlatNode(ast, unary_node.sub);
+            break;
+        }
+        case AstNode::AstNodeKind::kBinaryExpr: {
+            const auto& binary_node = ast.GetBinaryNode(node);
+            PrintFlatNode(ast, binary_node.left);
+            PrintBinaryOp(binary_node.op);
+            PrintFlatNode(ast, binary_node.right);
+            break;
+        }
+        case AstNode::AstNodeKind::kTernaryExpr: {
+            const auto& ternary_node = ast.GetTernaryNode(node);
+            PrintFlatNode(ast, ternary_node.cond);
+            *out_ << "?";
+            PrintFlatNode(ast, ternary_node.then);
+            *out_ << ":";
+            PrintFlatNode(ast, ternary_node.els);
+            break;
+        }
+        case AstNode::AstNodeKind::kNumberExpr: {
+            *out_ << ast.GetNumberNode(node).value;
+            break;
+        }
+        case AstNode::AstNodeKind::kVariableAccessExpr: {
+            *out_ << ast.GetVariableAccessNode(node).name;
+            break;
+        }
+        case AstNode::AstNodeKind::kVariableDecl: {
+            const auto& decl_node = ast.GetVariableDeclNode(node);
+            if (decl_node.storage_class == StorageClass::kStatic) {
+                *out_ << "static ";
+            }
+            VisitType(ast.GetCType(node));
+            *out_ << decl_node.name;
+
+            auto init_values = ast.GetInitValues(decl_node);
+            if (!init_values.empty()) {
+                *out_ << "=";
+                for (int i = 0; i < init_values.size(); ++i) {
+                    PrintFlatNode(ast, init_values[i].init_node);
+                    if (i != init_values.size() - 1) {
+                        *out_ << ",";
+                    }
+                }
+            }
+            break;
+        }
+        case AstNode::AstNodeKind::kSizeof: {
+            const auto& sizeof_node = ast.GetSizeofNode(node);
+            *out_ << "sizeof ";
+            if (sizeof_node.sub_type != FlatAst::kNullType) {
+                *out_ << "(";
+                VisitType(ast.GetType(sizeof_node.sub_type));
+                *out_ << ")";
+            }
+            else if (sizeof_node.sub != FlatAst::kNullNode) {
+                PrintFlatNode(ast, sizeof_node.sub);
+            }
+            break;
+        }
+        case AstNode::AstNodeKind::kAddrLabelExpr: {
+            *out_ << "&&" << ast.GetLabelNode(ast.GetJumpNode(node).target).name;
+            break;
+        }
+        case AstNode::AstNodeKind::kPostIncExpr: {
+            PrintFlatNode(ast, ast.GetPostfixNode(node).sub);
+            *out_ << "++";
+            break;
+        }
+        case AstNode::AstNodeKind::kPostDecExpr: {
+            PrintFlatNode(ast, ast.GetPostfixNode(node).sub);
+            *out_ << "--";
+            break;
+        }
+        case AstNode::AstNodeKind::kPostSubscriptExpr: {
+            const auto& subscript_node = ast.GetSubscriptNode(node);
+            PrintFlatNode(ast, subscript_node.sub);
+            *out_ << "[";
+            PrintFlatNode(ast, subscript_node.index);
+            *out_ << "]";
+            break;
+        }
+        case AstNode::AstNodeKind::kPostMemberDotExpr: {
+            const auto& member_node = ast.GetMemberNode(node);
+            PrintFlatNode(ast, member_node.base);
+            *out_ << ".";
+            *out_ << ast.GetMember(member_node).name;
+            break;
+        }
+        case AstNode::AstNodeKind::kPostMemberArrowExpr: {
+            const auto& member_node = ast.GetMemberNode(node);
+            PrintFlatNode(ast, member_node.base);
+            *out_ << "->";
+            *out_ << ast.GetMember(member_node).name;
+            break;
+        }
+        case AstNode::AstNodeKind::kFuncDecl: {
+            const auto& func_decl_node = ast.GetFuncDeclNode(node);
+            if (func_decl_node.storage_class == StorageClass::kStatic) {
+                *out_ << "static ";
+            }
+            if (func_decl_node.is_inline) {
+                *out_ << "inline ";
+            }
+            VisitType(ast.GetCType(node));
+            if (func_decl_node.body != FlatAst::kNullNode) {
+                PrintFlatNode(ast, func_decl_node.body);
+            } else {
+                *out_ << ";";
+            }
+            break;
+        }
+        case AstNode::AstNodeKind::kPostFuncCallExpr: {
+            const auto& call_node = ast.GetCallNode(node);
+            PrintFlatNode(ast, call_node.func);
+            *out_ << "(";
+            auto arg_nodes = ast.GetList(call_node.args);
+            for (int i = 0; i < arg_nodes.size(); ++i) {
+                PrintFlatNode(ast, arg_nodes[i]);
+                if (i != arg_nodes.size() - 1) {
+                    *out_ << ",";
+                }
+            }
+            *out_ << ")";
+            break;
+        }
+        case AstNode::AstNodeKind::kReturnStmt: {
+            const auto& ret_node = ast.GetReturnNode(node);
+            *out_ << "return ";
+            if (ret_node.value != FlatAst::kNullNode) {
+                PrintFlatNode(ast, ret_node.value);
+            }
+            break;
+        }
+        default:
+            llvm::errs() << "Unknown node kind: "
+                         << static_cast<int>(ast.GetKind(node))
+                         << "\n";
+    }
+}
+
+void PrintVisitor::PrintUnaryOp(UnaryOpCode op) {
+    switch (op) {
+        case UnaryOpCode::kPositive:
+            *out_ << "+";
+            break;
+        case UnaryOpCode::kNegative:
+            *out_ << "-";
+            break;
+        case UnaryOpCode::kSelfIncreasing:
+            *out_ << "++";
+            break;
+        case UnaryOpCode::kSelfDecreasing:
+            *out_ << "--";
+            break;
+        case UnaryOpCode::kDereference:
+            *out_ << "*";
+            break;
+        case UnaryOpCode::kAddress:
+            *out_ << "&";
+            break;
+        case UnaryOpCode::kLogicalNot:
+            *out_ << "!";
+            break;
+        case UnaryOpCode::kBitwiseNot:
+            *out_ << "~";
+            break;
+        default:
+            llvm::errs() << "Unknown unary opcode: " 
+                         << static_cast<int>(op) 
+                         << "\n";
+    }
+}
+
+void PrintVisitor::PrintBinaryOp(BinaryOpCode op) {
+    switch (op) {
+        case BinaryOpCode::kEqualEqual:
+            *out_ <<"==";
+            break;
+        case BinaryOpCode::kNotEqual:
+            *out_ <<"!=";
+            break;
+        case BinaryOpCode::kLess:
+            *out_ <<"<";
+            break;
+        case BinaryOpCode::kGreater:
+            *out_ <<">";
+            break;
+        case BinaryOpCode::kLessEqual:
+            *out_ <<"<=";
+            break;
+        case BinaryOpCode::kGreaterEqual:
+            *out_ <<">=";
+            break;
+        case BinaryOpCode::kAdd:
+            *out_ <<"+";
+            break;
+        case BinaryOpCode::kSub:
+            *out_ <<"-";
+            break;
+        case BinaryOpCode::kMul:
+            *out_ <<"*";
+            break;
+        case BinaryOpCode::kDiv:
+            *out_ <<"/";
+            break;
+        case BinaryOpCode::kMod:
+            *out_ <<"%";
+            break;
+        case BinaryOpCode::kLogicalOr:
+            *out_ <<"||";
+            break;
+        case BinaryOpCode::kLogicalAnd:
+            *out_ <<"&&";
+            break;
+        case BinaryOpCode::kBitwiseOr:
+            *out_ <<"|";
+            break;
+        case BinaryOpCode::kBitwiseAnd:
+            *out_ <<"&";
+            break;
+        case BinaryOpCode::kBitwiseXor:
+            *out_ <<"^";
+            break;
+        case BinaryOpCode::kLeftShift:
+            *out_ <<"<<";
+            break;
+        case BinaryOpCode::kRightShift:
+            *out_ <<">>";
+            break;
+        case BinaryOpCode::kAssign:
+            *out_ <<"=";
+            break;
+        case BinaryOpCode::kAddAssign:
+            *out_ <<"+=";
+            break;
+        case BinaryOpCode::kSubAssign:
+            *out_ <<"-=";
+            break;
+        case BinaryOpCode::kMulAssign:
+            *out_ <<"*=";
+            break;
+        case BinaryOpCode::kDivAssign:
+            *out_ <<"/=";
+            break;
+        case BinaryOpCode::kModAssign:
+            *out_ <<"%=";
+            break;
+        case BinaryOpCode::kLeftShiftAssign:
+            *out_ <<"<<=";
+            break;
+        case BinaryOpCode::kRightShiftAssign:
+            *out_ <<">>=";
+            break;
+        case BinaryOpCode::kBitwiseAndAssign:
+            *out_ <<"&=";
+            break;
+        case BinaryOpCode::kBitwiseOrAssign:
+            *out_ <<"|=";
+            break;
+        case BinaryOpCode::kBitwiseXorAssign:
+            *out_ <<"^=";
+            break;
+        case BinaryOpCode::kComma:
+            *out_ <<",";
+            break;
+        default:
+            llvm::errs() <<"Unknown binary opcode:"
+                         << static_cast<int>(op) 
+                         <<"\n";
+    }
+}
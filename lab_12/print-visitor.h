@@ -5,53 +5,71 @@
 #ifndef PRINT_VISITOR_H_
 #define PRINT_VISITOR_H_
 
+#include "llvm/ADT/SmallPtrSet.h"
+
 #include "ast.h"
+#include "flat-ast.h"
 #include "type.h"
 
-class PrintVisitor : public Visitor, public TypeVisitor {
+class PrintVisitor : public StaticVisitor<PrintVisitor>, public StaticTypeVisitor<PrintVisitor> {
  private:
     llvm::raw_ostream *out_;
+    // The records whose members are being printed. A member referring back to
+    // one of them, like `struct Node *next`, only prints its name.
+    llvm::SmallPtrSet<CRecordType*, 4> printing_records_;
+
+    void PrintFlatNode(const FlatAst& ast, FlatAst::NodeRef node);
+    void PrintUnaryOp(UnaryOpCode op);
+    void PrintBinaryOp(BinaryOpCode op);
 
  public:
     explicit PrintVisitor(std::shared_ptr<Program> program, llvm::raw_ostream *out = &llvm::outs());
+    // Print the flat form of an AST, the output is the same as the one of the tree form.
+    explicit PrintVisitor(const FlatAst& ast, llvm::raw_ostream *out = &llvm::outs());
 
-    // Virtual functions of Visitor.
-    llvm::Value* VisitProgram(Program*) override;
+    // Handlers of StaticVisitor.
+    llvm::Value* VisitProgram(Program*);
 
-    llvm::Value* VisitDeclStmt(DeclStmt*) override;
-    llvm::Value* VisitBlockStmt(BlockStmt*) override;
-    llvm::Value* VisitIfStmt(IfStmt*) override;
-    llvm::Value* VisitForStmt(ForStmt*) override;
-    llvm::Value* VisitBreakStmt(BreakStmt*) override;
-    llvm::Value* VisitContinueStmt(ContinueStmt*) override;
+    llvm::Value* VisitDeclStmt(DeclStmt*);
+    llvm::Value* VisitBlockStmt(BlockStmt*);
+    llvm::Value* VisitIfStmt(IfStmt*);
+    llvm::Value* VisitForStmt(ForStmt*);
+    llvm::Value* VisitBreakStmt(BreakStmt*);
+    llvm::Value* VisitContinueStmt(ContinueStmt*);
+    llvm::Value* VisitSwitchStmt(SwitchStmt*);
+    llvm::Value* VisitCaseStmt(CaseStmt*);
+    llvm::Value* VisitLabelStmt(LabelStmt*);
+    llvm::Value* VisitGotoStmt(GotoStmt*);
+    llvm::Value* VisitIndirectGotoStmt(IndirectGotoStmt*);
 
-    llvm::Value* VisitUnaryExpr(UnaryExpr*) override;
-    llvm::Value* VisitBinaryExpr(BinaryExpr*) override;
-    llvm::Value* VisitTernaryExpr(TernaryExpr*) override;
+    llvm::Value* VisitUnaryExpr(UnaryExpr*);
+    llvm::Value* VisitBinaryExpr(BinaryExpr*);
+    llvm::Value* VisitTernaryExpr(TernaryExpr*);
 
-    llvm::Value* VisitNumberExpr(NumberExpr*) override;
-    llvm::Value* VisitVariableAccessExpr(VariableAccessExpr*) override;
-    llvm::Value* VisitVariableDecl(VariableDecl*) override;
-    llvm::Value* VisitSizeofExpr(SizeofExpr*) override;
+    llvm::Value* VisitNumberExpr(NumberExpr*);
+    llvm::Value* VisitVariableAccessExpr(VariableAccessExpr*);
+    llvm::Value* VisitVariableDecl(VariableDecl*);
+    llvm::Value* VisitSizeofExpr(SizeofExpr*);
+    llvm::Value* VisitAddrLabelExpr(AddrLabelExpr*);
 
-    llvm::Value* VisitPostIncExpr(PostIncExpr*) override;
-    llvm::Value* VisitPostDecExpr(PostDecExpr*) override;
+    llvm::Value* VisitPostIncExpr(PostIncExpr*);
+    llvm::Value* VisitPostDecExpr(PostDecExpr*);
 
-    llvm::Value* VisitPostSubscript(PostSubscriptExpr*) override;
+    llvm::Value* VisitPostSubscript(PostSubscriptExpr*);
 
-    llvm::Value* VisitPostMemberDotExpr(PostMemberDotExpr*) override;
-    llvm::Value* VisitPostMemberArrowExpr(PostMemberArrowExpr*) override;
+    llvm::Value* VisitPostMemberDotExpr(PostMemberDotExpr*);
+    llvm::Value* VisitPostMemberArrowExpr(PostMemberArrowExpr*);
 
-    llvm::Value* VisitFuncDecl(FuncDecl*) override;
-    llvm::Value* VisitPostFuncCallExpr(PostFuncCallExpr*) override;
-    llvm::Value* VisitReturnStmt(ReturnStmt*) override;
+    llvm::Value* VisitFuncDecl(FuncDecl*);
+    llvm::Value* VisitPostFuncCallExpr(PostFuncCallExpr*);
+    llvm::Value* VisitReturnStmt(ReturnStmt*);
 
-    // Virtual functions of TypeVisitor.
-    llvm::Type* VisitPrimaryType(CPrimaryType*) override;
-    llvm::Type* VisitPointerType(CPointerType*) override;
-    llvm::Type* VisitArrayType(CArrayType*) override;
-    llvm::Type* VisitRecordType(CRecordType*) override;
-    llvm::Type* VisitFuncType(CFuncType*) override;
+    // Handlers of StaticTypeVisitor.
+    llvm::Type* VisitPrimaryType(CPrimaryType*);
+    llvm::Type* VisitPointerType(CPointerType*);
+    llvm::Type* VisitArrayType(CArrayType*);
+    llvm::Type* VisitRecordType(CRecordType*);
+    llvm::Type* VisitFuncType(CFuncType*);
 };
 
 #endif  // PRINT_VISITOR_H_
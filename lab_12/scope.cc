@@ -4,62 +4,77 @@
 
 #include "scope.h"
 
-#include <memory>
-
-Scope::Scope() {
-    EnterScope();
-}
+#include <cassert>
 
 void Scope::EnterScope() {
-    envs_.emplace_back(std::make_shared<Env>());
+    scope_starts_.push_back(undo_log_.size());
 }
 
 void Scope::ExitScope() {
-    envs_.pop_back();
+    assert(!scope_starts_.empty());
+    size_t start = scope_starts_.pop_back_val();
+    while (undo_log_.size() > start) {
+        Symbol* symbol = undo_log_.pop_back_val();
+        auto& bindings = table_.find(symbol->name_)->getValue();
+        GetBinding(bindings, symbol->kind_) = symbol->shadowed_;
+    }
+}
+
+llvm::ArrayRef<Symbol*> Scope::GetGlobalSymbols() const {
+    assert(scope_starts_.empty());
+    return undo_log_;
 }
 
-std::shared_ptr<Symbol> Scope::FindObjectSymbol(llvm::StringRef name) {
-    for (auto iter = envs_.rbegin(); iter != envs_.rend(); ++iter) {
-        auto& table = (*iter)->GetObjectSymbolTable();
-        if (table.count(name) > 0) {
-            return table[name];
-        }
+Symbol* Scope::FindSymbol(llvm::StringRef name, SymbolKind kind) {
+    auto iter = table_.find(name);
+    if (iter == table_.end()) {
+        return nullptr;
     }
-    return nullptr;
+    return GetBinding(iter->getValue(), kind);
 }
 
-std::shared_ptr<Symbol> Scope::FindObjectSymbolInCurrentEnv(llvm::StringRef name) {
-    auto& table = envs_.back()->GetObjectSymbolTable();
-    if (table.count(name) > 0) {
-        return table[name];
+Symbol* Scope::FindSymbolInCurrentEnv(llvm::StringRef name, SymbolKind kind) {
+    Symbol* symbol = FindSymbol(name, kind);
+    if (symbol && symbol->depth_ == static_cast<int>(scope_starts_.size())) {
+        return symbol;
     }
     return nullptr;
 }
 
-void Scope::AddObjectSymbol(llvm::StringRef name, std::shared_ptr<CType> ctype) {
-    auto symbol = std::make_shared<Symbol>(SymbolKind::kObject, ctype, name);
-    envs_.back()->GetObjectSymbolTable().insert({ name, symbol });
+void Scope::AddSymbol(llvm::StringRef name, std::shared_ptr<CType> ctype, SymbolKind kind, AstNode* decl) {
+    int depth = scope_starts_.size();
+    Symbol*& binding = GetBinding(table_[name], kind);
+    // Keep the first declaration if the name is declared again
+    // in the same scope, e.g. a function declared before its definition.
+    if (binding && binding->depth_ == depth) {
+        return;
+    }
+
+    auto symbol = new (allocator_.Allocate()) Symbol(kind, ctype, name, decl, depth, binding);
+    binding = symbol;
+    undo_log_.push_back(symbol);
 }
 
-std::shared_ptr<Symbol> Scope::FindTagSymbol(llvm::StringRef name) {
-    for (auto iter = envs_.rbegin(); iter != envs_.rend(); ++iter) {
-        auto& table = (*iter)->GetTagSymbolTable();
-        if (table.count(name) > 0) {
-            return table[name];
-        }
-    }
-    return nullptr;
+Symbol* Scope::FindObjectSymbol(llvm::StringRef name) {
+    return FindSymbol(name, SymbolKind::kObject);
 }
 
-std::shared_ptr<Symbol> Scope::FindTagSymbolInCurrentEnv(llvm::StringRef name) {
-    auto& table = envs_.back()->GetTagSymbolTable();
-    if (table.count(name) > 0) {
-        return table[name];
-    }
-    return nullptr;
+Symbol* Scope::FindObjectSymbolInCurrentEnv(llvm::StringRef name) {
+    return FindSymbolInCurrentEnv(name, SymbolKind::kObject);
+}
+
+void Scope::AddObjectSymbol(llvm::StringRef name, std::shared_ptr<CType> ctype, AstNode* decl) {
+    AddSymbol(name, ctype, SymbolKind::kObject, decl);
+}
+
+Symbol* Scope::FindTagSymbol(llvm::StringRef name) {
+    return FindSymbol(name, SymbolKind::kTag);
+}
+
+Symbol* Scope::FindTagSymbolInCurrentEnv(llvm::StringRef name) {
+    return FindSymbolInCurrentEnv(name, SymbolKind::kTag);
 }
 
 void Scope::AddTagSymbol(llvm::StringRef name, std::shared_ptr<CType> ctype) {
-    auto symbol = std::make_shared<Symbol>(SymbolKind::kTag, ctype, name);
-    envs_.back()->GetTagSymbolTable().insert({ name, symbol });
+    AddSymbol(name, ctype, SymbolKind::kTag, nullptr);
 }
@@ -5,13 +5,17 @@
 #ifndef SCOPE_H_
 #define SCOPE_H_
 
-#include <vector>
 #include <memory>
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Allocator.h"
 
 #include "type.h"
 
+class AstNode;
+
 enum class SymbolKind {
     // Object is something that we need allocate memory for it,
     // including variable and function.
@@ -26,10 +30,23 @@ class Symbol {
     SymbolKind kind_;
     std::shared_ptr<CType> ctype_;
     llvm::StringRef name_;
+    // The node declaring an object symbol.
+    AstNode* decl_;
+
+    // The nesting level of the scope which declares the symbol,
+    // 0 means the global scope.
+    int depth_;
+    // The symbol with the same name and kind in an outer scope,
+    // which is hidden by this one.
+    Symbol* shadowed_;
+
+    friend class Scope;
 
  public:
-    Symbol(SymbolKind kind, std::shared_ptr<CType> ctype, llvm::StringRef name)
-        : kind_(kind), ctype_(ctype), name_(name) {}
+    Symbol(SymbolKind kind, std::shared_ptr<CType> ctype, llvm::StringRef name,
+           AstNode* decl, int depth, Symbol* shadowed)
+        : kind_(kind), ctype_(ctype), name_(name), decl_(decl),
+          depth_(depth), shadowed_(shadowed) {}
 
     SymbolKind GetSymbolKind() const {
         return kind_;
@@ -42,39 +59,58 @@ class Symbol {
     const llvm::StringRef& GetSymbolName() const {
         return name_;
     }
+
+    AstNode* GetDecl() const {
+        return decl_;
+    }
 };
 
-class Env {
+// NOTE:
+// All the scopes share one hash table, which maps a name to the innermost
+// symbol declaring it, and that symbol links to the ones it shadows.
+// So looking up a name is a single probe no matter how deep the scopes nest.
+//
+// Each symbol added is also pushed into `undo_log_`. When leaving a scope,
+// we pop the symbols added in it, and bring back the ones they shadowed.
+// Entering or leaving a scope never allocates memory.
+class Scope {
  private:
-    llvm::StringMap<std::shared_ptr<Symbol>> obj_symbol_table_;
-    llvm::StringMap<std::shared_ptr<Symbol>> tag_symbol_table_;
+    struct Bindings {
+        Symbol* object { nullptr };
+        Symbol* tag { nullptr };
+    };
 
- public:
-    llvm::StringMap<std::shared_ptr<Symbol>>& GetObjectSymbolTable() {
-        return obj_symbol_table_;
-    }
+    llvm::StringMap<Bindings> table_;
+    llvm::SpecificBumpPtrAllocator<Symbol> allocator_;
+
+    llvm::SmallVector<Symbol*> undo_log_;
+    // The size of `undo_log_` when entering each of the nested scopes.
+    llvm::SmallVector<size_t> scope_starts_;
 
-    llvm::StringMap<std::shared_ptr<Symbol>>& GetTagSymbolTable() {
-        return tag_symbol_table_;
+    static Symbol*& GetBinding(Bindings& bindings, SymbolKind kind) {
+        return kind == SymbolKind::kObject ? bindings.object : bindings.tag;
     }
-};
 
-class Scope {
- private:
-    std::vector<std::shared_ptr<Env>> envs_;
+    Symbol* FindSymbol(llvm::StringRef name, SymbolKind kind);
+    Symbol* FindSymbolInCurrentEnv(llvm::StringRef name, SymbolKind kind);
+    void AddSymbol(llvm::StringRef name, std::shared_ptr<CType> ctype, SymbolKind kind, AstNode* decl);
 
  public:
-    Scope();
+    Scope() = default;
 
     void EnterScope();
     void ExitScope();
 
-    std::shared_ptr<Symbol> FindObjectSymbol(llvm::StringRef name);
-    std::shared_ptr<Symbol> FindObjectSymbolInCurrentEnv(llvm::StringRef name);
-    void AddObjectSymbol(llvm::StringRef name, std::shared_ptr<CType> ctype);
+    // The symbols declared in the global scope, in the order of declaration.
+    // It should only be called in the global scope.
+    llvm::ArrayRef<Symbol*> GetGlobalSymbols() const;
+
+    Symbol* FindObjectSymbol(llvm::StringRef name);
+    Symbol* FindObjectSymbolInCurrentEnv(llvm::StringRef name);
+    void AddObjectSymbol(llvm::StringRef name, std::shared_ptr<CType> ctype, AstNode* decl);
 
-    std::shared_ptr<Symbol> FindTagSymbol(llvm::StringRef name);
-    std::shared_ptr<Symbol> FindTagSymbolInCurrentEnv(llvm::StringRef name);
+    Symbol* FindTagSymbol(llvm::StringRef name);
+    Symbol* FindTagSymbolInCurrentEnv(llvm::StringRef name);
     void AddTagSymbol(llvm::StringRef name, std::shared_ptr<CType> ctype);
 };
 
@@ -6,9 +6,12 @@
 
 #include <memory>
 
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Casting.h"
 
+#include "const-eval.h"
+
 void Sema::EnterScope() {
     scope_.EnterScope();
 }
@@ -21,7 +24,7 @@ void Sema::SetMode(Mode mode) {
     mode_ = mode;
 }
 
-std::shared_ptr<AstNode> Sema::SemaVariableDeclNode(Token& token, std::shared_ptr<CType> ctype, bool is_global) {
+AstNode* Sema::SemaVariableDeclNode(Token& token, std::shared_ptr<CType> ctype, bool is_global) {
     // 1. Has the variable name already been defined?
     auto name = token.GetContent();
     auto symbol = scope_.FindObjectSymbolInCurrentEnv(name);
@@ -33,20 +36,62 @@ std::shared_ptr<AstNode> Sema::SemaVariableDeclNode(Token& token, std::shared_pt
                 name);
     }
 
-    // 2. Add the symbol name to symbol table.
-    if (mode_ == Mode::kNormal) {
-        scope_.AddObjectSymbol(name, ctype);
-    }
-
-    // 3. Allocate the variable declare node object.
-    auto node = std::make_shared<VariableDecl>();
+    // 2. Allocate the variable declare node object.
+    auto node = program_->Create<VariableDecl>();
     node->SetBoundToken(token);
     node->SetCType(ctype);
     node->is_global_ = is_global;
+
+    // 3. Add the symbol name to symbol table.
+    if (mode_ == Mode::kNormal) {
+        scope_.AddObjectSymbol(name, ctype, node);
+    }
+
     return node;
 }
 
-std::shared_ptr<AstNode> Sema::SemaVariableAccessNode(Token& token) {
+void Sema::SemaVariableDeclSpec(
+    AstNode* decl_node,
+    StorageClass storage_class,
+    bool is_inline,
+    Token& inline_token)
+{
+    auto decl = llvm::cast<VariableDecl>(decl_node);
+
+    if (mode_ == Mode::kNormal && is_inline) {
+        diag_engine_.Report(
+                llvm::SMLoc::getFromPointer(inline_token.GetRawContentPtr()),
+                Diag::kErrInlineVariable);
+    }
+
+    decl->storage_class_ = storage_class;
+
+    for (const auto init_value : decl->init_values_) {
+        CheckConstNotDiscarded(init_value->decl_type.get(), init_value->init_node, 
+                               decl->GetBoundToken(), "initialization");
+    }
+
+    // NOTE:
+    // A static local variable is initialized before the program starts,
+    // rather than each time its declaration is reached,
+    // so the integers in its initializer must be constants.
+    if (mode_ == Mode::kNormal && 
+        storage_class == StorageClass::kStatic && 
+        !decl->is_global_) 
+    {
+        for (const auto init_value : decl->init_values_) {
+            if (init_value->decl_type->GetKind() == CType::TypeKind::kInt &&
+                !init_value->init_node->GetConstantValue()) 
+            {
+                diag_engine_.Report(
+                        llvm::SMLoc::getFromPointer(decl->GetBoundToken().GetRawContentPtr()),
+                        Diag::kErrExpectedConstant);
+            }
+        }
+    }
+}
+
+AstNode* Sema::SemaVariableAccessNode(Token& token) {
     auto name = token.GetContent();
     auto symbol = scope_.FindObjectSymbol(name);
 
@@ -57,22 +102,27 @@ std::shared_ptr<AstNode> Sema::SemaVariableAccessNode(Token& token) {
                 name);
     }
 
-    auto variable_access_node = std::make_shared<VariableAccessExpr>();
-    variable_access_node->SetCType(symbol->GetCType());
+    // NOTE:
+    // The type of a parameter is adjusted after its symbol has been added,
+    // e.g. `int a[]` becomes `int *a`, so prefer the type of the declaration.
+    auto decl = symbol->GetDecl();
+    auto variable_access_node = program_->Create<VariableAccessExpr>();
+    variable_access_node->SetCType(decl ? decl->GetCType() : symbol->GetCType());
     variable_access_node->SetBoundToken(token);
+    variable_access_node->decl_ = decl;
     variable_access_node->SetLValue(true);
 
     return variable_access_node;
 }
 
-std::shared_ptr<AstNode> Sema::SemaBinaryExprNode(
-        std::shared_ptr<AstNode> left, 
-        std::shared_ptr<AstNode> right, 
+AstNode* Sema::SemaBinaryExprNode(
+        AstNode* left, 
+        AstNode* right, 
         BinaryOpCode op) 
 {
     assert(left && right);
 
-    auto expr = std::make_shared<BinaryExpr>();
+    auto expr = program_->Create<BinaryExpr>();
     expr->left_ = left;
     expr->right_ = right;
     expr->op_ = op;
@@ -90,11 +140,31 @@ std::shared_ptr<AstNode> Sema::SemaBinaryExprNode(
         }
     }
 
+    expr->SetConstantValue(ConstEvaluator::Evaluate(expr));
     return expr;
 }
 
-std::shared_ptr<AstNode> Sema::SemaUnaryExprNode(std::shared_ptr<AstNode> sub, UnaryOpCode op, Token &token) {
-    auto node = std::make_shared<UnaryExpr>();
+AstNode* Sema::SemaAssignExprNode(
+        AstNode* left,
+        AstNode* right,
+        BinaryOpCode op,
+        Token& token)
+{
+    if (mode_ == Mode::kNormal && !left->IsLValue()) {
+        diag_engine_.Report(
+            llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+            Diag::kErrLValue);
+    }
+    CheckNotConst(left, token);
+    if (op == BinaryOpCode::kAssign) {
+        CheckConstNotDiscarded(left->GetCType().get(), right, token, "assignment");
+    }
+
+    return SemaBinaryExprNode(left, right, op);
+}
+
+AstNode* Sema::SemaUnaryExprNode(AstNode* sub, UnaryOpCode op, Token &token) {
+    auto node = program_->Create<UnaryExpr>();
     node->op_ = op;
     node->sub_node_ = sub;
 
@@ -119,7 +189,12 @@ std::shared_ptr<AstNode> Sema::SemaUnaryExprNode(std::shared_ptr<AstNode> sub, U
                     llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
                     Diag::kErrExpectedLValue);
             }
-            node->SetCType(std::make_shared<CPointerType>(sub_ctype));
+            if (auto access_node = llvm::dyn_cast<VariableAccessExpr>(sub)) {
+                if (auto decl = llvm::dyn_cast_or_null<VariableDecl>(access_node->decl_)) {
+                    decl->is_address_taken_ = true;
+                }
+            }
+            node->SetCType(type_context_.GetPointerType(sub_ctype));
             break;            
         }
         case UnaryOpCode::kDereference: {
@@ -142,18 +217,20 @@ std::shared_ptr<AstNode> Sema::SemaUnaryExprNode(std::shared_ptr<AstNode> sub, U
                     llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
                     Diag::kErrExpectedLValue);
             }
+            CheckNotConst(sub, token);
             node->SetCType(sub_ctype);
             break;            
         }
     }
 
+    node->SetConstantValue(ConstEvaluator::Evaluate(node));
     return node;
 }
 
-std::shared_ptr<AstNode> Sema::SemaTernaryExprNode(
-    std::shared_ptr<AstNode> cond_node, 
-    std::shared_ptr<AstNode> then_node, 
-    std::shared_ptr<AstNode> els_node,
+AstNode* Sema::SemaTernaryExprNode(
+    AstNode* cond_node, 
+    AstNode* then_node, 
+    AstNode* els_node,
     Token& token)
 {
     if (mode_ == Mode::kNormal && 
@@ -162,56 +239,60 @@ std::shared_ptr<AstNode> Sema::SemaTernaryExprNode(
         diag_engine_.Report(llvm::SMLoc::getFromPointer(token.GetRawContentPtr()), Diag::kErrSameType);
     }
 
-    auto node = std::make_shared<TernaryExpr>();
+    auto node = program_->Create<TernaryExpr>();
     node->cond_ = cond_node;
     node->then_ = then_node;
     node->els_ = els_node;
     node->SetCType(then_node->GetCType());
+    node->SetConstantValue(ConstEvaluator::Evaluate(node));
 
     return node;
 }
 
-std::shared_ptr<AstNode> Sema::SemaSizeofExprNode(
-    std::shared_ptr<AstNode> sub, 
+AstNode* Sema::SemaSizeofExprNode(
+    AstNode* sub, 
     std::shared_ptr<CType> ctype)
 {
-    auto node = std::make_shared<SizeofExpr>();
+    auto node = program_->Create<SizeofExpr>();
     node->sub_ctype_ = ctype;
     node->sub_node_ = sub;
     node->SetCType(CType::kIntType);
+    node->SetConstantValue(ConstEvaluator::Evaluate(node));
     return node;
 }
 
-std::shared_ptr<AstNode> Sema::SemaPostIncExprNode(std::shared_ptr<AstNode> sub, Token& token) {
+AstNode* Sema::SemaPostIncExprNode(AstNode* sub, Token& token) {
     if (mode_ == Mode::kNormal && !sub->IsLValue()) {
         diag_engine_.Report(
             llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
             Diag::kErrExpectedLValue);
     }
+    CheckNotConst(sub, token);
 
-    auto node = std::make_shared<PostIncExpr>();
+    auto node = program_->Create<PostIncExpr>();
     node->sub_node_ = sub;
     node->SetCType(sub->GetCType());
     return node;
 }
 
-std::shared_ptr<AstNode> Sema::SemaPostDecExprNode(std::shared_ptr<AstNode> sub, Token& token) {
+AstNode* Sema::SemaPostDecExprNode(AstNode* sub, Token& token) {
     if (mode_ == Mode::kNormal && !sub->IsLValue()) {
         diag_engine_.Report(
             llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
             Diag::kErrExpectedLValue);
     }
+    CheckNotConst(sub, token);
 
-    auto node = std::make_shared<PostDecExpr>();
+    auto node = program_->Create<PostDecExpr>();
     node->sub_node_ = sub;
     node->SetCType(sub->GetCType());
     return node;
 }
 
-std::shared_ptr<VariableDecl::InitValue> Sema::SemaDeclInitValueStruct(
+VariableDecl::InitValue* Sema::SemaDeclInitValueStruct(
     std::shared_ptr<CType> decl_type, 
-    std::shared_ptr<AstNode> init_node, 
-    std::vector<int> &index_list,
+    AstNode* init_node, 
+    llvm::ArrayRef<int> index_list,
     Token& token)
 {
     /*
@@ -226,17 +307,17 @@ std::shared_ptr<VariableDecl::InitValue> Sema::SemaDeclInitValueStruct(
     }    
     */
 
-    auto init_value_struct = std::make_shared<VariableDecl::InitValue>();
+    auto init_value_struct = program_->Create<VariableDecl::InitValue>();
     init_value_struct->decl_type = decl_type;
     init_value_struct->init_node = init_node;
-    init_value_struct->index_list = index_list;
+    init_value_struct->index_list = program_->CopyArray(index_list);
     return init_value_struct;
 }
 
 // `ar[123]` means `*(ar + 123 * element_size)`
-std::shared_ptr<AstNode> Sema::SemaPostSubscriptExprNode(
-    std::shared_ptr<AstNode> sub_node, 
-    std::shared_ptr<AstNode> index_node,
+AstNode* Sema::SemaPostSubscriptExprNode(
+    AstNode* sub_node, 
+    AstNode* index_node,
     Token& token)
 {
     auto sub_type = sub_node->GetCType()->GetKind();
@@ -263,27 +344,150 @@ std::shared_ptr<AstNode> Sema::SemaPostSubscriptExprNode(
         }
     }
 
-    auto node = std::make_shared<PostSubscriptExpr>();
+    auto node = program_->Create<PostSubscriptExpr>();
     node->sub_node_ = sub_node;
     node->index_node_ = index_node;
     node->SetCType(element_type);
+    node->SetLValue(true);
 
     return node;
 }
 
-std::shared_ptr<AstNode> Sema::SemaNumberExprNode(Token& token, std::shared_ptr<CType> ctype) {
-    auto expr = std::make_shared<NumberExpr>();
+AstNode* Sema::SemaNumberExprNode(Token& token, std::shared_ptr<CType> ctype) {
+    auto expr = program_->Create<NumberExpr>();
     expr->SetCType(ctype);
     expr->SetBoundToken(token);
+    expr->SetConstantValue(ConstEvaluator::Evaluate(expr));
     return expr;
 }
 
-std::shared_ptr<AstNode> Sema::SemaIfStmtNode(
-        std::shared_ptr<AstNode> cond_node, 
-        std::shared_ptr<AstNode> then_node, 
-        std::shared_ptr<AstNode> else_node)
+std::shared_ptr<CType> Sema::SemaConstType(std::shared_ptr<CType> ctype, Token& token) {
+    auto kind = ctype->GetKind();
+    if (kind != CType::TypeKind::kInt && 
+        kind != CType::TypeKind::kVoid && 
+        kind != CType::TypeKind::kPointer) 
+    {
+        if (mode_ == Mode::kNormal) {
+            diag_engine_.Report(
+                llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+                Diag::kErrConstType);
+        }
+        return ctype;
+    }
+    return type_context_.GetConstType(ctype);
+}
+
+std::shared_ptr<CType> Sema::SemaRestrictType(std::shared_ptr<CType> ctype, Token& token) {
+    if (ctype->GetKind() != CType::TypeKind::kPointer) {
+        if (mode_ == Mode::kNormal) {
+            diag_engine_.Report(
+                llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+                Diag::kErrRestrictType);
+        }
+        return ctype;
+    }
+    return type_context_.GetRestrictType(ctype);
+}
+
+void Sema::SemaArrayParamDecay(AstNode* param, bool is_static, bool is_const, bool is_restrict) {
+    auto array_type = llvm::cast<CArrayType>(param->GetCType().get());
+    auto pointer_type = type_context_.GetPointerType(array_type->GetElementType());
+    pointer_type = type_context_.GetQualifiedType(pointer_type, is_const, is_restrict);
+    param->SetCType(pointer_type);
+
+    if (is_static) {
+        llvm::cast<VariableDecl>(param)->static_array_size_ = array_type->GetElementCount();
+    }
+}
+
+void Sema::SemaFuncAttrs(std::shared_ptr<CType> ctype, llvm::ArrayRef<Token> attr_tokens) {
+    if (mode_ != Mode::kNormal || attr_tokens.empty()) {
+        return;
+    }
+
+    auto func_type = llvm::dyn_cast<CFuncType>(ctype.get());
+    for (const Token& token : attr_tokens) {
+        llvm::StringRef name = token.GetContent();
+        if (name.size() > 4 && name.take_front(2) == "__" && name.take_back(2) == "__") {
+            name = name.drop_front(2).drop_back(2);
+        }
+
+        // 1. Find the attribute by its name.
+        int attr = 0;
+        while (attr < static_cast<int>(FuncAttr::kCount) &&
+               CFuncType::GetAttrName(static_cast<FuncAttr>(attr)) != name) 
+        {
+            ++attr;
+        }
+        if (attr == static_cast<int>(FuncAttr::kCount)) {
+            diag_engine_.Report(
+                llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+                Diag::kWarnUnknownAttr,
+                token.GetContent());
+            continue;
+        }
+
+        // 2. Only the functions have attributes for now.
+        if (!func_type) {
+            diag_engine_.Report(
+                llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+                Diag::kErrAttrNotFunc,
+                name);
+            continue;
+        }
+        func_type->AddAttr(static_cast<FuncAttr>(attr));
+    }
+
+    // 3. Check the conflicts in this declaration. The ones between the
+    //    declarations of a function are checked by `SemaFuncDecl`.
+    if (func_type) {
+        CheckFuncAttrConflicts(func_type, attr_tokens.back());
+    }
+}
+
+void Sema::CheckFuncAttrConflicts(CFuncType* func_type, const Token& token) {
+    static const std::pair<FuncAttr, FuncAttr> kConflicts[] = {
+        { FuncAttr::kAlwaysInline, FuncAttr::kNoInline },
+        { FuncAttr::kAlwaysInline, FuncAttr::kOptNone },
+        { FuncAttr::kHot, FuncAttr::kCold },
+    };
+    for (auto [a, b] : kConflicts) {
+        if (func_type->HasAttr(a) && func_type->HasAttr(b)) {
+            diag_engine_.Report(
+                llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+                Diag::kErrAttrConflict,
+                CFuncType::GetAttrName(a),
+                CFuncType::GetAttrName(b));
+        }
+    }
+}
+
+int Sema::SemaArraySize(AstNode* size_node, Token& token) {
+    auto size = size_node->GetConstantValue();
+
+    if (mode_ == Mode::kNormal && !size) {
+        diag_engine_.Report(
+            llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+            Diag::kErrExpectedConstant);
+    }
+
+    if (mode_ == Mode::kNormal && size && *size < 0) {
+        diag_engine_.Report(
+            llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+            Diag::kErrNegativeArraySize,
+            *size);
+    }
+
+    // NOTE: -1 means the size is unknown, like `int ar[] = { 1, 2, 3 };`.
+    return size.value_or(-1);
+}
+
+AstNode* Sema::SemaIfStmtNode(
+        AstNode* cond_node, 
+        AstNode* then_node, 
+        AstNode* else_node)
 {
-    auto node = std::make_shared<IfStmt>();
+    auto node = program_->Create<IfStmt>();
     node->cond_node_ = cond_node;
     node->then_node_ = then_node;
     node->else_node_ = else_node;
@@ -291,6 +495,164 @@ std::shared_ptr<AstNode> Sema::SemaIfStmtNode(
     return node;
 }
 
+CaseStmt* Sema::SemaCaseStmtNode(AstNode* value_node, Token& token) {
+    if (mode_ == Mode::kNormal && value_node && !value_node->GetConstantValue()) {
+        diag_engine_.Report(
+            llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+            Diag::kErrExpectedConstant);
+    }
+
+    auto node = program_->Create<CaseStmt>();
+    node->value_node_ = value_node;
+    node->SetBoundToken(token);
+    return node;
+}
+
+AstNode* Sema::SemaSwitchStmtNode(
+        SwitchStmt* switch_node,
+        AstNode* cond_node,
+        AstNode* body_node,
+        llvm::ArrayRef<AstNode*> case_nodes,
+        Token& token)
+{
+    if (mode_ == Mode::kNormal && cond_node->GetCType()->GetKind() != CType::TypeKind::kInt) {
+        diag_engine_.Report(
+            llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+            Diag::kErrExpectedType,
+            "int type");
+    }
+
+    // Each value can only be used by one `case` label,
+    // and there is at most one `default` label.
+    if (mode_ == Mode::kNormal) {
+        llvm::DenseSet<int> values;
+        bool has_default = false;
+        for (auto node : case_nodes) {
+            auto case_node = llvm::cast<CaseStmt>(node);
+            auto loc = llvm::SMLoc::getFromPointer(case_node->GetBoundToken().GetRawContentPtr());
+            if (!case_node->value_node_) {
+                if (has_default) {
+                    diag_engine_.Report(loc, Diag::kErrMultipleDefault);
+                }
+                has_default = true;
+                continue;
+            }
+            int value = *case_node->value_node_->GetConstantValue();
+            if (!values.insert(value).second) {
+                diag_engine_.Report(loc, Diag::kErrDuplicateCase, value);
+            }
+        }
+    }
+
+    switch_node->cond_node_ = cond_node;
+    switch_node->body_node_ = body_node;
+    switch_node->case_nodes_ = program_->CopyArray(case_nodes);
+
+    return switch_node;
+}
+
+void Sema::CheckNotConst(AstNode* node, Token& token) {
+    // NOTE:
+    // An element of a const array, or a member declared const,
+    // has a const type too, so it's enough to check the type of `node`.
+    if (mode_ == Mode::kNormal && node->GetCType()->IsConst()) {
+        diag_engine_.Report(
+            llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+            Diag::kErrAssignConst);
+    }
+}
+
+// Return the type pointed to by `ctype`, including the element type of
+// an array, which decays to a pointer.
+static CType* GetPointeeType(CType* ctype) {
+    if (auto pointer_type = llvm::dyn_cast<CPointerType>(ctype)) {
+        return pointer_type->GetBaseType().get();
+    }
+    if (auto array_type = llvm::dyn_cast<CArrayType>(ctype)) {
+        return array_type->GetElementType().get();
+    }
+    return nullptr;
+}
+
+void Sema::CheckConstNotDiscarded(
+    CType* dest_type, 
+    AstNode* value, 
+    const Token& token, 
+    llvm::StringRef action) 
+{
+    if (mode_ != Mode::kNormal || !dest_type || !value) {
+        return;
+    }
+    auto dest_pointee_type = GetPointeeType(dest_type);
+    auto src_pointee_type = GetPointeeType(value->GetCType().get());
+    if (dest_pointee_type && src_pointee_type && 
+        src_pointee_type->IsConst() && !dest_pointee_type->IsConst()) 
+    {
+        diag_engine_.Report(
+            llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+            Diag::kErrDiscardConst,
+            action);
+    }
+}
+
+LabelStmt* Sema::GetLabel(Token& token) {
+    auto [iter, inserted] = labels_.try_emplace(token.GetContent());
+    auto& info = iter->getValue();
+    if (inserted) {
+        info.label_node = program_->Create<LabelStmt>();
+        info.label_node->SetBoundToken(token);
+        info.first_use = token;
+        info.is_defined = false;
+    }
+    return info.label_node;
+}
+
+LabelStmt* Sema::SemaLabelStmtNode(Token& token) {
+    auto label_node = GetLabel(token);
+    auto& info = labels_[token.GetContent()];
+    if (mode_ == Mode::kNormal && info.is_defined) {
+        diag_engine_.Report(
+            llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+            Diag::kErrRedefined,
+            token.GetContent());
+    }
+    info.is_defined = true;
+
+    // The label is bound to its definition, rather than its first use.
+    label_node->SetBoundToken(token);
+    return label_node;
+}
+
+AstNode* Sema::SemaGotoStmtNode(Token& token) {
+    auto node = program_->Create<GotoStmt>();
+    node->target_ = GetLabel(token);
+    return node;
+}
+
+AstNode* Sema::SemaIndirectGotoStmtNode(AstNode* target_node, Token& token) {
+    if (mode_ == Mode::kNormal && target_node->GetCType()->GetKind() != CType::TypeKind::kPointer) {
+        diag_engine_.Report(
+            llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+            Diag::kErrExpectedType,
+            "pointer type");
+    }
+
+    auto node = program_->Create<IndirectGotoStmt>();
+    node->target_node_ = target_node;
+    return node;
+}
+
+AstNode* Sema::SemaAddrLabelExprNode(Token& token) {
+    auto label_node = GetLabel(token);
+    label_node->is_address_taken_ = true;
+
+    auto node = program_->Create<AddrLabelExpr>();
+    node->target_ = label_node;
+    node->SetBoundToken(token);
+    node->SetCType(type_context_.GetPointerType(CType::kVoidType));
+    return node;
+}
+
 std::shared_ptr<CType> Sema::SemaTagDecl(Token& token, CType::TagKind tag_kind) {
     auto name = token.GetContent();
     auto symbol = scope_.FindTagSymbolInCurrentEnv(name);
@@ -335,8 +697,8 @@ std::shared_ptr<CType> Sema::SemaTagAccess(Token &token) {
     return symbol ? symbol->GetCType() : nullptr;
 }
 
-std::shared_ptr<AstNode> Sema::SemaPostMemberDotExprNode(
-    std::shared_ptr<AstNode> struct_node,
+AstNode* Sema::SemaPostMemberDotExprNode(
+    AstNode* struct_node,
     Token& op_token,
     Token& member_token)
 {
@@ -349,14 +711,8 @@ std::shared_ptr<AstNode> Sema::SemaPostMemberDotExprNode(
                 "struct or union type");
     }
 
-    const CRecordType::Member* target_member = nullptr;
     CRecordType* record_type = llvm::dyn_cast<CRecordType>(struct_node->GetCType().get());
-    for (const auto& member : record_type->GetMembers()) {
-        if (member.name == member_token.GetContent()) {
-            target_member = &member;
-            break;
-        }
-    }
+    auto target_member = record_type->FindMember(member_token.GetContent());
 
     if (mode_ == Mode::kNormal && !target_member) {
         diag_engine_.Report(
@@ -365,7 +721,7 @@ std::shared_ptr<AstNode> Sema::SemaPostMemberDotExprNode(
                 "struct or union member");
     }
 
-    auto node = std::make_shared<PostMemberDotExpr>();
+    auto node = program_->Create<PostMemberDotExpr>();
     node->struct_node_ = struct_node;
     node->target_member_ = *target_member;
     node->SetCType(target_member->type);
@@ -375,8 +731,8 @@ std::shared_ptr<AstNode> Sema::SemaPostMemberDotExprNode(
     return node;
 }
 
-std::shared_ptr<AstNode> Sema::SemaPostMemberArrowExprNode(
-    std::shared_ptr<AstNode> struct_pointer_node, 
+AstNode* Sema::SemaPostMemberArrowExprNode(
+    AstNode* struct_pointer_node, 
     Token& op_token,
     Token& member_token)
 {
@@ -400,14 +756,8 @@ std::shared_ptr<AstNode> Sema::SemaPostMemberArrowExprNode(
                 "struct or union pointer type");
     }
 
-    const CRecordType::Member* target_member = nullptr;
     CRecordType* record_type = llvm::dyn_cast<CRecordType>(pointer_base_type.get());
-    for (const auto& member : record_type->GetMembers()) {
-        if (member.name == member_token.GetContent()) {
-            target_member = &member;
-            break;
-        }
-    }
+    auto target_member = record_type->FindMember(member_token.GetContent());
 
     if (mode_ == Mode::kNormal && !target_member) {
         diag_engine_.Report(
@@ -416,7 +766,7 @@ std::shared_ptr<AstNode> Sema::SemaPostMemberArrowExprNode(
                 "struct or union member");
     }
 
-    auto node = std::make_shared<PostMemberArrowExpr>();
+    auto node = program_->Create<PostMemberArrowExpr>();
     node->struct_pointer_node_ = struct_pointer_node;
     node->target_member_ = *target_member;
     node->SetCType(target_member->type);
@@ -426,16 +776,38 @@ std::shared_ptr<AstNode> Sema::SemaPostMemberArrowExprNode(
     return node;
 }
 
-std::shared_ptr<AstNode> Sema::SemaFuncDecl(
+AstNode* Sema::SemaFuncDecl(
     const Token &token, 
     std::shared_ptr<CType> func_type, 
-    std::shared_ptr<AstNode> block_stmt)
+    llvm::ArrayRef<AstNode*> params,
+    AstNode* block_stmt,
+    StorageClass storage_class,
+    bool is_inline)
 {
     auto func_raw_type = llvm::dyn_cast<CFuncType>(func_type.get());
-    func_raw_type->has_body_ = block_stmt != nullptr;
+    bool has_body = block_stmt != nullptr;
+
+    // The labels only live in the function body, so each of them should
+    // have been defined by now. Report the first undefined one in the source.
+    const Token* undefined_label_use = nullptr;
+    for (const auto& entry : labels_) {
+        const auto& info = entry.getValue();
+        if (!info.is_defined && (!undefined_label_use ||
+            info.first_use.GetRawContentPtr() < undefined_label_use->GetRawContentPtr()))
+        {
+            undefined_label_use = &info.first_use;
+        }
+    }
+    if (mode_ == Mode::kNormal && undefined_label_use) {
+        diag_engine_.Report(
+                llvm::SMLoc::getFromPointer(undefined_label_use->GetRawContentPtr()),
+                Diag::kErrUndefinedLabel,
+                undefined_label_use->GetContent());
+    }
+    labels_.clear();
 
     llvm::StringRef func_name = token.GetContent();
-    std::shared_ptr<Symbol> func_symbol = scope_.FindObjectSymbolInCurrentEnv(func_name);
+    Symbol* func_symbol = scope_.FindObjectSymbolInCurrentEnv(func_name);
 
     // Case 1. We have already meet the symbol `func_symbol`.
     if (mode_ == Mode::kNormal && func_symbol) {
@@ -454,33 +826,66 @@ std::shared_ptr<AstNode> Sema::SemaFuncDecl(
         auto symbol_raw_type = llvm::dyn_cast<CFuncType>(symbol_type.get());
         if (mode_ == Mode::kNormal && 
             symbol_raw_type->has_body_ && 
-            func_raw_type->has_body_) 
+            has_body) 
         {
             diag_engine_.Report(
                     llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
                     Diag::kErrRedefined,
                     func_name);
         }
+        // Case 1.3. The function keeps the storage class of its first declaration,
+        //           and it's inline if any of its declarations says so.
+        auto prev_decl = llvm::dyn_cast_or_null<FuncDecl>(func_symbol->GetDecl());
+        if (prev_decl) {
+            if (prev_decl->storage_class_ != StorageClass::kStatic && 
+                storage_class == StorageClass::kStatic)
+            {
+                diag_engine_.Report(
+                        llvm::SMLoc::getFromPointer(token.GetRawContentPtr()),
+                        Diag::kErrStaticFollowsNonStatic,
+                        func_name);
+            }
+            storage_class = prev_decl->storage_class_;
+            is_inline = is_inline || prev_decl->is_inline_;
+        }
+        // Case 1.4. The attributes accumulate over the declarations. Note that
+        //           the declarations have different types if the names of
+        //           their parameters differ.
+        if (symbol_raw_type != func_raw_type) {
+            func_raw_type->attrs_ |= symbol_raw_type->attrs_;
+            symbol_raw_type->attrs_ = func_raw_type->attrs_;
+            CheckFuncAttrConflicts(func_raw_type, token);
+        }
+    }
+
+    // NOTE:
+    // The function type is shared by the declarations with the same signature,
+    // so it should never go back to having no body.
+    if (has_body) {
+        func_raw_type->has_body_ = true;
     }
 
     // Case 2. We haven't meet the symbol `func_symbol` before,
     //         or the body of the function bound with symbol `func_symbol` 
     //         hasn't been defined.
-    if (mode_ == Mode::kNormal) {
-        scope_.AddObjectSymbol(func_name, func_type);
-    }
-
-    auto func_decl_node = std::make_shared<FuncDecl>();
+    auto func_decl_node = program_->Create<FuncDecl>();
     func_decl_node->block_stmt_ = block_stmt;
+    func_decl_node->params_ = program_->CopyArray(params);
+    func_decl_node->storage_class_ = storage_class;
+    func_decl_node->is_inline_ = is_inline;
     func_decl_node->SetCType(func_type);
     func_decl_node->SetBoundToken(token);
 
+    if (mode_ == Mode::kNormal) {
+        scope_.AddObjectSymbol(func_name, func_type, func_decl_node);
+    }
+
     return func_decl_node;
 }
 
-std::shared_ptr<AstNode> Sema::SemaPostFuncCallExprNode(
-    std::shared_ptr<AstNode> func_node, 
-    const std::vector<std::shared_ptr<AstNode>> &arg_nodes)
+AstNode* Sema::SemaPostFuncCallExprNode(
+    AstNode* func_node, 
+    llvm::ArrayRef<AstNode*> arg_nodes)
 {
     const Token& tok = func_node->GetBoundToken();
     
@@ -505,7 +910,12 @@ std::shared_ptr<AstNode> Sema::SemaPostFuncCallExprNode(
                             "argument count not match");
     }
 
-    // Check 3: Whether user provide argument with mismatched type.
+    // Check 3: A pointer to const can't be passed as a pointer to non-const.
+    for (size_t i = 0; i < func_params.size() && i < arg_nodes.size(); ++i) {
+        CheckConstNotDiscarded(func_params[i].type.get(), arg_nodes[i], tok, "passing an argument");
+    }
+
+    // Check 4: Whether user provide argument with mismatched type.
     /*
     for (int i = 0; i < func_params.size(); ++i) {
         if (mode_ == Mode::kNormal && 
@@ -520,12 +930,23 @@ std::shared_ptr<AstNode> Sema::SemaPostFuncCallExprNode(
     */
 
 
-    auto func_call_node = std::make_shared<PostFuncCallExpr>();
+    auto func_call_node = program_->Create<PostFuncCallExpr>();
     func_call_node->func_node_ = func_node;
-    func_call_node->arg_nodes_ = arg_nodes;
+    func_call_node->arg_nodes_ = program_->CopyArray(arg_nodes);
     func_call_node->SetBoundToken(func_node->GetBoundToken());
 
     func_call_node->SetCType(func_type->GetRetType());
 
     return func_call_node;
 }
+
+AstNode* Sema::SemaReturnStmt(AstNode* ret_value_expr, Token& token) {
+    if (auto func_type = llvm::dyn_cast_or_null<CFuncType>(current_func_type_.get())) {
+        CheckConstNotDiscarded(func_type->GetRetType().get(), ret_value_expr, token, "return");
+    }
+
+    auto ret_stmt_node = program_->Create<ReturnStmt>();
+    ret_stmt_node->value_node_ = ret_value_expr;
+
+    return ret_stmt_node;
+}
@@ -7,6 +7,8 @@
 
 #include <memory>
 
+#include "llvm/ADT/StringMap.h"
+
 #include "scope.h"
 #include "ast.h"
 #include "diag-engine.h"
@@ -21,86 +23,185 @@ class Sema {
  private:
     Mode mode_;
     Scope scope_;
+    TypeContext type_context_;
     DiagEngine& diag_engine_;
 
+    // The program which owns the AST nodes created by us.
+    Program* program_ { nullptr };
+
+    // The function whose body is being parsed, to check its `return`s.
+    std::shared_ptr<CType> current_func_type_;
+
+    // The labels of the current function. A label can be used before it's
+    // defined, so it's created by the first `goto` or `&&` using it.
+    struct LabelInfo {
+        LabelStmt* label_node;
+        // Where the label is used first, to report an undefined label.
+        Token first_use;
+        bool is_defined;
+    };
+    llvm::StringMap<LabelInfo> labels_;
+
+    LabelStmt* GetLabel(Token& token);
+
+    // Report an error if `node`, which is going to be written, is const.
+    void CheckNotConst(AstNode* node, Token& token);
+    // Report an error if converting `value` to `dest_type` makes a pointer to
+    // const point to non-const, e.g. `int* p = &c;` where `c` is `const int`.
+    // `action` says where the conversion happens, e.g. "assignment".
+    void CheckConstNotDiscarded(CType* dest_type, AstNode* value, const Token& token, llvm::StringRef action);
+    // Report each pair of attributes of `func_type` which can't be used together.
+    void CheckFuncAttrConflicts(CFuncType* func_type, const Token& token);
+
  public:
     explicit Sema(DiagEngine& diag_engine) : diag_engine_(diag_engine), mode_(Mode::kNormal) {}
 
     void EnterScope();
     void ExitScope();
 
+    Scope& GetScope() {
+        return scope_;
+    }
+
+    TypeContext& GetTypeContext() {
+        return type_context_;
+    }
+
     void SetMode(Mode mode);
 
-    std::shared_ptr<AstNode> SemaVariableDeclNode(Token& token, std::shared_ptr<CType> ctype, bool is_global);
+    void SetProgram(Program* program) {
+        program_ = program;
+    }
+
+    void SetCurrentFuncType(std::shared_ptr<CType> func_type) {
+        current_func_type_ = func_type;
+    }
+
+    AstNode* SemaVariableDeclNode(Token& token, std::shared_ptr<CType> ctype, bool is_global);
+
+    // Apply the specifiers of a declaration to the variable `decl_node`,
+    // after its initializer has been parsed.
+    void SemaVariableDeclSpec(
+                                    AstNode* decl_node,
+                                    StorageClass storage_class,
+                                    bool is_inline,
+                                    Token& inline_token);
 
-    std::shared_ptr<AstNode> SemaVariableAccessNode(Token& token);
+    AstNode* SemaVariableAccessNode(Token& token);
 
-    std::shared_ptr<AstNode> SemaBinaryExprNode(
-                                    std::shared_ptr<AstNode> left, 
-                                    std::shared_ptr<AstNode> right, 
+    AstNode* SemaBinaryExprNode(
+                                    AstNode* left, 
+                                    AstNode* right, 
                                     BinaryOpCode op);
 
-    std::shared_ptr<AstNode> SemaUnaryExprNode(
-                                    std::shared_ptr<AstNode> sub, 
+    // `=` and the compound assignments, the left side of which
+    // must be a modifiable lvalue.
+    AstNode* SemaAssignExprNode(
+                                    AstNode* left,
+                                    AstNode* right,
+                                    BinaryOpCode op,
+                                    Token& token);
+
+    AstNode* SemaUnaryExprNode(
+                                    AstNode* sub, 
                                     UnaryOpCode op,
                                     Token& token);
 
-    std::shared_ptr<AstNode> SemaTernaryExprNode(
-                                    std::shared_ptr<AstNode> cond,
-                                    std::shared_ptr<AstNode> then,
-                                    std::shared_ptr<AstNode> els,
+    AstNode* SemaTernaryExprNode(
+                                    AstNode* cond,
+                                    AstNode* then,
+                                    AstNode* els,
                                     Token& token);
 
-    std::shared_ptr<AstNode> SemaSizeofExprNode(
-                                    std::shared_ptr<AstNode> sub, 
+    AstNode* SemaSizeofExprNode(
+                                    AstNode* sub, 
                                     std::shared_ptr<CType> ctype);
 
-    std::shared_ptr<AstNode> SemaPostIncExprNode(std::shared_ptr<AstNode> sub, Token& token);
+    AstNode* SemaPostIncExprNode(AstNode* sub, Token& token);
 
-    std::shared_ptr<AstNode> SemaPostDecExprNode(std::shared_ptr<AstNode> sub, Token& token);
+    AstNode* SemaPostDecExprNode(AstNode* sub, Token& token);
 
-    std::shared_ptr<VariableDecl::InitValue> SemaDeclInitValueStruct(
+    VariableDecl::InitValue* SemaDeclInitValueStruct(
                                                    std::shared_ptr<CType> decl_type,
-                                                   std::shared_ptr<AstNode> init_node,
-                                                   std::vector<int>& index_list,
+                                                   AstNode* init_node,
+                                                   llvm::ArrayRef<int> index_list,
                                                    Token& token);
 
-    std::shared_ptr<AstNode> SemaPostSubscriptExprNode(
-                                       std::shared_ptr<AstNode> sub_node,
-                                       std::shared_ptr<AstNode> index_node,
+    AstNode* SemaPostSubscriptExprNode(
+                                       AstNode* sub_node,
+                                       AstNode* index_node,
                                        Token& token);
 
-    std::shared_ptr<AstNode> SemaNumberExprNode(Token& token, std::shared_ptr<CType> ctype);
+    AstNode* SemaNumberExprNode(Token& token, std::shared_ptr<CType> ctype);
+
+    // Return the const version of `ctype`, which must be a scalar type.
+    std::shared_ptr<CType> SemaConstType(std::shared_ptr<CType> ctype, Token& token);
+    // Return the restrict version of `ctype`, which must be a pointer type.
+    std::shared_ptr<CType> SemaRestrictType(std::shared_ptr<CType> ctype, Token& token);
+
+    // Decay the array parameter `param` to a pointer with the qualifiers in its
+    // outermost `[]`. For `int a[static 3]`, the argument must point to at least
+    // 3 elements, which is recorded in the declaration.
+    void SemaArrayParamDecay(AstNode* param, bool is_static, bool is_const, bool is_restrict);
+
+    // Add the attributes named by `attr_tokens` to `ctype`, which must be a
+    // function type. Both `noinline` and `__noinline__` are accepted.
+    void SemaFuncAttrs(std::shared_ptr<CType> ctype, llvm::ArrayRef<Token> attr_tokens);
+
+    // Return the element count of an array, which must be given by
+    // an integer constant expression, e.g. `int ar[2 * N + 1]`.
+    int SemaArraySize(AstNode* size_node, Token& token);
+
+    AstNode* SemaIfStmtNode(
+                                    AstNode* cond_node, 
+                                    AstNode* then_node,
+                                    AstNode* else_node);
+
+    // The value of a `case` label must be an integer constant expression,
+    // and `value_node` is `nullptr` for the `default` label.
+    CaseStmt* SemaCaseStmtNode(AstNode* value_node, Token& token);
+
+    // Check the condition and the labels of a switch statement,
+    // after all the labels in its body have been parsed.
+    AstNode* SemaSwitchStmtNode(
+                                    SwitchStmt* switch_node,
+                                    AstNode* cond_node,
+                                    AstNode* body_node,
+                                    llvm::ArrayRef<AstNode*> case_nodes,
+                                    Token& token);
 
-    std::shared_ptr<AstNode> SemaIfStmtNode(
-                                    std::shared_ptr<AstNode> cond_node, 
-                                    std::shared_ptr<AstNode> then_node,
-                                    std::shared_ptr<AstNode> else_node);
+    LabelStmt* SemaLabelStmtNode(Token& token);
+    AstNode* SemaGotoStmtNode(Token& token);
+    AstNode* SemaIndirectGotoStmtNode(AstNode* target_node, Token& token);
+    AstNode* SemaAddrLabelExprNode(Token& token);
 
     std::shared_ptr<CType> SemaTagDecl(Token& token, CType::TagKind tag_kind);
     std::shared_ptr<CType> SemaTagAnonymousDecl(CType::TagKind tag_kind); 
 
     std::shared_ptr<CType> SemaTagAccess(Token& token);
 
-    std::shared_ptr<AstNode> SemaPostMemberDotExprNode(
-                                       std::shared_ptr<AstNode> struct_node, 
+    AstNode* SemaPostMemberDotExprNode(
+                                       AstNode* struct_node, 
                                        Token& op_token, 
                                        Token& token);
-    std::shared_ptr<AstNode> SemaPostMemberArrowExprNode(
-                                       std::shared_ptr<AstNode> struct_node,
+    AstNode* SemaPostMemberArrowExprNode(
+                                       AstNode* struct_node,
                                        Token& op_token, 
                                        Token& token);
 
-    std::shared_ptr<AstNode> SemaFuncDecl(
+    AstNode* SemaFuncDecl(
                                     const Token& token, 
                                     std::shared_ptr<CType> func_type,
-                                    std::shared_ptr<AstNode> block_stmt);
+                                    llvm::ArrayRef<AstNode*> params,
+                                    AstNode* block_stmt,
+                                    StorageClass storage_class,
+                                    bool is_inline);
 
-    std::shared_ptr<AstNode> SemaPostFuncCallExprNode(
-                                    std::shared_ptr<AstNode> func_node, 
-                                    const std::vector<std::shared_ptr<AstNode>>& arg_nodes);
+    AstNode* SemaPostFuncCallExprNode(
+                                    AstNode* func_node, 
+                                    llvm::ArrayRef<AstNode*> arg_nodes);
 
-    std::shared_ptr<AstNode> SemaReturnStmt(std::shared_ptr<AstNode> ret_value_expr);
+    AstNode* SemaReturnStmt(AstNode* ret_value_expr, Token& token);
 };
 
 #endif  // SEMA_H_
@@ -0,0 +1,32 @@
+// Multiply two matrices, which is a benchmark of the nested subscripts.
+int a[64][64];
+int b[64][64];
+int c[64][64];
+
+int main() {
+    int n = 64;
+    int i, j, k;
+    for (i = 0; i < n; ++i) {
+        for (j = 0; j < n; ++j) {
+            a[i][j] = i + j;
+            b[i][j] = i - j;
+            c[i][j] = 0;
+        }
+    }
+
+    for (i = 0; i < n; ++i) {
+        for (k = 0; k < n; ++k) {
+            for (j = 0; j < n; ++j) {
+                c[i][j] += a[i][k] * b[k][j];
+            }
+        }
+    }
+
+    int sum = 0;
+    for (i = 0; i < n; ++i) {
+        for (j = 0; j < n; ++j) {
+            sum += c[i][j] * (i + 1) - c[j][i] * j;
+        }
+    }
+    return sum;
+}
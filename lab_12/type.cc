@@ -4,6 +4,11 @@
 
 #include "type.h"
 
+#include <algorithm>
+#include <cassert>
+
+#include "llvm/Support/Casting.h"
+
 std::shared_ptr<CType> const CType::kIntType = std::make_shared<CPrimaryType>(TypeKind::kInt, 4, 4);
 std::shared_ptr<CType> const CType::kVoidType = std::make_shared<CPrimaryType>(TypeKind::kVoid, 0, 0);
 
@@ -37,6 +42,12 @@ CRecordType::CRecordType(llvm::StringRef name, TagKind tag_kind)
 void CRecordType::SetMembers(std::vector<Member>&& members) {
     this->members_ = std::move(members);
     ComputeMemberOffsets();
+
+    member_index_.clear();
+    for (const auto& member : members_) {
+        // NOTE: The first one wins if the name is duplicated.
+        member_index_.try_emplace(member.name, member.rank);
+    }
 }
 
 static int RoundUp(size_t base_addr, size_t align) {
@@ -68,6 +79,7 @@ void CRecordType::ComputeStructMemberOffsets() {
         offset = RoundUp(offset, member_algin);
         member.offset = offset;
         member.rank = rank++;
+        member.gep_index = member.rank;
         // Record the largest member's algin, 
         // as algin of the entire structure.
         max_element_align = std::max(max_element_align, member_algin);
@@ -97,6 +109,7 @@ void CRecordType::ComputeUnionMemberOffsets() {
 
         member.offset = 0;
         member.rank = rank++;
+        member.gep_index = 0;
 
         max_element_align = std::max(max_element_align, member_algin);
 
@@ -110,3 +123,116 @@ void CRecordType::ComputeUnionMemberOffsets() {
     size_ = RoundUp(max_element_size, max_element_align);
     align_ = max_element_align;
 }
+
+std::shared_ptr<CType> TypeContext::GetPointerType(std::shared_ptr<CType> base_type) {
+    auto& pointer_type = pointer_types_[base_type.get()];
+    if (!pointer_type) {
+        pointer_type = std::make_shared<CPointerType>(base_type);
+    }
+    return pointer_type;
+}
+
+std::shared_ptr<CType> TypeContext::GetArrayType(std::shared_ptr<CType> element_type, int element_count) {
+    if (element_count < 0) {
+        return std::make_shared<CArrayType>(element_type, element_count);
+    }
+
+    auto& array_type = array_types_[{ element_type.get(), element_count }];
+    if (!array_type) {
+        array_type = std::make_shared<CArrayType>(element_type, element_count);
+    }
+    return array_type;
+}
+
+std::shared_ptr<CType> TypeContext::GetQualifiedType(
+    std::shared_ptr<CType> type, 
+    bool is_const, 
+    bool is_restrict) 
+{
+    if (type->IsConst() == is_const && type->IsRestrict() == is_restrict) {
+        return type;
+    }
+
+    std::shared_ptr<CType> unqualified_type;
+    switch (type->GetKind()) {
+        case CType::TypeKind::kInt:
+            unqualified_type = CType::kIntType;
+            break;
+        case CType::TypeKind::kVoid:
+            unqualified_type = CType::kVoidType;
+            break;
+        case CType::TypeKind::kPointer:
+            unqualified_type = GetPointerType(llvm::cast<CPointerType>(type.get())->GetBaseType());
+            break;
+        default:
+            llvm_unreachable("only a scalar type can be qualified");
+    }
+    assert((!is_restrict || type->GetKind() == CType::TypeKind::kPointer) && 
+           "only a pointer can be restrict");
+    if (!is_const && !is_restrict) {
+        return unqualified_type;
+    }
+
+    auto& qualified_type = qualified_types_[{ unqualified_type.get(), is_const | is_restrict << 1 }];
+    if (!qualified_type) {
+        if (type->GetKind() == CType::TypeKind::kPointer) {
+            qualified_type = std::make_shared<CPointerType>(llvm::cast<CPointerType>(type.get())->GetBaseType());
+        } else {
+            qualified_type = std::make_shared<CPrimaryType>(type->GetKind(), type->GetSize(), type->GetAlign());
+        }
+        qualified_type->is_const_ = is_const;
+        qualified_type->is_restrict_ = is_restrict;
+    }
+    return qualified_type;
+}
+
+llvm::StringRef CFuncType::GetAttrName(FuncAttr attr) {
+    switch (attr) {
+        case FuncAttr::kAlwaysInline:
+            return "always_inline";
+        case FuncAttr::kNoInline:
+            return "noinline";
+        case FuncAttr::kHot:
+            return "hot";
+        case FuncAttr::kCold:
+            return "cold";
+        case FuncAttr::kPure:
+            return "pure";
+        case FuncAttr::kConst:
+            return "const";
+        case FuncAttr::kNoReturn:
+            return "noreturn";
+        case FuncAttr::kFlatten:
+            return "flatten";
+        case FuncAttr::kOptNone:
+            return "optnone";
+        default:
+            llvm_unreachable("unknown function attribute");
+    }
+}
+
+std::shared_ptr<CType> TypeContext::GetFuncType(
+    llvm::StringRef func_name,
+    std::shared_ptr<CType> ret_type,
+    std::vector<CFuncType::Param>&& params)
+{
+    auto& candidates = func_types_[func_name];
+    for (const auto& candidate : candidates) {
+        auto func_type = llvm::cast<CFuncType>(candidate.get());
+        if (func_type->GetRetType() != ret_type) {
+            continue;
+        }
+        const auto& candidate_params = func_type->GetParams();
+        auto is_same_param = [](const CFuncType::Param& a, const CFuncType::Param& b) {
+            return a.type == b.type && a.name == b.name;
+        };
+        if (std::equal(candidate_params.begin(), candidate_params.end(),
+                       params.begin(), params.end(), is_same_param)) {
+            return candidate;
+        }
+    }
+
+    auto func_type = std::make_shared<CFuncType>(func_name, ret_type, std::move(params));
+    candidates.push_back(func_type);
+    return func_type;
+}
@@ -5,10 +5,16 @@
 #ifndef TYPE_H_
 #define TYPE_H_
 
+#include <cstdint>
 #include <cstdlib>
 #include <memory>
+#include <utility>
+#include <vector>
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/IR/Type.h"
+#include "llvm/Support/ErrorHandling.h"
 
 class CType;
 class CPrimaryType;
@@ -17,17 +23,6 @@ class CArrayType;
 class CRecordType;
 class CFuncType;
 
-class TypeVisitor {
- public:
-    virtual ~TypeVisitor() {}
-    
-    virtual llvm::Type* VisitPrimaryType(CPrimaryType*) = 0;
-    virtual llvm::Type* VisitPointerType(CPointerType*) = 0;
-    virtual llvm::Type* VisitArrayType(CArrayType*) = 0;
-    virtual llvm::Type* VisitRecordType(CRecordType*) = 0;
-    virtual llvm::Type* VisitFuncType(CFuncType*) = 0;
-};
-
 class CType {
  public:
     enum class TypeKind {
@@ -48,6 +43,11 @@ class CType {
     TypeKind kind_;
     size_t size_;
     size_t align_;
+    // Set only on the types interned by `TypeContext::GetQualifiedType`.
+    bool is_const_ { false };
+    bool is_restrict_ { false };
+
+    friend class TypeContext;
 
  public:
     CType(TypeKind kind, size_t size, size_t align)
@@ -55,8 +55,6 @@ class CType {
 
     virtual ~CType() {}
 
-    virtual llvm::Type* Accept(TypeVisitor* vis) = 0;
-
     TypeKind GetKind() const {
         return kind_;
     }
@@ -69,6 +67,14 @@ class CType {
         return align_;
     }
 
+    bool IsConst() const {
+        return is_const_;
+    }
+
+    bool IsRestrict() const {
+        return is_restrict_;
+    }
+
     static std::shared_ptr<CType> const kIntType;
     static std::shared_ptr<CType> const kVoidType;
 
@@ -83,10 +89,6 @@ class CPrimaryType : public CType {
     CPrimaryType(TypeKind kind, size_t size, size_t align)
         : CType(kind, size, align) {}
 
-    llvm::Type* Accept(TypeVisitor* vis) {
-        return vis->VisitPrimaryType(this);
-    }
-
     static bool classof(const CType* ctype) {
         return ctype->GetKind() == TypeKind::kInt;
     }
@@ -104,10 +106,6 @@ class CPointerType : public CType {
         return base_type_;
     }
 
-    llvm::Type* Accept(TypeVisitor* vis) {
-        return vis->VisitPointerType(this);
-    }
-
     static bool classof(const CType* ctype) {
         return ctype->GetKind() == TypeKind::kPointer;
     }
@@ -136,10 +134,6 @@ class CArrayType : public CType {
         size_ = element_count * element_type_->GetSize();
     }
 
-    llvm::Type* Accept(TypeVisitor* vis) {
-        return vis->VisitArrayType(this);
-    }
-
     static bool classof(const CType* ctype) {
         return ctype->GetKind() == TypeKind::kArray;
     }
@@ -154,16 +148,22 @@ class CRecordType : public CType {
         size_t offset;
         // Which member it is in the structure.
         int rank;
+        // The index of the member in the lowered LLVM struct type.
+        // A union is lowered to its largest member,
+        // so all the members of a union share the index 0.
+        unsigned gep_index;
 
         Member() {}
 
         Member(std::shared_ptr<CType> type, llvm::StringRef name)
-            : type(type), name(name), offset(0), rank(0) {}
+            : type(type), name(name), offset(0), rank(0), gep_index(0) {}
     };
 
  private:
     llvm::StringRef name_;
     std::vector<Member> members_;
+    // Map the name of each member to its rank, built once in `SetMembers`.
+    llvm::StringMap<int> member_index_;
     TagKind tag_kind_;
 
     int max_size_member_rank_;
@@ -185,6 +185,12 @@ class CRecordType : public CType {
 
     void SetMembers(std::vector<Member>&& members);
 
+    // Return `nullptr` if there isn't a member named `name`.
+    const Member* FindMember(llvm::StringRef name) const {
+        auto iter = member_index_.find(name);
+        return iter != member_index_.end() ? &members_[iter->second] : nullptr;
+    }
+
     int GetMaxSizeMemberRank() const {
         return max_size_member_rank_;
     }
@@ -193,15 +199,25 @@ class CRecordType : public CType {
         return tag_kind_;
     }
 
-    llvm::Type* Accept(TypeVisitor* vis) {
-        return vis->VisitRecordType(this);
-    }
-
     static bool classof(const CType* ctype) {
         return ctype->GetKind() == TypeKind::kRecord;
     }
 };
 
+// The GNU attributes of a function, e.g. `__attribute__((noinline))`.
+enum class FuncAttr {
+    kAlwaysInline,
+    kNoInline,
+    kHot,
+    kCold,
+    kPure,
+    kConst,
+    kNoReturn,
+    kFlatten,
+    kOptNone,
+    kCount,
+};
+
 class CFuncType : public CType {
  public:
     struct Param {
@@ -219,6 +235,9 @@ class CFuncType : public CType {
 
  public:
     bool has_body_ { false };
+    // A bit set of `FuncAttr`. It accumulates over the declarations of
+    // the function, see `Sema::SemaFuncDecl`.
+    uint32_t attrs_ { 0 };
 
     CFuncType(llvm::StringRef func_name, std::shared_ptr<CType> ret_type, std::vector<Param>&& params)
         : CType(TypeKind::kFunc, 1, 1), func_name_(func_name), ret_type_(ret_type), params_(std::move(params)) {}
@@ -235,13 +254,89 @@ class CFuncType : public CType {
         return func_name_;
     }
 
-    llvm::Type* Accept(TypeVisitor* vis) override {
-        return vis->VisitFuncType(this);
+    bool HasAttr(FuncAttr attr) const {
+        return attrs_ & (1u << static_cast<int>(attr));
+    }
+
+    void AddAttr(FuncAttr attr) {
+        attrs_ |= 1u << static_cast<int>(attr);
     }
 
+    // The spelling of `attr` in the source, e.g. `always_inline`.
+    static llvm::StringRef GetAttrName(FuncAttr attr);
+
     static bool classof(const CType* ctype) {
         return ctype->GetKind() == TypeKind::kFunc;
     }
 };
 
+// Create the derived types of a compilation, and intern them,
+// i.e. all the `int*` share one `CPointerType` object, so that
+// two types can be compared and used as a map key by pointer.
+//
+// NOTE:
+// An array of unknown size, like `int ar[] = { 1, 2, 3 }`, isn't interned,
+// since its element count will be filled in by its own initializer.
+class TypeContext {
+ private:
+    llvm::DenseMap<CType*, std::shared_ptr<CType>> pointer_types_;
+    llvm::DenseMap<std::pair<CType*, int>, std::shared_ptr<CType>> array_types_;
+    // Map an unqualified type and its qualifiers, i.e. `is_const | is_restrict << 1`,
+    // to the qualified type.
+    llvm::DenseMap<std::pair<CType*, unsigned>, std::shared_ptr<CType>> qualified_types_;
+    // Function types are grouped by function name,
+    // there are only a few of them with the same name.
+    llvm::StringMap<std::vector<std::shared_ptr<CType>>> func_types_;
+
+ public:
+    std::shared_ptr<CType> GetPointerType(std::shared_ptr<CType> base_type);
+    std::shared_ptr<CType> GetArrayType(std::shared_ptr<CType> element_type, int element_count);
+    // Only a scalar type, i.e. `int`, `void` or a pointer, can be const,
+    // and only a pointer can be restrict. A qualified one is a distinct type,
+    // e.g. `int*`, `const int*` and `int* restrict` are different pointer types.
+    std::shared_ptr<CType> GetQualifiedType(std::shared_ptr<CType> type, bool is_const, bool is_restrict);
+    // Add a qualifier to `type`, and keep the others of it.
+    std::shared_ptr<CType> GetConstType(std::shared_ptr<CType> type) {
+        return GetQualifiedType(type, true, type->IsRestrict());
+    }
+    std::shared_ptr<CType> GetRestrictType(std::shared_ptr<CType> type) {
+        return GetQualifiedType(type, type->IsConst(), true);
+    }
+    std::shared_ptr<CType> GetFuncType(llvm::StringRef func_name,
+                                       std::shared_ptr<CType> ret_type,
+                                       std::vector<CFuncType::Param>&& params);
+};
+
+// A visitor which dispatches on `CType::TypeKind` with a switch,
+// the counterpart of `StaticVisitor` for types.
+template <typename Derived, typename RetTy = llvm::Type*>
+class StaticTypeVisitor {
+ public:
+    RetTy VisitType(CType* ctype) {
+        switch (ctype->GetKind()) {
+            case CType::TypeKind::kInt:
+            case CType::TypeKind::kVoid:
+                return GetDerived()->VisitPrimaryType(static_cast<CPrimaryType*>(ctype));
+            case CType::TypeKind::kPointer:
+                return GetDerived()->VisitPointerType(static_cast<CPointerType*>(ctype));
+            case CType::TypeKind::kArray:
+                return GetDerived()->VisitArrayType(static_cast<CArrayType*>(ctype));
+            case CType::TypeKind::kRecord:
+                return GetDerived()->VisitRecordType(static_cast<CRecordType*>(ctype));
+            case CType::TypeKind::kFunc:
+                return GetDerived()->VisitFuncType(static_cast<CFuncType*>(ctype));
+        }
+        llvm_unreachable("unknown kind of type");
+    }
+
+    RetTy VisitType(const std::shared_ptr<CType>& ctype) {
+        return VisitType(ctype.get());
+    }
+
+ private:
+    Derived* GetDerived() {
+        return static_cast<Derived*>(this);
+    }
+};
+
 #endif  // TYPE_H_
@@ -2,57 +2,109 @@
 
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/TargetSelect.h"
 #include "lexer.h"
 #include "parser.h"
 #include "codegen.h"
+#include "module-file.h"
 
 #include <stdarg.h>
+#include <cstddef>
 #include <functional>
+#include <tuple>
 
-bool TestProgramUseJit(llvm::StringRef content, int expectValue) {
+void ExpectMainReturns(std::unique_ptr<llvm::Module>& module, int expectValue) {
     llvm::InitializeNativeTarget();
     llvm::InitializeNativeTargetAsmPrinter();
     LLVMLinkInMCJIT();
 
-    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buf = llvm::MemoryBuffer::getMemBuffer(content, "stdin");
-     if (!buf) {
-        llvm::errs() << "open file failed!!!\n";
-        return false;
+    EXPECT_FALSE(llvm::verifyModule(*module));
+    llvm::EngineBuilder builder(std::move(module));
+    std::string error;
+    auto ptr = std::make_unique<llvm::SectionMemoryManager>();
+    auto ref = ptr.get();
+    std::unique_ptr<llvm::ExecutionEngine> ee(
+        builder.setErrorStr(&error)
+                .setEngineKind(llvm::EngineKind::JIT)
+                .setOptLevel(llvm::CodeGenOpt::None)
+                .setSymbolResolver(std::move(ptr))
+                .create());
+    ref->finalizeMemory(&error);
+
+    void *addr = (void *)ee->getFunctionAddress("main");
+    int res = ((int (*)())addr)();
+    if (res != expectValue) {
+        llvm::errs() << "expected: " << expectValue << ", but got " << res << "\n";
     }
+    EXPECT_EQ(res, expectValue);
+}
+
+// Build the module of `content`, which is owned by the returned `CodeGen`
+// together with its LLVM context.
+std::unique_ptr<CodeGen> BuildModule(llvm::StringRef content, bool build_ssa = false) {
     llvm::SourceMgr mgr;
     DiagEngine diagEngine(mgr);
-    mgr.AddNewSourceBuffer(std::move(*buf), llvm::SMLoc());
+    mgr.AddNewSourceBuffer(llvm::MemoryBuffer::getMemBuffer(content, "stdin"), llvm::SMLoc());
 
     Lexer lex(mgr, diagEngine);
     Sema sema(diagEngine);
     Parser parser(lex, sema);
+    return std::make_unique<CodeGen>(parser.ParseProgram(), build_ssa);
+}
 
-    auto program = parser.ParseProgram(); 
-    CodeGen codegen(program);
-    auto &module = codegen.GetModule();
-    EXPECT_FALSE(llvm::verifyModule(*module));
+bool TestProgramUseJit(llvm::StringRef content, int expectValue, bool build_ssa = false) {
+    auto codegen = BuildModule(content, build_ssa);
+    ExpectMainReturns(codegen->GetModule(), expectValue);
+    return true;
+}
+
+// Precompile `module_content` into a module, then import it into `content`.
+bool TestProgramWithModuleUseJit(llvm::StringRef module_content, llvm::StringRef content, int expectValue) {
+    // 1. Save the module into memory.
+    std::string module_data;
     {
-        llvm::EngineBuilder builder(std::move(module));
-        std::string error;
-        auto ptr = std::make_unique<llvm::SectionMemoryManager>();
-        auto ref = ptr.get();
-        std::unique_ptr<llvm::ExecutionEngine> ee(
-            builder.setErrorStr(&error)
-                    .setEngineKind(llvm::EngineKind::JIT)
-                    .setOptLevel(llvm::CodeGenOpt::None)
-                    .setSymbolResolver(std::move(ptr))
-                    .create());
-        ref->finalizeMemory(&error);
-
-        void *addr = (void *)ee->getFunctionAddress("main");
-        int res = ((int (*)())addr)();
-        if (res != expectValue) {
-            llvm::errs() << "expected: " << expectValue << ", but got " << res << "\n";
-        }
-        EXPECT_EQ(res, expectValue);
+        llvm::SourceMgr mgr;
+        DiagEngine diagEngine(mgr);
+        mgr.AddNewSourceBuffer(llvm::MemoryBuffer::getMemBuffer(module_content, "module"), llvm::SMLoc());
+
+        Lexer lex(mgr, diagEngine);
+        Sema sema(diagEngine);
+        Parser parser(lex, sema);
+        auto program = parser.ParseProgram();
+
+        llvm::raw_string_ostream out(module_data);
+        ModuleWriter writer(program, sema.GetScope());
+        writer.Write(out);
+    }
+
+    // 2. Load the module, the source of which has been released.
+    auto reader = std::make_unique<ModuleReader>(
+                        llvm::MemoryBuffer::getMemBuffer(module_data, "module", false));
+    EXPECT_TRUE(reader->IsValid());
+    if (!reader->IsValid()) {
+        return false;
     }
+
+    llvm::SourceMgr mgr;
+    DiagEngine diagEngine(mgr);
+    mgr.AddNewSourceBuffer(llvm::MemoryBuffer::getMemBuffer(content, "stdin"), llvm::SMLoc());
+
+    Lexer lex(mgr, diagEngine);
+    Sema sema(diagEngine);
+    reader->ImportSymbols(sema.GetScope(), sema.GetTypeContext());
+    Parser parser(lex, sema);
+    auto program = parser.ParseProgram();
+
+    auto imported_program = reader->LoadProgram();
+    program->nodes_.insert(program->nodes_.begin(),
+                           imported_program->nodes_.begin(),
+                           imported_program->nodes_.end());
+
+    CodeGen codegen(program);
+    ExpectMainReturns(codegen.GetModule(), expectValue);
     return true;
 }
 
@@ -122,6 +174,265 @@ TEST(CodeGenTest, three_op2) {
 }
 
 
+TEST(CodeGenTest, branch_cond) {
+    bool res = TestProgramUseJit(
+        "int f(int *p){*p=*p+1;return *p;}"
+        "int main(){int n=0;int a=3;int z=0;int r=0;"
+        "if(a<2&&f(&n))r+=1;if(a>2||f(&n))r+=10;if(!(a==3)||f(&n)>0)r+=100;"
+        "for(int i=0;i<10&&!(i==5);i++)r+=1000;if(z&&f(&n))r+=1;"
+        "r+=(a<4)+(a>=4)*2+(a&&n)*10000;r+=a?!z:7;return r+n*100000;}",
+        115112);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, unreachable_code) {
+    bool res = TestProgramUseJit(
+        "int f(int x){if(x>0){return 1;}else{return 2;}}"
+        "int g(int n){for(;;){if(n>3)break;n++;continue;n=100;}return n;}"
+        "int h(int n){for(int i=0;i<n;i++){return i+7;}return 0;}"
+        "int main(){int s=0;for(int i=5;i<3;i++)s+=1000;if(0){s+=500;}"
+        "return s+f(1)+f(-1)*10+g(0)*100+h(1)*1000+h(0)*10000;s=99;}",
+        7421);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, direct_ssa1) {
+    bool res = TestProgramUseJit(
+        "int fib(int n){int a=0;int b=1;for(int i=0;i<n;i++){int t=a+b;a=b;b=t;}return a;}"
+        "int main(){int s=0;int k;for(int i=0;i<10;i++){if(i==2)continue;if(i==8)break;"
+        "k=i&1?k+i:i;s+=k;}return fib(20)+s*10000;}",
+        376765, true);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, direct_ssa2) {
+    bool res = TestProgramUseJit(
+        "int f(int *p,int n){int s=0;int *r=p;for(;n>0;n--){s+=r[n-1];}return s;}"
+        "int main(){int a[4]={1,2,3,4};int x=5;int *q=&x;*q+=1;int y=x>5&&a[1]==2||0;"
+        "int z=0;for(int i=0;;i++){z=i?z*2:1;if(z>100)break;}"
+        "return f(a,4)+x*10+y*100+z*1000;}",
+        128170, true);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, switch1) {
+    bool res = TestProgramUseJit(
+        "int f(int x){int r=0;switch(x){case 1:r+=1;case 2:r+=10;break;case 3:{r+=100;break;}"
+        "default:r+=1000;case 5:r+=10000;}return r;}"
+        "int main(){return f(1)+f(2)*2+f(3)*3+f(4)*4+f(5)*5;}",
+        1*11 + 2*10 + 3*100 + 4*11000 + 5*10000);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, switch2) {
+    const char* content =
+        "int main(){int s=0;for(int i=0;i<6;i++){switch(i%3){case 0:continue;case 1:"
+        "switch(i){case 4:s+=100;break;default:s+=10;}break;}s+=1;}"
+        "switch(s){return 7;}switch(s)case 114:s+=1000;return s;}";
+    ASSERT_EQ(TestProgramUseJit(content, 1114), true);
+    ASSERT_EQ(TestProgramUseJit(content, 1114, true), true);
+}
+
+TEST(CodeGenTest, goto1) {
+    const char* content =
+        "int f(int x){int r=0;if(x>5)goto big;r=1;for(int i=0;i<x;i++){if(i==2)goto out;r+=10;}"
+        "r+=100;out:r+=1000;return r;big:{int y=x*2;r=y;}back:r++;if(r<20)goto back;return r;}"
+        "int g(int x){switch(x){case 1:goto in;default:return 5;}{int y=3;in:y=7;return y;}}"
+        "int main(){return f(1)+f(3)*10+f(8)*100+g(1)*10000+g(2)*100000;}";
+    ASSERT_EQ(TestProgramUseJit(content, 1111 + 10210 + 2000 + 70000 + 500000), true);
+    ASSERT_EQ(TestProgramUseJit(content, 1111 + 10210 + 2000 + 70000 + 500000, true), true);
+}
+
+TEST(CodeGenTest, computed_goto) {
+    const char* content =
+        "int run(int *code){void *tab[4]={&&op_inc,&&op_dbl,&&op_jnz,&&op_halt};"
+        "int acc=0;int pc=0;int n=3;goto *tab[code[pc]];"
+        "op_inc:acc=acc+1;pc++;goto *tab[code[pc]];"
+        "op_dbl:acc=acc*2;pc++;goto *tab[code[pc]];"
+        "op_jnz:n--;if(n)pc=0;else pc++;goto *tab[code[pc]];"
+        "op_halt:return acc;}"
+        "int main(){int code[4]={0,1,2,3};return run(code);}";
+    ASSERT_EQ(TestProgramUseJit(content, 14), true);
+    ASSERT_EQ(TestProgramUseJit(content, 14, true), true);
+}
+
+TEST(CodeGenTest, static_storage) {
+    const char* content =
+        "static int g=5;static int add(int a,int b);inline int twice(int x){return x*2;}"
+        "int counter(){static int n=10;n+=1;return n;}"
+        "int other(){static int n=1;return n++;}"
+        "static int add(int a,int b){static int calls;calls++;return a+b+calls*100;}"
+        "int main(){counter();counter();return add(g,twice(counter()))+other()+other();}";
+    ASSERT_EQ(TestProgramUseJit(content, 134), true);
+    ASSERT_EQ(TestProgramUseJit(content, 134, true), true);
+}
+
+TEST(CodeGenTest, static_linkage) {
+    auto codegen = BuildModule(
+        "static int g;int h;static int f();int f(){static int n;return n+g;}"
+        "inline int i(){return 1;}static inline int j(){return 2;}int k(){return 3;}"
+        "static int main(){return f()+i()+j()+k();}");
+    auto& module = codegen->GetModule();
+
+    EXPECT_EQ(module->getGlobalVariable("g", true)->getLinkage(), llvm::GlobalValue::InternalLinkage);
+    EXPECT_EQ(module->getGlobalVariable("h")->getLinkage(), llvm::GlobalValue::ExternalLinkage);
+    EXPECT_EQ(module->getGlobalVariable("f.n", true)->getLinkage(), llvm::GlobalValue::InternalLinkage);
+    // A function keeps the storage class of its first declaration.
+    EXPECT_EQ(module->getFunction("f")->getLinkage(), llvm::GlobalValue::InternalLinkage);
+    EXPECT_EQ(module->getFunction("i")->getLinkage(), llvm::GlobalValue::LinkOnceODRLinkage);
+    EXPECT_TRUE(module->getFunction("i")->hasFnAttribute(llvm::Attribute::InlineHint));
+    EXPECT_EQ(module->getFunction("j")->getLinkage(), llvm::GlobalValue::InternalLinkage);
+    EXPECT_EQ(module->getFunction("k")->getLinkage(), llvm::GlobalValue::ExternalLinkage);
+    // `main` is always exported.
+    EXPECT_EQ(module->getFunction("main")->getLinkage(), llvm::GlobalValue::ExternalLinkage);
+    ExpectMainReturns(module, 6);
+}
+
+TEST(CodeGenTest, const_pointer) {
+    // Adding `const` to the pointed-to type is allowed everywhere.
+    bool res = TestProgramUseJit(
+        "const int t[2]={4,5};const int *g(){return t;}int f(const int *p){return *p;}"
+        "int main(){const int *p=t;int x=3;const int *q;q=&x;int *r=&x;return f(p)+f(q)+*g()+f(t)+*r;}",
+        18);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, const_table) {
+    auto codegen = BuildModule(
+        "const int tab[2][3]={{1,2,3},{4,5,6}};const int k=1;int g=7;int h=tab[1][2];"
+        "int f(int i){return tab[k][i];}"
+        "int main(){const int *p=&tab[0][1];return tab[k][2]*100+h*10+f(0)+*p+g;}", true);
+    auto& module = codegen->GetModule();
+
+    EXPECT_TRUE(module->getGlobalVariable("tab")->isConstant());
+    EXPECT_TRUE(module->getGlobalVariable("k")->isConstant());
+    EXPECT_FALSE(module->getGlobalVariable("g")->isConstant());
+    // The loads at constant addresses are folded, including `*p` since `p`
+    // is an SSA value. So `main` only loads `h` and `g`, and `f` loads `tab[1][i]`.
+    auto count_loads = [](llvm::Function* func) {
+        int count = 0;
+        for (auto& inst : llvm::instructions(func)) {
+            count += llvm::isa<llvm::LoadInst>(inst);
+        }
+        return count;
+    };
+    EXPECT_EQ(count_loads(module->getFunction("main")), 2);
+    EXPECT_EQ(count_loads(module->getFunction("f")), 1);
+    ExpectMainReturns(module, 600 + 60 + 4 + 2 + 7);
+}
+
+TEST(CodeGenTest, tbaa) {
+    auto codegen = BuildModule(
+        "struct B{int y;int *q;};struct A{int x;struct B b;};union U{int i;int *p;};"
+        "int f(struct A *a){return a->b.y;}"
+        "int g(int **p){return **p;}"
+        "int h(union U *u){return u->i;}"
+        "int main(){int n=5;struct A a;union U u;int *p=&n;a.b.y=3;u.i=4;return f(&a)*100+g(&p)*10+h(&u);}", true);
+    auto& module = codegen->GetModule();
+
+    // Return the (base type, access type, offset) of the tag of each load.
+    auto get_load_tags = [](llvm::Function* func) {
+        std::vector<std::tuple<std::string, std::string, uint64_t>> tags;
+        for (auto& inst : llvm::instructions(func)) {
+            if (!llvm::isa<llvm::LoadInst>(inst)) {
+                continue;
+            }
+            auto tag = inst.getMetadata(llvm::LLVMContext::MD_tbaa);
+            EXPECT_NE(tag, nullptr);
+            auto get_name = [&](unsigned i) {
+                auto type_node = llvm::cast<llvm::MDNode>(tag->getOperand(i));
+                return llvm::cast<llvm::MDString>(type_node->getOperand(0))->getString().str();
+            };
+            auto offset = llvm::mdconst::extract<llvm::ConstantInt>(tag->getOperand(2))->getZExtValue();
+            tags.push_back({ get_name(0), get_name(1), offset });
+        }
+        return tags;
+    };
+    using Tag = std::tuple<std::string, std::string, uint64_t>;
+    EXPECT_EQ(get_load_tags(module->getFunction("f")), (std::vector<Tag>{ { "struct A", "int", 8 } }));
+    EXPECT_EQ(get_load_tags(module->getFunction("g")),
+              (std::vector<Tag>{ { "int*", "int*", 0 }, { "int", "int", 0 } }));
+    // The members of a union may be accessed through each other.
+    EXPECT_EQ(get_load_tags(module->getFunction("h")),
+              (std::vector<Tag>{ { "omnipotent char", "omnipotent char", 0 } }));
+    ExpectMainReturns(module, 354);
+}
+
+TEST(CodeGenTest, restrict_pointer) {
+    auto codegen = BuildModule(
+        "int f(int a[static restrict 3],int *restrict b,int *c){int *restrict d=c;int *restrict e=b;"
+        "a[2]=*b;d[1]=a[2];return e[0];}"
+        "int g(int *restrict a,int *restrict b);int g(int *a,int *b){*a=1;*b=2;return *a;}"
+        "int main(){int x[3]={1,2,3};int y=4;int z[2]={0,0};int n=0;return g(&n,&n)*100+f(x,&y,z)*10+z[1];}", true);
+    auto& module = codegen->GetModule();
+
+    auto func = module->getFunction("f");
+    EXPECT_TRUE(func->hasParamAttribute(0, llvm::Attribute::NoAlias));
+    EXPECT_TRUE(func->hasParamAttribute(0, llvm::Attribute::NonNull));
+    EXPECT_EQ(func->getParamDereferenceableBytes(0), 12);
+    EXPECT_TRUE(func->hasParamAttribute(1, llvm::Attribute::NoAlias));
+    EXPECT_FALSE(func->hasParamAttribute(2, llvm::Attribute::NoAlias));
+    // Only the definition decides the attributes of the parameters.
+    EXPECT_FALSE(module->getFunction("g")->hasParamAttribute(0, llvm::Attribute::NoAlias));
+    EXPECT_FALSE(module->getFunction("g")->hasParamAttribute(1, llvm::Attribute::NoAlias));
+
+    // `a`, `b` and `d` have their own scopes. `e` is copied from `b`,
+    // so the accesses through it may alias the others.
+    int scoped_count = 0, unscoped_count = 0;
+    for (auto& inst : llvm::instructions(func)) {
+        if (!llvm::isa<llvm::LoadInst>(inst) && !llvm::isa<llvm::StoreInst>(inst)) {
+            continue;
+        }
+        if (inst.getMetadata(llvm::LLVMContext::MD_alias_scope)) {
+            EXPECT_EQ(inst.getMetadata(llvm::LLVMContext::MD_noalias)->getNumOperands(), 2);
+            ++scoped_count;
+        } else {
+            EXPECT_EQ(inst.getMetadata(llvm::LLVMContext::MD_noalias), nullptr);
+            ++unscoped_count;
+        }
+    }
+    EXPECT_EQ(scoped_count, 4);
+    EXPECT_EQ(unscoped_count, 1);
+    ExpectMainReturns(module, 244);
+}
+
+TEST(CodeGenTest, func_attribute) {
+    auto codegen = BuildModule(
+        "__attribute__((always_inline)) static int sq(int x){return x*x;}"
+        "__attribute__((noinline, hot)) int add(int a,int b);"
+        "int add(int x,int y) __attribute__((pure)){return x+y;}"
+        "__attribute__((cold, noreturn)) void die();"
+        "__attribute__((flatten)) int all(int x){return sq(x)+add(x,1);}"
+        "__attribute__((const, optnone)) int id(int x){return x;}"
+        "int main(){if (id(0)) die();return all(3);}", true);
+    auto& module = codegen->GetModule();
+
+    EXPECT_TRUE(module->getFunction("sq")->hasFnAttribute(llvm::Attribute::AlwaysInline));
+    auto add = module->getFunction("add");
+    EXPECT_TRUE(add->hasFnAttribute(llvm::Attribute::NoInline));
+    EXPECT_TRUE(add->hasFnAttribute(llvm::Attribute::Hot));
+    EXPECT_TRUE(add->onlyReadsMemory() && add->willReturn() && add->doesNotThrow());
+    auto die = module->getFunction("die");
+    EXPECT_TRUE(die->hasFnAttribute(llvm::Attribute::Cold));
+    EXPECT_TRUE(die->doesNotReturn());
+    auto id = module->getFunction("id");
+    EXPECT_TRUE(id->doesNotAccessMemory());
+    EXPECT_TRUE(id->hasFnAttribute(llvm::Attribute::OptimizeNone));
+    EXPECT_TRUE(id->hasFnAttribute(llvm::Attribute::NoInline));
+
+    // In a flatten function, the calls are inlined unless the callee is `noinline`.
+    int call_count = 0;
+    for (auto& inst : llvm::instructions(module->getFunction("all"))) {
+        if (auto call = llvm::dyn_cast<llvm::CallInst>(&inst)) {
+            EXPECT_EQ(call->getAttributes().hasFnAttr(llvm::Attribute::AlwaysInline),
+                      call->getCalledFunction()->getName() == "sq");
+            ++call_count;
+        }
+    }
+    EXPECT_EQ(call_count, 2);
+    ExpectMainReturns(module, 13);
+}
+
 TEST(CodeGenTest, sizeof_int) {
     bool res = TestProgramUseJit("int main(){int a = 10; return sizeof(int);}", 4);
     ASSERT_EQ(res, true);
@@ -207,6 +518,16 @@ TEST(CodeGenTest, array_subscript2) {
     ASSERT_EQ(res, true);
 }
 
+TEST(CodeGenTest, array_subscript3) {
+    bool res = TestProgramUseJit(
+        "struct S{int x;union{int y;int z[2];} u;int m[2][3];};"
+        "int main(){struct S s[2][2];struct S *p=&s[1][0];int a[2][3][4];int *q=&a[1][2][0];"
+        "a[1][2][3]=3;s[1][0].m[1][2]=10;p->u.z[1]=20;p[1].m[0][1]=30;"
+        "return a[1][2][3]+q[3]+s[1][0].m[1][2]+s[1][0].u.z[1]+s[1][1].m[0][1];}",
+        66);
+    ASSERT_EQ(res, true);
+}
+
 TEST(CodeGenTest, array_init1) {
     bool res = TestProgramUseJit("int main(){int a[3] = {1,101}; return a[1];}", 101);
     ASSERT_EQ(res, true);
@@ -222,6 +543,34 @@ TEST(CodeGenTest, array_init3) {
     ASSERT_EQ(res, true);
 }
 
+TEST(CodeGenTest, array_init4) {
+    bool res = TestProgramUseJit(
+        "int f(){int a[8];int i;for(i=0;i<8;++i)a[i]=7;return a[7];}"
+        "int g(){int b[8]={1};return b[7];}"
+        "int main(){return f()*10+g();}",
+        70);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, global_init1) {
+    bool res = TestProgramUseJit(
+        "int t[3][4]={{1,2},{0},{5,6,7,8}};int z[100];"
+        "struct S{int a;int *p;int b[3];} s={1,0,{4,5}};"
+        "int main(){return t[0][1]+t[2][3]+t[1][0]+z[99]+s.a+s.b[0]+s.b[1]+s.b[2];}",
+        20);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, array_init5) {
+    bool res = TestProgramUseJit(
+        "int main(){int x=3;"
+        "int a[4][5]={{1,2,3,4,5},{6,7,8,9,10},{11,12,13,14,15},{16,17,18,19,20}};"
+        "int b[4][5]={{1,2,3,4,5},{6,7,8,9,10},{11,12,13,14,15},{16,17,18,19,x}};"
+        "a[0][0]=100;return a[0][0]+a[3][4]+a[2][1]+b[0][0]+b[3][4];}",
+        136);
+    ASSERT_EQ(res, true);
+}
+
 /// 
 
 TEST(CodeGenTest, struct_1) {
@@ -234,6 +583,62 @@ TEST(CodeGenTest, struct_2) {
     ASSERT_EQ(res, true);
 }
 
+TEST(CodeGenTest, struct_3) {
+    bool res = TestProgramUseJit(
+        "struct A{int x;struct A *next;};"
+        "int f(){struct A{int y;int z;} a;a.z=5;return a.z;}"
+        "int main(){struct A a,b;a.next=&b;b.x=2;return a.next->x+f();}",
+        7);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, struct_4) {
+    bool res = TestProgramUseJit(
+        "struct A{int a;int *b;int c[3];int d;union{int e;int *f;} u;int g;};"
+        "int main(){struct A s;struct A *p=&s;s.a=1;p->c[2]=10;s.d=100;"
+        "p->u.e=1000;s.g=10000;return p->a+s.c[2]+p->d+s.u.e+p->g;}",
+        11111);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, struct_5) {
+    bool res = TestProgramUseJit(
+        "struct P{int x;int y[2];};struct Q{struct P p[3];struct Q *self;};"
+        "int main(){struct Q q;struct Q r;struct P t;q.self=&q;"
+        "q.self->p[2].y[1]=5;q.p[0].x=2;r=q;t=r.p[2];r.p[2].y[1]=100;"
+        "struct P u=t;return u.y[1]*10+r.self->p[0].x+(1?t:u).y[1];}",
+        57);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, scope_shadow) {
+    bool res = TestProgramUseJit(
+        "int a=100;struct S{int x;};"
+        "int main(){int b=a;{struct S{int y;int z;} s;s.z=5;b+=s.z;}struct S t;t.x=1;return b+t.x;}",
+        106);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, scope_shadow_2) {
+    bool res = TestProgramUseJit(
+        "int a=100;"
+        "int f(int a){{int a=7;return a;}}"
+        "int main(){int b=a;int a=1;{int a=2;{int a=3;b+=a;}b+=a;}return b+a+f(0)-7;}",
+        106);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, scope_lifetime) {
+    bool res = TestProgramUseJit(
+        "int f(int n){int s=0;for(int i=0;i<n;i++){int a[8]={1,2,3};if(i==3){continue;}"
+        "{int b[8];b[0]=i;s+=a[2]+b[0];}"
+        "if(i==5){int c[4]={9};for(int j=0;j<4;j++){int d[2]={j};if(j==2)break;s+=d[0]+c[0];}}"
+        "if(i==6){int e[4]={40};return s+e[0];}}return s;}"
+        "int main(){return f(10)+f(2);}",
+        102);
+    ASSERT_EQ(res, true);
+}
+
 TEST(CodeGenTest, union_1) {
     bool res = TestProgramUseJit("int main(){struct {int *p; int a,b; union{int a;int b;} c;} a; a.c.b = 1024; a.c.a = 22; a.p = &a.c.b; a.c.b += 111; return *a.p;}", 133);
     ASSERT_EQ(res, true);
@@ -259,6 +664,31 @@ TEST(CodeGenTest, struct_init4) {
     ASSERT_EQ(res, true);
 }
 
+TEST(CodeGenTest, struct_init5) {
+    bool res = TestProgramUseJit(
+        "struct A{int x;int y;};"
+        "int main(){struct A a;a.x=3;a.y=4;struct A arr[2] = {a, a}; return arr[1].y + arr[0].x;}", 7);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, struct_init6) {
+    bool res = TestProgramUseJit(
+        "struct A{int x;int y;};struct B{struct A a;int z;};"
+        "int main(){struct A a;a.x=3;a.y=4;struct B b = {a, 5}; return b.a.x * 100 + b.a.y * 10 + b.z;}", 345);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, struct_init7) {
+    // The rest of `arr` is zeroed, and the records are copied even if there
+    // are more values than the ones stored one by one.
+    bool res = TestProgramUseJit(
+        "struct A{int x;int y;};"
+        "int main(){struct A a;a.x=3;a.y=4;"
+        "struct A arr[20] = {a,a,a,a,a,a,a,a,a,a,a,a,a,a,a,a,a};"
+        "return arr[16].x * 100 + arr[0].y * 10 + arr[17].y + arr[19].x;}", 340);
+    ASSERT_EQ(res, true);
+}
+
 TEST(CodeGenTest, union_init1) {
     bool res = TestProgramUseJit("int main(){union {int a,b;} a = {1}; return a.a;}", 1);
     ASSERT_EQ(res, true);
@@ -427,3 +857,105 @@ int main() {
     )", 840);
     ASSERT_EQ(res, true);
 }
+
+TEST(CodeGenTest, const_expr) {
+    bool res = TestProgramUseJit(
+        "int g[2*3+1]={1,2,3,4-1*2};int h=(1<<4)|3;int *p=0;"
+        "int main(){int a[sizeof(int)*2];return sizeof a+sizeof g+h+g[3]+(1?2:3)-7/2+(-5%3);}",
+        78);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, module_import) {
+    bool res = TestProgramWithModuleUseJit(
+        "struct Node{int value;struct Node *next;};"
+        "int g[3]={1,2,3};"
+        "int sum(struct Node *p){int s=0;for(;p;p=p->next){s+=p->value;}return s;}"
+        "int count(int n){int i;int c=0;for(i=0;;i++){if(i>=n)break;if(i%2)continue;c++;}return c;}",
+        "int main(){struct Node a,b;a.value=g[1];a.next=&b;b.value=40;b.next=0;return sum(&a)+count(5);}",
+        45);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, module_static) {
+    bool res = TestProgramWithModuleUseJit(
+        "static int base=40;static inline int f(int x){static int n;n+=x;return n+base;}"
+        "int main(){f(1);return f(1);}",
+        "",
+        42);
+    ASSERT_EQ(res, true);
+}
+
+TEST(CodeGenTest, module_invalid) {
+    std::string module_data;
+    {
+        llvm::SourceMgr mgr;
+        DiagEngine diagEngine(mgr);
+        mgr.AddNewSourceBuffer(
+            llvm::MemoryBuffer::getMemBuffer("int f(int *p){return *p;}", "module"), llvm::SMLoc());
+
+        Lexer lex(mgr, diagEngine);
+        Sema sema(diagEngine);
+        Parser parser(lex, sema);
+        llvm::raw_string_ostream out(module_data);
+        ModuleWriter(parser.ParseProgram(), sema.GetScope()).Write(out);
+    }
+    auto is_valid = [&](size_t pos, uint32_t value) {
+        std::string data = module_data;
+        llvm::support::endian::write32le(&data[pos], value);
+        return ModuleReader(llvm::MemoryBuffer::getMemBuffer(data, "module", false)).IsValid();
+    };
+    auto get = [&](size_t pos) {
+        return llvm::support::endian::read32le(&module_data[pos]);
+    };
+
+    // The header fields are 32-bit, so the struct has the layout of the file.
+    EXPECT_TRUE(is_valid(offsetof(module_file::Header, version), module_file::kVersion));
+    EXPECT_FALSE(is_valid(offsetof(module_file::Header, type_data_offset), 0x7ffffff0));
+    EXPECT_FALSE(is_valid(offsetof(module_file::Header, node_data_offset), 0x7ffffff0));
+    EXPECT_FALSE(is_valid(offsetof(module_file::Header, node_data_size), 0x7ffffff0));
+    EXPECT_FALSE(is_valid(offsetof(module_file::Header, file_name_size), 0x7ffffff0));
+    // The offsets of the first type and the first node.
+    EXPECT_FALSE(is_valid(get(offsetof(module_file::Header, type_index_offset)), 0x7ffffff0));
+    EXPECT_FALSE(is_valid(get(offsetof(module_file::Header, node_index_offset)),
+                          get(offsetof(module_file::Header, node_data_size))));
+
+    // A record referring to itself is only found when it's decoded, which is
+    // a fatal error. Each record starts with its kind, then the first field of
+    // a pointer type is its base type, and the one of a `return` is its value.
+    auto find_record = [&](size_t count_field, size_t index_field, size_t data_field, uint32_t kind) {
+        for (uint32_t id = 0; id < get(count_field); ++id) {
+            uint32_t pos = get(data_field) + get(get(index_field) + id * 4);
+            if ((get(pos) & 0xff) == kind) {
+                return std::make_pair(id, pos);
+            }
+        }
+        ADD_FAILURE() << "no record of kind " << kind;
+        return std::make_pair(0u, 0u);
+    };
+    auto load = [&](size_t pos, uint32_t value) {
+        std::string data = module_data;
+        llvm::support::endian::write32le(&data[pos], value);
+        return std::make_unique<ModuleReader>(llvm::MemoryBuffer::getMemBuffer(data, "module", false));
+    };
+
+    auto [type_id, type_pos] = find_record(offsetof(module_file::Header, type_count),
+                                           offsetof(module_file::Header, type_index_offset),
+                                           offsetof(module_file::Header, type_data_offset),
+                                           static_cast<uint32_t>(CType::TypeKind::kPointer));
+    EXPECT_DEATH(load(type_pos + 4, type_id)->GetType(type_id), "type refers to itself");
+
+    auto [node_id, node_pos] = find_record(offsetof(module_file::Header, node_count),
+                                           offsetof(module_file::Header, node_index_offset),
+                                           offsetof(module_file::Header, node_data_offset),
+                                           static_cast<uint32_t>(AstNode::AstNodeKind::kReturnStmt));
+    EXPECT_DEATH(load(node_pos + 16, node_id)->GetNode(node_id), "node is its own child");
+}
+
+TEST(CodeGenTest, module_only) {
+    bool res = TestProgramWithModuleUseJit(
+        "union U{int a;int b;};int f(union U u){return u.b*2;}int main(){union U u={21};return f(u);}",
+        "",
+        42);
+    ASSERT_EQ(res, true);
+}
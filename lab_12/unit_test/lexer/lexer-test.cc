@@ -63,6 +63,46 @@ TEST(LexerTest, keyword) {
     ASSERT_EQ(res, true);
 }
 
+TEST(LexerTest, switch_keyword) {
+    bool res = TestLexerWithContent("switch case default:", []()->std::vector<Token> {
+        std::vector<Token> expectedVec;
+        expectedVec.push_back(Token{TokenType::kSwitch, 1, 1});
+        expectedVec.push_back(Token{TokenType::kCase, 1, 8});
+        expectedVec.push_back(Token{TokenType::kDefault, 1, 13});
+        expectedVec.push_back(Token{TokenType::kColon, 1, 20});
+        return expectedVec;
+    });
+    ASSERT_EQ(res, true);
+}
+
+TEST(LexerTest, goto_keyword) {
+    bool res = TestLexerWithContent("goto *p; &&l", []()->std::vector<Token> {
+        std::vector<Token> expectedVec;
+        expectedVec.push_back(Token{TokenType::kGoto, 1, 1});
+        expectedVec.push_back(Token{TokenType::kStar, 1, 6});
+        expectedVec.push_back(Token{TokenType::kIdentifier, 1, 7});
+        expectedVec.push_back(Token{TokenType::kSemi, 1, 8});
+        expectedVec.push_back(Token{TokenType::kAmpAmp, 1, 10});
+        expectedVec.push_back(Token{TokenType::kIdentifier, 1, 12});
+        return expectedVec;
+    });
+    ASSERT_EQ(res, true);
+}
+
+TEST(LexerTest, storage_keyword) {
+    bool res = TestLexerWithContent("static inline const int restrict __attribute__", []()->std::vector<Token> {
+        std::vector<Token> expectedVec;
+        expectedVec.push_back(Token{TokenType::kStatic, 1, 1});
+        expectedVec.push_back(Token{TokenType::kInline, 1, 8});
+        expectedVec.push_back(Token{TokenType::kConst, 1, 15});
+        expectedVec.push_back(Token{TokenType::kInt, 1, 21});
+        expectedVec.push_back(Token{TokenType::kRestrict, 1, 25});
+        expectedVec.push_back(Token{TokenType::kAttribute, 1, 34});
+        return expectedVec;
+    });
+    ASSERT_EQ(res, true);
+}
+
 TEST(LexerTest, number) {
     bool res = TestLexerWithContent(" 0123 1234 1234222 \n0" , []()->std::vector<Token> {
         std::vector<Token> expectedVec;
@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include "flat-ast.h"
 #include "lexer.h"
 #include "parser.h"
 #include "print-visitor.h"
@@ -26,6 +27,13 @@ bool TestParserWithContent(llvm::StringRef content, llvm::StringRef expect) {
         llvm::outs() << "expect: " << expect << ", but got: " << s << "\n";
     }
     EXPECT_EQ(expect, s);
+
+    // The flat form of the AST should be printed in the same way.
+    std::string flat_s;
+    llvm::raw_string_ostream flat_ss(flat_s);
+    FlatAst flat_ast(program);
+    PrintVisitor flatPrintVisitor(flat_ast, &flat_ss);
+    EXPECT_EQ(s, flat_s);
     return true;
 }
 
@@ -221,6 +229,11 @@ TEST(ParserTest, sizeof_array3) {
 }
 
 
+TEST(ParserTest, array_const_size) {
+    bool res = TestParserWithContent("int main(){int a[2*3+1][sizeof(int)>2?4:-1];}", "int main(){[7][4]int a;}");
+    ASSERT_EQ(res, true);
+}
+
 TEST(ParserTest, post_arr_1) {
     bool res = TestParserWithContent("int main(){int a[3]; a[0] = 4;}", "int main(){[3]int a;a[0]=4;}");
     ASSERT_EQ(res, true);
@@ -230,3 +243,100 @@ TEST(ParserTest, arr_init1) {
     bool res = TestParserWithContent("int main(){int a[3]={1,2}; a[0] = 4;}", "int main(){[3]int a=1,2;a[0]=4;}");
     ASSERT_EQ(res, true);
 }
+
+TEST(ParserTest, flat_ast) {
+    bool res = TestParserWithContent(
+        "struct A{int x;int y;};int f(struct A *p){return p->x;}"
+        "int main(){struct A a;int i;for(i=0;i<3;i++){if(i==1)continue;else break;}a.y=i?f(&a):sizeof a;return 0;}",
+        "int f(struct A{int x;int y;} *p){return p->x;}"
+        "int main(){struct A{int x;int y;} a;int i;for(i=0;i<3;i++){if(i==1)continueelsebreak;};a.y=i?f(&a):sizeof a;return 0;}");
+    ASSERT_EQ(res, true);
+}
+
+TEST(ParserTest, self_ref_struct) {
+    bool res = TestParserWithContent(
+        "struct Node{int v;struct Node *next;};int main(){struct Node n;n.next=&n;return n.v;}",
+        "int main(){struct Node{int v;struct Node *next;} n;n.next=&n;return n.v;}");
+    ASSERT_EQ(res, true);
+}
+
+TEST(ParserTest, switch_stmt) {
+    bool res = TestParserWithContent(
+        "int main(){int x=2;switch(x){case 1+1:x=3;case 4:{break;}default:;}return x;}",
+        "int main(){int x=2;switch(x){case 1+1:x=3;case 4:{break;};default:;};return x;}");
+    ASSERT_EQ(res, true);
+}
+
+TEST(ParserTest, goto_stmt) {
+    bool res = TestParserWithContent(
+        "int main(){int x=0;goto l;m:x=1;l:{void *p=&&m;goto *p;}}",
+        "int main(){int x=0;goto l;m:x=1;l:{void *p=&&m;goto *p;};}");
+    ASSERT_EQ(res, true);
+}
+
+TEST(ParserTest, storage_class) {
+    bool res = TestParserWithContent(
+        "static int g=1;static int f(int x);inline int f(int x){static int n=2;return n+x;}"
+        "inline int h();int h(){return f(g);}",
+        "static int g=1static int f(int x);static inline int f(int x){static int n=2;return n+x;}"
+        "inline int h();inline int h(){return f(g);}");
+    ASSERT_EQ(res, true);
+}
+
+TEST(ParserTest, const_type) {
+    bool res = TestParserWithContent(
+        "const int a[2]={1,2};int const *p;int *const q=0;int main(){const int *const r=&a[1];return *r+sizeof(const int*);}",
+        "[2]const int a=1,2const int *pint *const q=0"
+        "int main(){const int *const r=&a[1];return *r+sizeof (const int *);}");
+    ASSERT_EQ(res, true);
+}
+
+TEST(ParserTest, restrict_type) {
+    bool res = TestParserWithContent(
+        "int *restrict p;int f(int a[static const restrict 3],int *const restrict q);",
+        "int *restrict pint f(int *const restrict a,int *const restrict q);");
+    ASSERT_EQ(res, true);
+}
+
+TEST(ParserTest, func_attribute) {
+    bool res = TestParserWithContent(
+        "__attribute__((cold)) static int f(int a) __attribute__((__noinline__, const));int f(int a);",
+        "static int f(int a) __attribute__((noinline,cold,const));static int f(int a) __attribute__((noinline,cold,const));");
+    ASSERT_EQ(res, true);
+}
+
+TEST(ParserTest, interned_types) {
+    llvm::SourceMgr mgr;
+    DiagEngine diagEngine(mgr);
+    mgr.AddNewSourceBuffer(
+        llvm::MemoryBuffer::getMemBuffer("int *a;int *b;int c[3][4];int d[3][4];int *e[3];int f[];", "stdin"),
+        llvm::SMLoc());
+
+    Lexer lex(mgr, diagEngine);
+    Sema sema(diagEngine);
+    Parser parser(lex, sema);
+    auto program = parser.ParseProgram();
+
+    // Each top-level node is a `DeclStmt` holding one `VariableDecl`.
+    auto get_type = [&](int i) {
+        return llvm::cast<DeclStmt>(program->nodes_[i])->nodes_[0]->GetCType().get();
+    };
+    EXPECT_EQ(get_type(0), get_type(1));
+    EXPECT_EQ(get_type(2), get_type(3));
+    EXPECT_NE(get_type(0), get_type(4));
+    EXPECT_EQ(get_type(0), llvm::cast<CArrayType>(get_type(4))->GetElementType().get());
+    EXPECT_EQ(sema.GetTypeContext().GetPointerType(CType::kIntType).get(), get_type(0));
+    // A const type is interned apart from the unqualified one.
+    auto& type_context = sema.GetTypeContext();
+    EXPECT_EQ(type_context.GetConstType(CType::kIntType), type_context.GetConstType(CType::kIntType));
+    EXPECT_NE(type_context.GetConstType(CType::kIntType), CType::kIntType);
+    EXPECT_TRUE(type_context.GetConstType(CType::kIntType)->IsConst());
+    // The qualifiers can be added in any order.
+    auto pointer_type = type_context.GetPointerType(CType::kIntType);
+    auto const_restrict_type = type_context.GetRestrictType(type_context.GetConstType(pointer_type));
+    EXPECT_EQ(const_restrict_type, type_context.GetConstType(type_context.GetRestrictType(pointer_type)));
+    EXPECT_TRUE(const_restrict_type->IsConst() && const_restrict_type->IsRestrict());
+    EXPECT_EQ(type_context.GetQualifiedType(const_restrict_type, false, false), pointer_type);
+    // An array of unknown size is completed by its own initializer.
+    EXPECT_NE(sema.GetTypeContext().GetArrayType(CType::kIntType, -1).get(), get_type(5));
+}